@@ -0,0 +1,296 @@
+'use strict';
+
+/**
+ * Benchmark: `getServiceStatus` throughput, latency, memory and event-loop
+ * delay over a matrix of unit counts × concurrent callers × backends.
+ *
+ *   npm run build && node dist/bench/matrix.bench.js [--units=10,100,1000,10000,50000]
+ *     [--callers=1,10,100,1000] [--backends=libsystemd,systemctl,openrc,sysv]
+ *     [--seconds=2] [--dbus-ms=0.15] [--systemctl-ms=4] [--fs-ms=1]
+ *
+ * Every backend runs against a local stand-in: a generated trace replayed
+ * through the library's own backend seam (`replayTrace`), so the whole
+ * request path — init detection, scheduler lanes, property parsing, state
+ * mapping — is exercised without a systemd, an OpenRC or root. Each backend
+ * operation answers after its modeled latency: a D-Bus `GetAll` round trip
+ * (`--dbus-ms`), a `systemctl show` fork+exec (`--systemctl-ms`) and a
+ * pidfile or `/proc` probe (`--fs-ms`). The first two block the event loop,
+ * as they do live. Probes answer on a timer, so they yield to the loop as a
+ * live probe does, but cannot be modeled below its 1 ms granularity. (With
+ * `--fs-ms=0` they settle as microtasks and the loop never turns.)
+ *
+ * The replay answers probes itself: the OpenRC and SysV cells measure the
+ * modeled `--fs-ms` latency plus the backend logic, never the batched probe
+ * engine or the filesystem. Their cost is what `probe.bench` measures.
+ *
+ * Each cell issues calls round-robin over its units from all callers for
+ * `--seconds`, and reports one table row; the full results follow as one
+ * JSON line. RSS is reported as the growth over a baseline taken once the
+ * cell's trace is loaded, so the trace itself is not counted. RSS is
+ * process-wide: run with `node --expose-gc` to collect the previous cell's
+ * garbage before the baseline is taken.
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { performance } from 'perf_hooks';
+import { getServiceStatus, statusProperties } from '../src/linux';
+import { replayTrace } from '../src/trace';
+import { Histogram } from '../src/histogram';
+
+type Backend = 'libsystemd' | 'systemctl' | 'openrc' | 'sysv';
+
+const BACKENDS: readonly Backend[] = ['libsystemd', 'systemctl', 'openrc', 'sysv'];
+
+interface Config {
+  units: number[];
+  callers: number[];
+  backends: Backend[];
+  seconds: number;
+  dbusMs: number;
+  systemctlMs: number;
+  fsMs: number;
+}
+
+function parseArgs(argv: readonly string[]): Config {
+  const flags = new Map<string, string>();
+  for (const arg of argv) {
+    const m = /^--([a-z-]+)=(.*)$/.exec(arg);
+    if (!m) throw new Error(`unknown argument ${arg}`);
+    flags.set(m[1], m[2]);
+  }
+  const list = (name: string, fallback: number[]) =>
+    flags.has(name) ? flags.get(name)!.split(',').map(v => Math.max(1, parseInt(v, 10) || 1)) : fallback;
+  const num = (name: string, fallback: number) =>
+    flags.has(name) ? Math.max(0, Number(flags.get(name)) || 0) : fallback;
+
+  const backends = (flags.get('backends')?.split(',') ?? [...BACKENDS]) as Backend[];
+  for (const b of backends) {
+    if (!BACKENDS.includes(b)) throw new Error(`unknown backend ${b}`);
+  }
+  return {
+    units:       list('units', [10, 100, 1000, 10_000, 50_000]),
+    callers:     list('callers', [1, 10, 100, 1000]),
+    backends,
+    seconds:     num('seconds', 2),
+    dbusMs:      num('dbus-ms', 0.15),
+    systemctlMs: num('systemctl-ms', 4),
+    fsMs:        num('fs-ms', 1)
+  };
+}
+
+// ─── Stand-ins ────────────────────────────────────────────────────────────────
+
+/** svc0…svcN-1; even ones run with pid 10000+i, odd ones are stopped. */
+const unitName = (i: number) => `svc${i}`;
+const unitPid  = (i: number) => (i % 2 === 0 ? 10_000 + i : 0);
+
+/** Trace events answering one status query of unit `i` on `backend`. */
+function unitEvents(backend: Backend, i: number, config: Config): object[] {
+  const name = unitName(i);
+  const pid = unitPid(i);
+  const probe = (op: 'fs.exists' | 'fs.read', p: string, result: unknown) => ({ t: 0, op, args: [p], ms: config.fsMs, result });
+  const pidfile = pid ? `${pid}\n` : null;
+
+  switch (backend) {
+    case 'libsystemd': {
+      const props = {
+        LoadState: 'loaded', ActiveState: pid ? 'active' : 'inactive', SubState: pid ? 'running' : 'dead',
+        FreezerState: 'running', MainPID: pid
+      };
+      return [{
+        t: 0, op: 'dbus.unit', args: [name], ms: config.dbusMs,
+        result: { loadState: props.LoadState, activeState: props.ActiveState, subState: props.SubState, mainPid: pid, type: 'service', props }
+      }];
+    }
+    case 'systemctl': {
+      const unit = `${name}.service`;
+      const output = `LoadState=loaded\nActiveState=${pid ? 'active' : 'inactive'}\n` +
+        `SubState=${pid ? 'running' : 'dead'}\nFreezerState=running\nMainPID=${pid}\n`;
+      return [{ t: 0, op: 'systemctl.show', args: [unit, statusProperties(unit)], ms: config.systemctlMs, result: output }];
+    }
+    case 'openrc':
+      return [
+        probe('fs.exists', `/etc/init.d/${name}`, true),
+        probe('fs.exists', `/etc/runlevels/default/${name}`, true),
+        probe('fs.exists', `/run/openrc/started/${name}`, pid > 0),
+        probe('fs.exists', `/run/openrc/starting/${name}`, false),
+        probe('fs.exists', `/run/openrc/stopping/${name}`, false),
+        probe('fs.read', `/run/${name}.pid`, pidfile),
+        probe('fs.read', `/var/run/${name}.pid`, null)
+      ];
+    case 'sysv':
+      return [
+        probe('fs.exists', `/etc/init.d/${name}`, true),
+        probe('fs.read', `/var/run/${name}.pid`, pidfile),
+        probe('fs.read', `/run/${name}.pid`, null),
+        probe('fs.exists', `/var/run/${name}.lock`, pid > 0),
+        probe('fs.exists', `/run/${name}.lock`, false),
+        ...(pid ? [probe('fs.exists', `/proc/${pid}`, true)] : [])
+      ];
+  }
+}
+
+/** Writes the stand-in trace of `units` units on `backend` to `file`. */
+function writeTrace(file: string, backend: Backend, units: number, config: Config): void {
+  const fd = fs.openSync(file, 'w');
+  try {
+    const init = backend === 'libsystemd' || backend === 'systemctl' ? 'systemd' : backend;
+    const lines = [
+      JSON.stringify({ trace: 'service_api', version: 1, start: Date.now() }),
+      JSON.stringify({ t: 0, op: 'init', args: [], ms: 0, result: init }),
+      JSON.stringify({ t: 0, op: 'libsystemd', args: [], ms: 0, result: backend === 'libsystemd' })
+    ];
+    for (let i = 0; i < units; i++) {
+      for (const ev of unitEvents(backend, i, config)) lines.push(JSON.stringify(ev));
+      if (lines.length >= 4096) {
+        fs.writeSync(fd, lines.join('\n') + '\n');
+        lines.length = 0;
+      }
+    }
+    fs.writeSync(fd, lines.join('\n') + '\n');
+  } finally {
+    fs.closeSync(fd);
+  }
+}
+
+// ─── Runner ───────────────────────────────────────────────────────────────────
+
+interface Cell {
+  backend: Backend;
+  units: number;
+  callers: number;
+  calls: number;
+  errors: number;
+  callsPerSec: number;
+  p50Ms: number;
+  p99Ms: number;
+  p999Ms: number;
+  maxMs: number;
+  /** RSS growth over the baseline at the end of the cell, and at its peak. */
+  rssDeltaMb: number;
+  peakRssDeltaMb: number;
+  loopP99Ms: number;
+  loopMaxMs: number;
+}
+
+const round = (v: number, digits = 3) => Math.round(v * 10 ** digits) / 10 ** digits;
+const mb = (bytes: number) => round(bytes / (1024 * 1024), 1);
+
+/**
+ * Runs `callers` concurrent loops of `getServiceStatus` round-robin over
+ * `units` units for `seconds`, recording per-call latency in µs. RSS is
+ * reported relative to `baselineRss`.
+ */
+async function runCell(
+  backend: Backend, units: number, callers: number, seconds: number, baselineRss: number
+): Promise<Cell> {
+  const latency = new Histogram();
+  // Event-loop delay: gaps between the ticks of a 1 ms interval, in µs.
+  const loop = new Histogram();
+  let lastTick = performance.now();
+  let peakRss = baselineRss;
+  const ticker = setInterval(() => {
+    const now = performance.now();
+    loop.record((now - lastTick) * 1000);
+    lastTick = now;
+    if (loop.count % 50 === 0) peakRss = Math.max(peakRss, process.memoryUsage().rss);
+  }, 1);
+  let next = 0;
+  let errors = 0;
+
+  const t0 = performance.now();
+  const deadline = t0 + seconds * 1000;
+  const caller = async () => {
+    while (performance.now() < deadline) {
+      const name = unitName(next++ % units);
+      const started = performance.now();
+      try {
+        await getServiceStatus(name);
+      } catch {
+        errors++;
+      }
+      latency.record((performance.now() - started) * 1000);
+    }
+  };
+  await Promise.all(Array.from({ length: callers }, caller));
+  const elapsed = performance.now() - t0;
+  // Callers whose awaits settle as microtasks starve timers: a block only
+  // shows up once the interval gets to run again.
+  await new Promise(resolve => setTimeout(resolve, 5));
+  clearInterval(ticker);
+
+  const rss = process.memoryUsage().rss;
+  const l = latency.snapshot();
+  return {
+    backend,
+    units,
+    callers,
+    calls:       l.count,
+    errors,
+    callsPerSec: Math.round(l.count / (elapsed / 1000)),
+    p50Ms:       round(l.p50 / 1000),
+    p99Ms:       round(l.p99 / 1000),
+    p999Ms:      round(l.p999 / 1000),
+    maxMs:       round(l.max / 1000),
+    rssDeltaMb:     mb(rss - baselineRss),
+    peakRssDeltaMb: mb(Math.max(peakRss, rss) - baselineRss),
+    loopP99Ms:   round(loop.percentile(99) / 1000),
+    loopMaxMs:   round(loop.snapshot().max / 1000)
+  };
+}
+
+async function main(): Promise<void> {
+  const config = parseArgs(process.argv.slice(2));
+  const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-matrix-'));
+  const cells: Cell[] = [];
+  try {
+    for (const backend of config.backends) {
+      for (const units of config.units) {
+        const file = path.join(dir, `${backend}-${units}.trace`);
+        writeTrace(file, backend, units, config);
+        for (const callers of config.callers) {
+          const session = replayTrace(file);
+          try {
+            // Baseline once the trace is loaded: only the calls' own memory counts.
+            (globalThis as { gc?: () => void }).gc?.();
+            const baselineRss = process.memoryUsage().rss;
+            cells.push(await runCell(backend, units, callers, config.seconds, baselineRss));
+          } finally {
+            await session.stop();
+          }
+          // Let pending timers drain so cells do not overlap.
+          await new Promise(resolve => setTimeout(resolve, 20));
+        }
+        fs.rmSync(file, { force: true });
+      }
+    }
+
+    console.table(cells);
+    const fsBackends = config.backends.filter(b => b === 'openrc' || b === 'sysv');
+    const notes = [
+      'RSS: growth over a baseline taken after each cell\'s trace was loaded.',
+      ...(fsBackends.length > 0
+        ? [`${fsBackends.join(', ')}: probes are answered by the replay after the modeled ${config.fsMs} ms; ` +
+           'the probe engine and the filesystem are not exercised (see probe.bench).']
+        : [])
+    ];
+    for (const note of notes) console.log(note);
+    console.log(JSON.stringify({
+      node: process.version,
+      cpus: os.cpus().length,
+      threadpool: process.env.UV_THREADPOOL_SIZE ?? '4',
+      config,
+      notes,
+      cells
+    }));
+  } finally {
+    fs.rmSync(dir, { recursive: true, force: true });
+  }
+}
+
+main().catch(err => {
+  console.error(err);
+  process.exit(1);
+});
@@ -0,0 +1,144 @@
+'use strict';
+
+/**
+ * Benchmark: synchronous probes (the original fsExistsSync/readPidFile path)
+ * vs. the batched ProbeEngine, on a fake tree of 10k init scripts.
+ *
+ *   npm run build && node dist/bench/probe.bench.js [count]
+ *
+ * Run with `UV_USE_IO_URING=1` to let libuv complete the engine's batches on
+ * io_uring instead of its threadpool.
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { performance } from 'perf_hooks';
+import { ProbeEngine } from '../src/probe';
+
+// ─── Fake tree ────────────────────────────────────────────────────────────────
+
+function buildTree(root: string, count: number): string[] {
+  const initd = path.join(root, 'etc/init.d');
+  const run   = path.join(root, 'run');
+  const proc  = path.join(root, 'proc');
+  fs.mkdirSync(initd, { recursive: true });
+  fs.mkdirSync(run, { recursive: true });
+  const names: string[] = [];
+  for (let i = 0; i < count; i++) {
+    const name = `svc${i}`;
+    const pid  = 10_000 + i;
+    names.push(name);
+    fs.writeFileSync(path.join(initd, name), '#!/bin/sh\n');
+    if (i % 2 === 0) {
+      fs.writeFileSync(path.join(run, `${name}.pid`), `${pid}\n`);
+      fs.mkdirSync(path.join(proc, String(pid)), { recursive: true });
+      fs.writeFileSync(path.join(proc, String(pid), 'stat'), `${pid} (${name}) S 1 ${pid} ${pid} 0 -1\n`);
+    }
+  }
+  return names;
+}
+
+// ─── Probe paths ──────────────────────────────────────────────────────────────
+
+function syncProbe(root: string, name: string): boolean {
+  try {
+    fs.accessSync(path.join(root, 'etc/init.d', name));
+  } catch {
+    return false;
+  }
+  let raw: string;
+  try {
+    raw = fs.readFileSync(path.join(root, 'run', `${name}.pid`), 'utf8');
+  } catch {
+    return false;
+  }
+  const pid = parseInt(raw, 10);
+  try {
+    return fs.readFileSync(path.join(root, 'proc', String(pid), 'stat'), 'utf8').length > 0;
+  } catch {
+    return false;
+  }
+}
+
+async function engineProbe(engine: ProbeEngine, root: string, name: string): Promise<boolean> {
+  const [exists, raw] = await Promise.all([
+    engine.exists(path.join(root, 'etc/init.d', name)),
+    engine.read(path.join(root, 'run', `${name}.pid`))
+  ]);
+  if (!exists || raw === null) return false;
+  const stat = await engine.read(path.join(root, 'proc', String(parseInt(raw, 10)), 'stat'));
+  return stat !== null;
+}
+
+// ─── Runner ───────────────────────────────────────────────────────────────────
+
+interface Result {
+  path: string;
+  ms: number;
+  probesPerSec: number;
+  maxLoopBlockMs: number;
+  running: number;
+}
+
+/**
+ * Runs `fn` while a 1 ms interval records the longest gap between its ticks,
+ * i.e. the longest time the event loop was blocked.
+ */
+async function measure(label: string, fn: () => Promise<number> | number, probes: number): Promise<Result> {
+  let lastTick = performance.now();
+  let maxBlock = 0;
+  const timer = setInterval(() => {
+    const now = performance.now();
+    maxBlock = Math.max(maxBlock, now - lastTick);
+    lastTick = now;
+  }, 1);
+  await new Promise(resolve => setTimeout(resolve, 5));
+
+  const t0 = performance.now();
+  const running = await fn();
+  const ms = performance.now() - t0;
+  await new Promise(resolve => setTimeout(resolve, 5));
+  clearInterval(timer);
+
+  return {
+    path: label,
+    ms: Math.round(ms * 10) / 10,
+    probesPerSec: Math.round(probes / (ms / 1000)),
+    maxLoopBlockMs: Math.round(maxBlock * 10) / 10,
+    running
+  };
+}
+
+async function main(): Promise<void> {
+  const count = parseInt(process.argv[2] || '10000', 10);
+  const root = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-bench-'));
+  try {
+    const names = buildTree(root, count);
+    const probesPerRound = count * 2 + Math.ceil(count / 2);
+
+    const results: Result[] = [];
+    results.push(await measure('sync', () => names.filter(n => syncProbe(root, n)).length, probesPerRound));
+    const engine = new ProbeEngine();
+    results.push(await measure('engine', async () => {
+      const r = await Promise.all(names.map(n => engineProbe(engine, root, n)));
+      return r.filter(Boolean).length;
+    }, probesPerRound));
+
+    console.table(results);
+    console.log(JSON.stringify({
+      count,
+      ioUring: process.env.UV_USE_IO_URING ?? 'default',
+      threadpool: process.env.UV_THREADPOOL_SIZE ?? '4',
+      engine: engine.stats(),
+      results
+    }));
+  } finally {
+    fs.rmSync(root, { recursive: true, force: true });
+  }
+}
+
+main().catch(err => {
+  console.error(err);
+  process.exit(1);
+});
@@ -13,7 +13,42 @@
  * @module service_api
  */
 
-import { ServiceStatus, ServiceModule } from './src/types';
+import {
+  ServiceStatus, ServiceStatusError, ServiceModule, IterateServicesOptions,
+  ServiceChange, ServiceChangeListener, ServiceWatcher
+} from './src/types';
+import { scheduler, SchedulerStats, LaneStats } from './src/scheduler';
+import { ProcEventsWatchOptions } from './src/procevents';
+import { PidFileWatchOptions } from './src/pidwatch';
+import { TraceSession, ReplayOptions } from './src/trace';
+import { ContainerInfo, ContainerServices, ScanContainersOptions } from './src/containers';
+import { ServiceThreads, ThreadSample, ServiceThreadsOptions } from './src/threads';
+import { ServiceMemory, ProcessMemory, MemoryUsage } from './src/memory';
+import { CrashEvent, CrashListener, WatchCrashesOptions } from './src/crashes';
+import { LimitWarning, LimitListener, LimitResource, WatchLimitsOptions } from './src/limits';
+import { StuckTransition, StuckListener, WatchStuckOptions } from './src/stuck';
+import { UnitRecord, UnitQuery, LoadUnitsOptions } from './src/unittable';
+import { TransientUnit, TransientUnitOptions, JobResult } from './src/transient';
+import { FreezeOptions } from './src/freezer';
+import {
+  LogRate, LogRates, LogRatesOptions, FollowLogRatesOptions, LogRatesListener
+} from './src/logrates';
+import {
+  ServiceResources, SetResourcesOptions, ResourceChange, ResourceChangeResult
+} from './src/resources';
+import { pollServices as startPoller, pollBudget, PollOptions } from './src/poller';
+import {
+  SnapshotEncoder, SnapshotDecoder, SnapshotExporter, SnapshotFrame, SnapshotExporterOptions, decodeSnapshots
+} from './src/export';
+import { RuleEngine, Rule, RuleListener, CompiledRule, compileRule } from './src/rules';
+import {
+  TransitionTracker, TransitionStats, TransitionStatsReport, TransitionTrackerOptions, transitions
+} from './src/transitions';
+import { Histogram, HistogramSnapshot } from './src/histogram';
+import {
+  HistoryStore, HistoryOptions, EnableHistoryOptions, HistoryRange, HistoryResult, HistoryPoint,
+  HistoryTransition, HistoryResolution, enableHistory as startHistory, disableHistory, queryHistory
+} from './src/history';
 
 const platform = process.platform;
 
@@ -51,4 +86,505 @@ const serviceExists = impl.serviceExists;
  */
 const getServiceStatus = impl.getServiceStatus;
 
-export { serviceExists, getServiceStatus, ServiceStatus };
+/**
+ * Returns the status of several services.
+ *
+ * Backend work is queued on the library-wide scheduler as one group: the
+ * batch shares each backend's concurrency cap fairly with other callers
+ * instead of monopolizing it. With libsystemd, each status is a synchronous
+ * D-Bus call that blocks the event loop for its round trip; the cap and the
+ * round-robin have no effect on those.
+ *
+ * @param serviceNames - See {@link serviceExists} for naming convention.
+ * @returns One entry per name, in order. Services that do not exist or cannot
+ *          be queried are reported inline as `{ name, exists: false, error }`.
+ * @throws  {TypeError} If `serviceNames` is not an array.
+ */
+async function getServiceStatuses(
+  serviceNames: string[]
+): Promise<Array<ServiceStatus | ServiceStatusError>> {
+  if (!Array.isArray(serviceNames)) {
+    throw new TypeError('serviceNames must be an array');
+  }
+  const group = scheduler.createGroup();
+  return Promise.all(serviceNames.map(name =>
+    scheduler.withGroup(group, () => getServiceStatus(name))
+      .catch((err: Error): ServiceStatusError => ({ name, exists: false, error: err.message }))
+  ));
+}
+
+/**
+ * Returns in-flight and queued operation counts of the library-wide
+ * scheduler, in total and per backend.
+ */
+function getSchedulerStats(): SchedulerStats {
+  return scheduler.stats();
+}
+
+/**
+ * Changes the concurrency cap of a backend (`systemd`, `openrc`, `sysv`).
+ */
+function setConcurrencyLimit(backend: string, limit: number): void {
+  scheduler.setLimit(backend, limit);
+}
+
+/**
+ * Watches services by polling, for hosts where no event source is available.
+ *
+ * Each service is polled at an adaptive interval: fast right after a change,
+ * backing off exponentially while it stays stable. All pollers share a global
+ * query budget (see {@link setPollBudget}).
+ *
+ * @param serviceNames - See {@link serviceExists} for naming convention.
+ * @param listener     - Called with each {@link ServiceChange}.
+ * @throws  {TypeError} If `serviceNames` is not an array or `listener` not a function.
+ */
+function pollServices(
+  serviceNames: string[],
+  listener: ServiceChangeListener,
+  options?: PollOptions
+): ServiceWatcher {
+  return startPoller(serviceNames, getServiceStatus, listener, options);
+}
+
+/**
+ * Changes the global polling budget: status queries per second, shared by
+ * every `pollServices` watcher. Default 200.
+ */
+function setPollBudget(queriesPerSecond: number): void {
+  pollBudget.setRate(queriesPerSecond);
+}
+
+/**
+ * Returns start, stop and restart-to-ready duration histograms (ms) for the
+ * services seen by the library's watchers, per service and overall.
+ */
+function getTransitionStats(): TransitionStatsReport {
+  return transitions.stats();
+}
+
+/**
+ * Starts recording every state transition seen by the library's watchers to
+ * the SQLite database at `file` (requires `node:sqlite`, Node ≥ 22.5). With
+ * `options.services`, their FD, task and memory use is sampled as well
+ * (Linux only). Read it back with {@link queryHistory}.
+ *
+ * @throws  {Error} If node:sqlite is unavailable, or `services` is given on Windows.
+ */
+function enableHistory(file: string, options?: EnableHistoryOptions): HistoryStore {
+  if (options?.services && options.services.length > 0) linuxOnly('enableHistory({ services })');
+  return startHistory(file, options);
+}
+
+// ─── Linux-only APIs ──────────────────────────────────────────────────────────
+
+type LinuxModule = typeof import('./src/linux');
+
+function linuxOnly(feature: string): LinuxModule {
+  if (platform === 'win32') {
+    throw new Error(`service_api: ${feature} is only supported on Linux`);
+  }
+  return impl as unknown as LinuxModule;
+}
+
+/**
+ * Lists installed services, yielding each one as soon as it is decoded.
+ * On systemd the `ListUnitsByPatterns` reply is fetched synchronously and
+ * held whole while it is decoded; on OpenRC/SysV memory stays bounded by
+ * one `/etc/init.d` entry.
+ *
+ * @param options - Name globs and state filter.
+ * @throws  {Error} On Windows.
+ */
+function iterateServices(options?: IterateServicesOptions): AsyncGenerator<ServiceStatus> {
+  return linuxOnly('iterateServices').iterateServices(options);
+}
+
+/**
+ * Watches SysV/OpenRC services through kernel process events (netlink proc
+ * connector) and reports state transitions without polling.
+ * Requires CAP_NET_ADMIN.
+ *
+ * @param listener - Called with each {@link ServiceChange}.
+ * @throws  {Error} On Windows, on systemd hosts, or without CAP_NET_ADMIN.
+ */
+async function watchProcEvents(
+  listener: ServiceChangeListener,
+  options?: ProcEventsWatchOptions
+): Promise<ServiceWatcher> {
+  linuxOnly('watchProcEvents');
+  const procevents: typeof import('./src/procevents') = require('./src/procevents');
+  return procevents.watchProcEvents(listener, options);
+}
+
+/**
+ * Watches the pidfiles and lockfiles of SysV/OpenRC services in `/run` and
+ * `/var/run` with inotify, and reports the start and stop transitions their
+ * creation and removal reveal. Running daemons are also held as pidfds, so
+ * a crash that leaves its pidfile is reported too. No polling, no
+ * privileges.
+ *
+ * @param listener - Called with each {@link ServiceChange}.
+ * @throws  {Error} On Windows, or if neither directory can be watched.
+ */
+async function watchPidFiles(
+  listener: ServiceChangeListener,
+  options?: PidFileWatchOptions
+): Promise<ServiceWatcher> {
+  linuxOnly('watchPidFiles');
+  const pidwatch: typeof import('./src/pidwatch') = require('./src/pidwatch');
+  return pidwatch.watchPidFiles(listener, options);
+}
+
+/**
+ * Finds the system containers on this host (PID-namespace init processes)
+ * and lists the services of each through its own bus or filesystem state.
+ * Service PIDs are translated to host PIDs. Requires root.
+ *
+ * @throws  {Error} On Windows.
+ */
+async function scanContainers(options?: ScanContainersOptions): Promise<ContainerServices[]> {
+  linuxOnly('scanContainers');
+  const containers: typeof import('./src/containers') = require('./src/containers');
+  return containers.scanContainers(options);
+}
+
+/**
+ * Returns the threads of every process of a running service, with their
+ * names, states and CPU use since the previous call for that service.
+ *
+ * @throws  {Error} On Windows, or if the service does not exist or is not running.
+ */
+async function getServiceThreads(serviceName: string, options?: ServiceThreadsOptions): Promise<ServiceThreads> {
+  linuxOnly('getServiceThreads');
+  const threads: typeof import('./src/threads') = require('./src/threads');
+  return threads.getServiceThreads(serviceName, options);
+}
+
+/**
+ * Returns the proportional (PSS) and unique (USS) memory of a running
+ * service, summed over all of its processes.
+ *
+ * @throws  {Error} On Windows, or if the service does not exist or is not running.
+ */
+async function getServiceMemory(serviceName: string): Promise<ServiceMemory> {
+  linuxOnly('getServiceMemory');
+  const memory: typeof import('./src/memory') = require('./src/memory');
+  return memory.getServiceMemory(serviceName);
+}
+
+/**
+ * Reports service crashes as they happen, from systemd-coredump's stored
+ * cores (inotify) and journal entries, each attributed to its unit. Catches
+ * crashes that a fast `Restart=` hides from status polling.
+ *
+ * @param listener - Called with each {@link CrashEvent}.
+ * @throws  {Error} On Windows, or if neither the coredump directory nor the
+ *                  journal can be watched.
+ */
+function watchCrashes(listener: CrashListener, options?: WatchCrashesOptions): ServiceWatcher {
+  linuxOnly('watchCrashes');
+  const crashes: typeof import('./src/crashes') = require('./src/crashes');
+  return crashes.watchCrashes(listener, options);
+}
+
+/**
+ * Samples the open FDs, tasks and memory of `serviceNames` against their
+ * limits (`RLIMIT_NOFILE`, `TasksMax`, `MemoryMax`) and warns when a
+ * utilization threshold is crossed.
+ *
+ * @param listener - Called with each {@link LimitWarning}.
+ * @throws  {Error} On Windows.
+ */
+function watchLimits(
+  serviceNames: string[],
+  listener: LimitListener,
+  options?: WatchLimitsOptions
+): ServiceWatcher {
+  linuxOnly('watchLimits');
+  const limits: typeof import('./src/limits') = require('./src/limits');
+  return limits.watchLimits(serviceNames, listener, options);
+}
+
+/**
+ * Reports services of `serviceNames` that stay in `START_PENDING` or
+ * `STOP_PENDING` longer than their unit timeout or a configured budget.
+ * One timer per transition, armed when an event (systemd signal, process,
+ * pidfile or OpenRC state change) reveals it; `source: 'poll'` opts into
+ * the adaptive poller instead.
+ *
+ * @param listener - Called with each {@link StuckTransition}.
+ * @throws  {Error} On Windows, or on systemd without libsystemd.
+ */
+function watchStuckTransitions(
+  serviceNames: string[],
+  listener: StuckListener,
+  options?: WatchStuckOptions
+): ServiceWatcher {
+  linuxOnly('watchStuckTransitions');
+  const stuck: typeof import('./src/stuck') = require('./src/stuck');
+  return stuck.watchStuckTransitions(serviceNames, listener, options);
+}
+
+/**
+ * Returns the units matching every constraint of `query` (state, raw active
+ * state, slice, UnitFileState, type, minimum restart count, predicate),
+ * from the library's indexed unit table. The table is loaded on first use
+ * and then kept current by the library's watchers.
+ *
+ * @throws  {Error} On Windows.
+ */
+async function queryUnits(query?: UnitQuery): Promise<UnitRecord[]> {
+  linuxOnly('queryUnits');
+  const { unitTable }: typeof import('./src/unittable') = require('./src/unittable');
+  if (!unitTable.loaded) await unitTable.load();
+  return unitTable.query(query);
+}
+
+/**
+ * Reloads the unit table used by {@link queryUnits} from the service manager.
+ *
+ * @throws  {Error} On Windows.
+ */
+async function refreshUnits(options?: LoadUnitsOptions): Promise<void> {
+  linuxOnly('refreshUnits');
+  const { unitTable }: typeof import('./src/unittable') = require('./src/unittable');
+  await unitTable.load(options);
+}
+
+/**
+ * Runs `options.command` as a transient systemd service through
+ * `Manager.StartTransientUnit` on a reused bus connection, and resolves with
+ * the unit name once its start job has finished (`JobRemoved`).
+ *
+ * @throws  {Error} On Windows, without libsystemd, or if systemd refuses the unit.
+ */
+async function runTransient(options: TransientUnitOptions): Promise<TransientUnit> {
+  linuxOnly('runTransient');
+  const transient: typeof import('./src/transient') = require('./src/transient');
+  return transient.runTransient(options);
+}
+
+/**
+ * Freezes every process of a running service through the cgroup v2 freezer
+ * (systemd `Unit.Freeze`, else the service's `cgroup.freeze`). Its state
+ * reads `PAUSED` until {@link resumeService}.
+ *
+ * @returns The status once the service is frozen.
+ * @throws  {Error} On Windows, or if the service is not running or cannot be frozen.
+ */
+async function pauseService(serviceName: string, options?: FreezeOptions): Promise<ServiceStatus> {
+  linuxOnly('pauseService');
+  const freezer: typeof import('./src/freezer') = require('./src/freezer');
+  return freezer.pauseService(serviceName, options);
+}
+
+/**
+ * Thaws a service frozen by {@link pauseService}.
+ *
+ * @returns The status once the service is thawed.
+ * @throws  {Error} On Windows, or if the service cannot be thawed.
+ */
+async function resumeService(serviceName: string, options?: FreezeOptions): Promise<ServiceStatus> {
+  linuxOnly('resumeService');
+  const freezer: typeof import('./src/freezer') = require('./src/freezer');
+  return freezer.resumeService(serviceName, options);
+}
+
+/**
+ * Changes a service's CPU quota and weight, memory limits, IO weight or task
+ * limit at runtime with `Manager.SetUnitProperties`, over the library's
+ * shared bus connection. `null` removes a setting.
+ *
+ * @throws  {TypeError} If a setting is invalid.
+ * @throws  {Error} On Windows, outside systemd, or if systemd refuses the change.
+ */
+async function setServiceResources(
+  serviceName: string,
+  resources: ServiceResources,
+  options?: SetResourcesOptions
+): Promise<void> {
+  linuxOnly('setServiceResources');
+  const res: typeof import('./src/resources') = require('./src/resources');
+  await res.setServiceResources(serviceName, resources, options);
+}
+
+/**
+ * Applies resource changes to many services in one pipelined exchange: all
+ * calls are sent before any reply is read.
+ *
+ * @returns One `{ name, error }` per change, in order; `error` is `null` when applied.
+ * @throws  {TypeError} If a setting is invalid (nothing is sent).
+ * @throws  {Error} On Windows, or outside systemd.
+ */
+async function setServiceResourcesBatch(
+  changes: ResourceChange[],
+  options?: SetResourcesOptions
+): Promise<ResourceChangeResult[]> {
+  linuxOnly('setServiceResourcesBatch');
+  const res: typeof import('./src/resources') = require('./src/resources');
+  return res.setServiceResourcesBatch(changes, options);
+}
+
+/**
+ * Returns per-unit journal entry and byte rates over the last
+ * `options.window` ms (default 60 s), from one streaming pass over that part
+ * of the journal, largest producers first.
+ *
+ * @throws  {Error} On Windows, or if libsystemd is unavailable or the journal
+ *                  cannot be opened.
+ */
+async function getLogRates(options?: LogRatesOptions): Promise<LogRates> {
+  linuxOnly('getLogRates');
+  const logrates: typeof import('./src/logrates') = require('./src/logrates');
+  return logrates.getLogRates(options);
+}
+
+/**
+ * Reports per-unit journal rates over a sliding window every
+ * `options.interval` ms, counting new entries incrementally as they are
+ * written.
+ *
+ * @param listener - Called with each {@link LogRates} report.
+ * @throws  {Error} On Windows, or if libsystemd is unavailable or the journal
+ *                  cannot be opened.
+ */
+function followLogRates(listener: LogRatesListener, options?: FollowLogRatesOptions): ServiceWatcher {
+  linuxOnly('followLogRates');
+  const logrates: typeof import('./src/logrates') = require('./src/logrates');
+  return logrates.followLogRates(listener, options);
+}
+
+/**
+ * Records every backend interaction (D-Bus unit queries, `systemctl` output,
+ * filesystem probes, listings) with its timing to an NDJSON trace file.
+ *
+ * @param file - Trace file, overwritten.
+ * @throws  {Error} On Windows, or if a recording or replay is already active.
+ */
+function recordTrace(file: string): TraceSession {
+  linuxOnly('recordTrace');
+  const trace: typeof import('./src/trace') = require('./src/trace');
+  return trace.recordTrace(file);
+}
+
+/**
+ * Answers backend interactions from a trace recorded with
+ * {@link recordTrace}, with the recorded latencies scaled by
+ * `options.timeScale`.
+ *
+ * @throws  {Error} On Windows, if `file` is not a trace, or if a recording or
+ *                  replay is already active.
+ */
+function replayTrace(file: string, options?: ReplayOptions): TraceSession {
+  linuxOnly('replayTrace');
+  const trace: typeof import('./src/trace') = require('./src/trace');
+  return trace.replayTrace(file, options);
+}
+
+export {
+  serviceExists,
+  getServiceStatus,
+  getServiceStatuses,
+  iterateServices,
+  watchProcEvents,
+  watchPidFiles,
+  pollServices,
+  setPollBudget,
+  recordTrace,
+  replayTrace,
+  scanContainers,
+  getServiceThreads,
+  getServiceMemory,
+  watchCrashes,
+  watchLimits,
+  watchStuckTransitions,
+  queryUnits,
+  refreshUnits,
+  runTransient,
+  pauseService,
+  resumeService,
+  setServiceResources,
+  setServiceResourcesBatch,
+  getLogRates,
+  followLogRates,
+  SnapshotEncoder,
+  SnapshotDecoder,
+  SnapshotExporter,
+  decodeSnapshots,
+  getSchedulerStats,
+  setConcurrencyLimit,
+  getTransitionStats,
+  enableHistory,
+  disableHistory,
+  queryHistory,
+  HistoryStore,
+  TransitionTracker,
+  Histogram,
+  HistoryOptions,
+  EnableHistoryOptions,
+  HistoryRange,
+  HistoryResult,
+  HistoryPoint,
+  HistoryTransition,
+  HistoryResolution,
+  ServiceStatus,
+  ServiceStatusError,
+  SchedulerStats,
+  LaneStats,
+  IterateServicesOptions,
+  ServiceChange,
+  ServiceChangeListener,
+  ServiceWatcher,
+  ProcEventsWatchOptions,
+  PidFileWatchOptions,
+  PollOptions,
+  TraceSession,
+  ReplayOptions,
+  ContainerInfo,
+  ContainerServices,
+  ScanContainersOptions,
+  ServiceThreads,
+  ThreadSample,
+  ServiceThreadsOptions,
+  ServiceMemory,
+  ProcessMemory,
+  MemoryUsage,
+  CrashEvent,
+  CrashListener,
+  WatchCrashesOptions,
+  LimitWarning,
+  LimitListener,
+  LimitResource,
+  WatchLimitsOptions,
+  StuckTransition,
+  StuckListener,
+  WatchStuckOptions,
+  UnitRecord,
+  UnitQuery,
+  LoadUnitsOptions,
+  TransientUnit,
+  TransientUnitOptions,
+  JobResult,
+  FreezeOptions,
+  ServiceResources,
+  SetResourcesOptions,
+  ResourceChange,
+  ResourceChangeResult,
+  LogRate,
+  LogRates,
+  LogRatesOptions,
+  FollowLogRatesOptions,
+  LogRatesListener,
+  SnapshotFrame,
+  SnapshotExporterOptions,
+  RuleEngine,
+  Rule,
+  RuleListener,
+  CompiledRule,
+  compileRule,
+  TransitionStats,
+  TransitionStatsReport,
+  TransitionTrackerOptions,
+  HistogramSnapshot
+};
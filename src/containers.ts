@@ -0,0 +1,182 @@
+'use strict';
+
+/**
+ * Service scanning across system containers.
+ *
+ * A container is found through its init: a process that is PID 1 in a PID
+ * namespace nested below ours (last `NSpid` entry of `/proc/<pid>/status` is
+ * `1`). Its filesystem is reached through `/proc/<pid>/root`:
+ *
+ * - **systemd** containers are asked over their own bus socket
+ *   (`/run/dbus/system_bus_socket`, else systemd's private socket);
+ * - **OpenRC / SysV** containers are read from their filesystem state, exactly
+ *   like the host backends do.
+ *
+ * PIDs reported inside a container are translated to host PIDs through the
+ * `NSpid` lines gathered while finding the containers. Requires root.
+ */
+
+import fs from 'fs';
+import { ServiceStatus } from './types';
+import { InitSystem, detectInitSystem, listServicesAt } from './linux';
+import { BusPtr, tryLoadLibsystemd, openBusAt } from './sdbus';
+import { probes } from './probe';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** A system container, identified by its init process. */
+export interface ContainerInfo {
+  /** Host PID of the container's init (PID 1 inside the container). */
+  pid: number;
+  /** Inode of the container's PID namespace (`/proc/<pid>/ns/pid`). */
+  pidNamespace: number;
+  /** The container's root, `/proc/<pid>/root`. */
+  root: string;
+  /** The container's init system. */
+  init: InitSystem;
+  /** Command name of the init process (`/proc/<pid>/comm`). */
+  command: string;
+}
+
+/** The services of one container. */
+export interface ContainerServices {
+  container: ContainerInfo;
+  /** Services, with `pid` translated to the host PID (`0` when unknown). */
+  services: ServiceStatus[];
+  /** Why the container could not be queried, if it could not. */
+  error?: string;
+}
+
+export interface ScanContainersOptions {
+  /** Shell-style globs on the service name (see `iterateServices`). */
+  patterns?: string[];
+  /** Only report services in one of these normalized states. */
+  states?: string[];
+  /** Containers queried in parallel. Default 4. */
+  concurrency?: number;
+}
+
+interface PidNamespace {
+  inode: number;
+  /** Host PID of the namespace's PID 1, if seen. */
+  init: number;
+  /** PID inside the namespace → host PID. */
+  pids: Map<number, number>;
+}
+
+// ─── /proc helpers ────────────────────────────────────────────────────────────
+
+/** Parses the `NSpid:` line of `/proc/<pid>/status`, outermost namespace first. */
+export function parseNSpid(status: string): number[] {
+  const match = /^NSpid:\s*(.*)$/m.exec(status);
+  if (!match) return [];
+  return match[1].trim().split(/\s+/).map(Number).filter(n => n > 0);
+}
+
+/** `pid:[4026532281]` → 4026532281. */
+function namespaceInode(link: string): number {
+  const match = /\[(\d+)\]/.exec(link);
+  return match ? Number(match[1]) : 0;
+}
+
+/**
+ * Groups the processes of the PID namespaces nested below ours, reading
+ * every `/proc/<pid>/status` through the shared probe engine.
+ */
+async function nestedPidNamespaces(): Promise<Map<number, PidNamespace>> {
+  const own = parseNSpid((await probes.read('/proc/self/status')) ?? '').length || 1;
+  const pids = (await fs.promises.readdir('/proc')).filter(e => /^\d+$/.test(e)).map(Number);
+  const statuses = await Promise.all(pids.map(pid => probes.read(`/proc/${pid}/status`)));
+
+  const nested: Array<{ pid: number; inner: number }> = [];
+  pids.forEach((pid, i) => {
+    const nspid = parseNSpid(statuses[i] ?? '');
+    if (nspid.length > own) nested.push({ pid, inner: nspid[nspid.length - 1] });
+  });
+
+  const links = await Promise.all(nested.map(({ pid }) =>
+    fs.promises.readlink(`/proc/${pid}/ns/pid`).catch(() => '')));
+
+  const namespaces = new Map<number, PidNamespace>();
+  nested.forEach(({ pid, inner }, i) => {
+    const inode = namespaceInode(links[i]);
+    if (!inode) return;                       // exited meanwhile
+    let ns = namespaces.get(inode);
+    if (!ns) namespaces.set(inode, ns = { inode, init: 0, pids: new Map() });
+    ns.pids.set(inner, pid);
+    if (inner === 1) ns.init = pid;
+  });
+  return namespaces;
+}
+
+// ─── Discovery ────────────────────────────────────────────────────────────────
+
+async function discover(): Promise<Array<{ info: ContainerInfo; ns: PidNamespace }>> {
+  const found: Array<{ info: ContainerInfo; ns: PidNamespace }> = [];
+  for (const ns of (await nestedPidNamespaces()).values()) {
+    if (!ns.init) continue;                   // no init visible: not a container
+    const root = `/proc/${ns.init}/root`;
+    const command = ((await probes.read(`/proc/${ns.init}/comm`)) ?? '').trim();
+    found.push({
+      info: { pid: ns.init, pidNamespace: ns.inode, root, init: detectInitSystem(root), command },
+      ns
+    });
+  }
+  return found.sort((a, b) => a.info.pid - b.info.pid);
+}
+
+/**
+ * Lists the system containers running on this host.
+ */
+export async function findContainers(): Promise<ContainerInfo[]> {
+  return (await discover()).map(c => c.info);
+}
+
+// ─── Scanning ─────────────────────────────────────────────────────────────────
+
+/** Connects to a container's bus daemon, else to its systemd private socket. */
+function openContainerBus(root: string): BusPtr {
+  if (!tryLoadLibsystemd()) {
+    throw new Error('libsystemd is not available');
+  }
+  try {
+    return openBusAt(`${root}/run/dbus/system_bus_socket`, true);
+  } catch {
+    return openBusAt(`${root}/run/systemd/private`, false);
+  }
+}
+
+async function scanOne(
+  info: ContainerInfo, ns: PidNamespace, options: ScanContainersOptions
+): Promise<ContainerServices> {
+  const states = options.states && options.states.length > 0 ? new Set(options.states) : null;
+  const services: ServiceStatus[] = [];
+  try {
+    for await (const s of listServicesAt(info.root, info.init, () => openContainerBus(info.root), options.patterns)) {
+      if (states && !states.has(s.state)) continue;
+      services.push({ ...s, pid: s.pid > 0 ? ns.pids.get(s.pid) ?? 0 : 0 });
+    }
+  } catch (err) {
+    return { container: info, services, error: (err as Error).message };
+  }
+  return { container: info, services };
+}
+
+/**
+ * Finds the system containers on this host and lists the services of each,
+ * `concurrency` containers at a time. A container that cannot be queried is
+ * reported with `error` instead of failing the scan.
+ */
+export async function scanContainers(options: ScanContainersOptions = {}): Promise<ContainerServices[]> {
+  const containers = await discover();
+  const results: ContainerServices[] = new Array(containers.length);
+  const workers = Math.max(1, Math.min(options.concurrency ?? 4, containers.length));
+  let next = 0;
+  await Promise.all(Array.from({ length: workers }, async () => {
+    while (next < containers.length) {
+      const i = next++;
+      results[i] = await scanOne(containers[i].info, containers[i].ns, options);
+    }
+  }));
+  return results;
+}
@@ -0,0 +1,243 @@
+'use strict';
+
+/**
+ * Crash and coredump detection per service.
+ *
+ * A service that crashes and is restarted within its `RestartSec=` is
+ * `RUNNING` at every poll; the crash only shows up in systemd-coredump's
+ * output. Two sources are combined:
+ *
+ * - **inotify** on the coredump directory (`/var/lib/systemd/coredump/`):
+ *   the stored core appears there as soon as it is written. Its name gives
+ *   the PID, command and time, its xattrs the signal and executable;
+ * - **the journal**, matched on systemd-coredump's `MESSAGE_ID`: each entry
+ *   names the unit of the crashed process (`COREDUMP_UNIT`), and also covers
+ *   crashes whose core was not stored (`Storage=journal|none`, size limits).
+ *
+ * A core file is held for `settle` ms waiting for its journal entry, so each
+ * crash is reported once, with its unit, whichever source sees it first.
+ * Nothing is scanned: both sources are followed from their tail.
+ */
+
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { ServiceWatcher } from './types';
+import { tryLoadJournal, followJournal } from './journal';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** One crash, as reported by `watchCrashes`. */
+export interface CrashEvent {
+  /** Unit of the crashed process (`nginx.service`), or `null` if unknown. */
+  unit: string | null;
+  /** PID of the crashed process, as seen from the host. */
+  pid: number;
+  /** Terminating signal number (`11`), `0` if unknown. */
+  signal: number;
+  /** Its name (`SIGSEGV`), or `null` if unknown. */
+  signalName: string | null;
+  /** Executable path, or `null` if unknown. */
+  exe: string | null;
+  /** Command name (`comm`), or `null` if unknown. */
+  comm: string | null;
+  /** Time of the crash, in ms since the Unix epoch. */
+  timestamp: number;
+  /** Path of the stored core, or `null` if none was stored. */
+  coredump: string | null;
+}
+
+export type CrashListener = (crash: CrashEvent) => void;
+
+export interface WatchCrashesOptions {
+  /** Only report crashes of these services (names as for `getServiceStatus`). */
+  services?: readonly string[];
+  /** Directory systemd-coredump stores cores in. Default `/var/lib/systemd/coredump`. */
+  coredumpDir?: string;
+  /** Follow the journal. Default `true` when libsystemd is available. */
+  journal?: boolean;
+  /** How long a core file waits for its journal entry, in ms. Default 1000. */
+  settle?: number;
+  /** Called when a source fails; the other keeps running. */
+  onError?: (err: Error) => void;
+}
+
+/** `MESSAGE_ID` of systemd-coredump's journal entries. */
+export const COREDUMP_MESSAGE_ID = 'fc2e22bc6ee647b6b90729ab34a250b1';
+
+const JOURNAL_FIELDS = [
+  'COREDUMP_UNIT', 'COREDUMP_USER_UNIT', 'COREDUMP_PID', 'COREDUMP_SIGNAL', 'COREDUMP_SIGNAL_NAME',
+  'COREDUMP_EXE', 'COREDUMP_COMM', 'COREDUMP_TIMESTAMP', 'COREDUMP_FILENAME'
+];
+
+// ─── Parsing ──────────────────────────────────────────────────────────────────
+
+const signalNames = new Map<number, string>(
+  Object.entries(os.constants.signals).map(([name, num]) => [num as number, name])
+);
+
+/** `core.<comm>.<uid>.<boot id>.<pid>.<µs timestamp>[.lz4|.xz|.zst]` */
+const COREDUMP_FILE = /^core\.(.+)\.(\d+)\.([0-9a-f]{32})\.(\d+)\.(\d+)(?:\.(?:lz4|xz|zst))?$/;
+
+/**
+ * Parses a systemd-coredump file name. Returns `null` for anything else
+ * (temporary `.#core…` files, unrelated entries).
+ */
+export function parseCoredumpFilename(name: string): { comm: string; uid: number; pid: number; timestamp: number } | null {
+  const m = COREDUMP_FILE.exec(name);
+  if (!m) return null;
+  return {
+    // systemd-coredump escapes '.', '/' and ' ' in comm as \xNN
+    comm:      m[1].replace(/\\x([0-9a-f]{2})/g, (_, hex) => String.fromCharCode(parseInt(hex, 16))),
+    uid:       Number(m[2]),
+    pid:       Number(m[4]),
+    timestamp: Math.floor(Number(m[5]) / 1000)
+  };
+}
+
+/** Builds a crash from the fields of a systemd-coredump journal entry. */
+export function crashFromJournal(fields: Record<string, string>, entryTime = Date.now()): CrashEvent | null {
+  const pid = Number(fields.COREDUMP_PID);
+  if (!Number.isInteger(pid) || pid <= 0) return null;
+  const signal = Number(fields.COREDUMP_SIGNAL) || 0;
+  const usec = Number(fields.COREDUMP_TIMESTAMP);
+  return {
+    unit:       fields.COREDUMP_UNIT || fields.COREDUMP_USER_UNIT || null,
+    pid,
+    signal,
+    signalName: fields.COREDUMP_SIGNAL_NAME || signalNames.get(signal) || null,
+    exe:        fields.COREDUMP_EXE || null,
+    comm:       fields.COREDUMP_COMM || null,
+    timestamp:  usec > 0 ? Math.floor(usec / 1000) : entryTime,
+    coredump:   fields.COREDUMP_FILENAME || null
+  };
+}
+
+// ─── xattrs ───────────────────────────────────────────────────────────────────
+
+let _getxattr: ((path: string, name: string, value: Buffer, size: number) => number) | null | undefined;
+
+/** Reads a string xattr (systemd-coredump tags cores with `user.coredump.*`). */
+function readXattr(file: string, name: string): string | null {
+  if (_getxattr === undefined) {
+    try {
+      const koffi = require('koffi');
+      _getxattr = koffi.load('libc.so.6').func('long getxattr(str path, str name, void *value, size_t size)');
+    } catch {
+      _getxattr = null;
+    }
+  }
+  if (!_getxattr) return null;
+  const buf = Buffer.alloc(4096);
+  const n = _getxattr(file, name, buf, buf.length);
+  return n > 0 ? buf.toString('utf8', 0, n) : null;
+}
+
+function crashFromFile(file: string): CrashEvent | null {
+  const parsed = parseCoredumpFilename(path.basename(file));
+  if (!parsed) return null;
+  const signal = Number(readXattr(file, 'user.coredump.signal')) || 0;
+  return {
+    unit:       null,
+    pid:        parsed.pid,
+    signal,
+    signalName: signalNames.get(signal) ?? null,
+    exe:        readXattr(file, 'user.coredump.exe'),
+    comm:       parsed.comm,
+    timestamp:  parsed.timestamp,
+    coredump:   file
+  };
+}
+
+// ─── Watcher ──────────────────────────────────────────────────────────────────
+
+/** How long a reported PID suppresses reports of the same crash from the other source. */
+const DEDUP_MS = 60_000;
+
+/**
+ * Reports every crash on the host (or of `options.services`) to `listener`.
+ *
+ * @throws If neither the coredump directory nor the journal can be watched.
+ */
+export function watchCrashes(listener: CrashListener, options: WatchCrashesOptions = {}): ServiceWatcher {
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const dir = options.coredumpDir ?? '/var/lib/systemd/coredump';
+  const settle = Math.max(0, options.settle ?? 1000);
+  const onError = options.onError ?? (() => {});
+  const units = options.services
+    ? new Set(options.services.map(s => (s.includes('.') ? s : `${s}.service`)))
+    : null;
+
+  /** Core files waiting for their journal entry, by PID. */
+  const pending = new Map<number, { crash: CrashEvent; timer: NodeJS.Timeout }>();
+  /** PIDs already reported, with the time they were. */
+  const reported = new Map<number, number>();
+  let closed = false;
+
+  const emit = (crash: CrashEvent) => {
+    const now = Date.now();
+    for (const [pid, at] of reported) if (now - at > DEDUP_MS) reported.delete(pid);
+    reported.set(crash.pid, now);
+    // Without a unit the service filter cannot be applied; such crashes are
+    // only reported when no filter was given.
+    if (units && (!crash.unit || !units.has(crash.unit))) return;
+    listener(crash);
+  };
+
+  let journal: ServiceWatcher | null = null;
+  if (options.journal ?? tryLoadJournal()) {
+    try {
+      journal = followJournal([`MESSAGE_ID=${COREDUMP_MESSAGE_ID}`], JOURNAL_FIELDS, (fields, time) => {
+        const crash = crashFromJournal(fields, time);
+        if (closed || !crash || reported.has(crash.pid)) return;
+        const held = pending.get(crash.pid);
+        if (held) {
+          clearTimeout(held.timer);
+          pending.delete(crash.pid);
+          crash.coredump ??= held.crash.coredump;
+          crash.exe ??= held.crash.exe;
+        }
+        emit(crash);
+      }, onError);
+    } catch (e) {
+      onError(e as Error);
+    }
+  }
+
+  let files: fs.FSWatcher | null = null;
+  try {
+    files = fs.watch(dir, (_event, name) => {
+      if (closed || !name) return;
+      const file = path.join(dir, name.toString());
+      // Renames fire for removals (vacuuming) too; only new cores exist.
+      if (!fs.existsSync(file)) return;
+      const crash = crashFromFile(file);
+      if (!crash || reported.has(crash.pid) || pending.has(crash.pid)) return;
+      if (!journal) {
+        emit(crash);
+        return;
+      }
+      const timer = setTimeout(() => {
+        pending.delete(crash.pid);
+        if (!closed) emit(crash);
+      }, settle);
+      pending.set(crash.pid, { crash, timer });
+    });
+    files.on('error', onError);
+  } catch (e) {
+    if (!journal) throw new Error(`cannot watch ${dir} and the journal is unavailable: ${(e as Error).message}`);
+  }
+
+  return {
+    close() {
+      if (closed) return;
+      closed = true;
+      journal?.close();
+      files?.close();
+      for (const { timer } of pending.values()) clearTimeout(timer);
+      pending.clear();
+    }
+  };
+}
@@ -0,0 +1,514 @@
+'use strict';
+
+/**
+ * Compact delta-encoded export of service snapshots, for shipping host state
+ * to a collector.
+ *
+ * Stream layout:
+ *
+ *   header  "SVCX" version(1)
+ *   frame*  varint(length) kind timestamp varint(count) record*
+ *
+ * - kind `1` is a keyframe: the string table is reset, the timestamp is
+ *   absolute (ms since the epoch) and every service is written in full.
+ * - kind `2` is a delta: the timestamp is a zigzag offset from the previous
+ *   frame and only services whose fields changed (or that disappeared) are
+ *   written, with only the changed fields.
+ *
+ * Record: flags, string(name), then the fields named by the flags. A string
+ * is written once as a literal and referenced by index afterwards, so names,
+ * states and raw codes cost one or two bytes after their first occurrence.
+ * PIDs and numeric raw codes are varints.
+ *
+ * Only `name`, `state`, `pid` and `rawCode` are exported.
+ */
+
+import fs from 'fs';
+import net from 'net';
+import { Writable, finished } from 'stream';
+import { ServiceStatus, ServiceStatusError } from './types';
+
+// ─── Wire format ──────────────────────────────────────────────────────────────
+
+const MAGIC = Buffer.from('SVCX');
+const VERSION = 1;
+
+const KIND_KEYFRAME = 1;
+const KIND_DELTA    = 2;
+
+const F_STATE      = 0x01;
+const F_PID        = 0x02;
+const F_RAW        = 0x04;
+const F_RAW_NUMBER = 0x08;
+const F_REMOVED    = 0x10;
+
+/** Growable byte buffer with varint helpers. Arithmetic, not bitwise: values exceed 32 bits. */
+class ByteWriter {
+  private buf = Buffer.allocUnsafe(256);
+  length = 0;
+
+  byte(b: number): void {
+    this.ensure(1);
+    this.buf[this.length++] = b;
+  }
+
+  varint(n: number): void {
+    this.ensure(10);
+    while (n >= 0x80) {
+      this.buf[this.length++] = (n % 0x80) | 0x80;
+      n = Math.floor(n / 0x80);
+    }
+    this.buf[this.length++] = n;
+  }
+
+  zigzag(n: number): void {
+    this.varint(n < 0 ? -2 * n - 1 : 2 * n);
+  }
+
+  bytes(b: Buffer): void {
+    this.ensure(b.length);
+    b.copy(this.buf, this.length);
+    this.length += b.length;
+  }
+
+  take(): Buffer {
+    return this.buf.subarray(0, this.length);
+  }
+
+  private ensure(n: number): void {
+    if (this.length + n <= this.buf.length) return;
+    const next = Buffer.allocUnsafe(Math.max(this.buf.length * 2, this.length + n));
+    this.buf.copy(next, 0, 0, this.length);
+    this.buf = next;
+  }
+}
+
+class ByteReader {
+  pos = 0;
+  constructor(private readonly buf: Buffer) {}
+
+  get remaining(): number {
+    return this.buf.length - this.pos;
+  }
+
+  byte(): number {
+    if (this.pos >= this.buf.length) throw new RangeError('truncated frame');
+    return this.buf[this.pos++];
+  }
+
+  varint(): number {
+    let n = 0, scale = 1, b: number;
+    do {
+      b = this.byte();
+      n += (b & 0x7f) * scale;
+      scale *= 0x80;
+    } while (b & 0x80);
+    return n;
+  }
+
+  zigzag(): number {
+    const n = this.varint();
+    return n % 2 === 0 ? n / 2 : -(n + 1) / 2;
+  }
+
+  bytes(n: number): Buffer {
+    if (this.pos + n > this.buf.length) throw new RangeError('truncated frame');
+    const out = this.buf.subarray(this.pos, this.pos + n);
+    this.pos += n;
+    return out;
+  }
+}
+
+/** Reads a length-prefixing varint at `pos`; returns null when incomplete. */
+function peekVarint(buf: Buffer, pos: number): { value: number; size: number } | null {
+  let n = 0, scale = 1;
+  for (let i = pos; i < buf.length && i - pos < 10; i++) {
+    n += (buf[i] & 0x7f) * scale;
+    scale *= 0x80;
+    if (!(buf[i] & 0x80)) return { value: n, size: i - pos + 1 };
+  }
+  return null;
+}
+
+// ─── Encoder ──────────────────────────────────────────────────────────────────
+
+export interface SnapshotEncoderOptions {
+  /** Frames between keyframes (a keyframe included). Default 60. */
+  keyframeInterval?: number;
+  /** Emit the stream header before the first frame. Default `true`. */
+  header?: boolean;
+}
+
+/**
+ * Turns successive `ServiceStatus[]` snapshots into frames. The first buffer
+ * returned also carries the stream header.
+ */
+export class SnapshotEncoder {
+  private readonly keyframeInterval: number;
+  private strings = new Map<string, number>();
+  private previous = new Map<string, ServiceStatus>();
+  private lastTimestamp = 0;
+  private frames = 0;
+  private readonly header: boolean;
+  private headerWritten: boolean;
+
+  constructor(options: SnapshotEncoderOptions = {}) {
+    this.keyframeInterval = Math.max(1, options.keyframeInterval ?? 60);
+    this.header = options.header !== false;
+    this.headerWritten = !this.header;
+  }
+
+  /** Forces the next frame to be a keyframe. */
+  requestKeyframe(): void {
+    this.frames = 0;
+  }
+
+  /** Starts a new stream: the next buffer carries the header (if enabled) and a keyframe. */
+  restart(): void {
+    this.frames = 0;
+    this.headerWritten = !this.header;
+  }
+
+  /**
+   * Encodes `statuses` as the next frame. Error entries (as returned by
+   * `getServiceStatuses`) are left out, like services that disappeared.
+   */
+  encode(statuses: ReadonlyArray<ServiceStatus | ServiceStatusError>, timestamp = Date.now()): Buffer {
+    const keyframe = this.frames % this.keyframeInterval === 0;
+    this.frames++;
+
+    const body = new ByteWriter();
+    const current = new Map<string, ServiceStatus>();
+    for (const s of statuses) if (s.exists) current.set(s.name, s as ServiceStatus);
+
+    if (keyframe) {
+      this.strings.clear();
+      body.byte(KIND_KEYFRAME);
+      body.varint(timestamp);
+      body.varint(current.size);
+      for (const s of current.values()) this.record(body, s, F_STATE | F_PID | F_RAW);
+    } else {
+      const records: Array<[ServiceStatus, number]> = [];
+      for (const s of current.values()) {
+        const prev = this.previous.get(s.name);
+        let flags = 0;
+        if (!prev || prev.state !== s.state) flags |= F_STATE;
+        if (!prev || prev.pid !== s.pid) flags |= F_PID;
+        if (!prev || prev.rawCode !== s.rawCode) flags |= F_RAW;
+        if (flags) records.push([s, flags]);
+      }
+      for (const [name, prev] of this.previous) {
+        if (!current.has(name)) records.push([prev, F_REMOVED]);
+      }
+      body.byte(KIND_DELTA);
+      body.zigzag(timestamp - this.lastTimestamp);
+      body.varint(records.length);
+      for (const [s, flags] of records) this.record(body, s, flags);
+    }
+    this.previous = current;
+    this.lastTimestamp = timestamp;
+
+    const out = new ByteWriter();
+    if (!this.headerWritten) {
+      out.bytes(MAGIC);
+      out.byte(VERSION);
+      this.headerWritten = true;
+    }
+    out.varint(body.length);
+    out.bytes(body.take());
+    return Buffer.from(out.take());
+  }
+
+  private record(w: ByteWriter, s: ServiceStatus, flags: number): void {
+    if (flags & F_RAW && typeof s.rawCode === 'number') flags |= F_RAW_NUMBER;
+    w.byte(flags);
+    this.string(w, s.name);
+    if (flags & F_STATE) this.string(w, s.state);
+    if (flags & F_PID) w.varint(Math.max(0, s.pid));
+    if (flags & F_RAW) {
+      if (flags & F_RAW_NUMBER) w.varint(Math.max(0, s.rawCode as number));
+      else this.string(w, String(s.rawCode));
+    }
+  }
+
+  /** Index reference `2n`, or literal `2·len+1` followed by the UTF-8 bytes. */
+  private string(w: ByteWriter, value: string): void {
+    const index = this.strings.get(value);
+    if (index !== undefined) {
+      w.varint(index * 2);
+      return;
+    }
+    this.strings.set(value, this.strings.size);
+    const bytes = Buffer.from(value, 'utf8');
+    w.varint(bytes.length * 2 + 1);
+    w.bytes(bytes);
+  }
+}
+
+// ─── Decoder ──────────────────────────────────────────────────────────────────
+
+/** One decoded frame. */
+export interface SnapshotFrame {
+  /** Frame time (ms since the epoch). */
+  timestamp: number;
+  /** `true` for keyframes. */
+  keyframe: boolean;
+  /** Every service known after applying the frame. */
+  statuses: ServiceStatus[];
+  /** Names written in the frame (added or changed). */
+  changed: string[];
+  /** Names that disappeared in the frame. */
+  removed: string[];
+}
+
+/**
+ * Rebuilds snapshots from an encoded stream. Accepts arbitrary chunks;
+ * incomplete frames are buffered until the rest arrives.
+ */
+export class SnapshotDecoder {
+  private pending: Buffer = Buffer.alloc(0);
+  private headerRead = false;
+  private strings: string[] = [];
+  private state = new Map<string, ServiceStatus>();
+  private lastTimestamp = 0;
+
+  /**
+   * Feeds a chunk and returns the frames it completes.
+   * @throws If the stream header is invalid or a frame is malformed.
+   */
+  push(chunk: Buffer): SnapshotFrame[] {
+    this.pending = this.pending.length ? Buffer.concat([this.pending, chunk]) : chunk;
+    let pos = 0;
+    if (!this.headerRead) {
+      if (this.pending.length < MAGIC.length + 1) return [];
+      if (!this.pending.subarray(0, MAGIC.length).equals(MAGIC)) {
+        throw new Error('not a service snapshot stream');
+      }
+      const version = this.pending[MAGIC.length];
+      if (version !== VERSION) throw new Error(`unsupported snapshot stream version ${version}`);
+      this.headerRead = true;
+      pos = MAGIC.length + 1;
+    }
+
+    const frames: SnapshotFrame[] = [];
+    for (;;) {
+      const len = peekVarint(this.pending, pos);
+      if (!len || pos + len.size + len.value > this.pending.length) break;
+      const start = pos + len.size;
+      pos = start + len.value;
+      frames.push(this.frame(new ByteReader(this.pending.subarray(start, pos))));
+    }
+    this.pending = this.pending.subarray(pos);
+    return frames;
+  }
+
+  private frame(r: ByteReader): SnapshotFrame {
+    const kind = r.byte();
+    if (kind !== KIND_KEYFRAME && kind !== KIND_DELTA) {
+      throw new Error(`unknown snapshot frame kind ${kind}`);
+    }
+    const keyframe = kind === KIND_KEYFRAME;
+    if (keyframe) {
+      this.strings = [];
+      this.state = new Map();
+      this.lastTimestamp = r.varint();
+    } else {
+      this.lastTimestamp += r.zigzag();
+    }
+
+    const changed: string[] = [];
+    const removed: string[] = [];
+    for (let n = r.varint(); n > 0; n--) {
+      const flags = r.byte();
+      const name = this.string(r);
+      if (flags & F_REMOVED) {
+        this.state.delete(name);
+        removed.push(name);
+        continue;
+      }
+      const prev = this.state.get(name);
+      const next: ServiceStatus = prev
+        ? { ...prev }
+        : { name, exists: true, state: '', pid: 0, rawCode: '' };
+      if (flags & F_STATE) next.state = this.string(r);
+      if (flags & F_PID) next.pid = r.varint();
+      if (flags & F_RAW) next.rawCode = flags & F_RAW_NUMBER ? r.varint() : this.string(r);
+      this.state.set(name, next);
+      changed.push(name);
+    }
+    if (r.remaining !== 0) throw new Error('malformed snapshot frame');
+
+    return {
+      timestamp: this.lastTimestamp,
+      keyframe,
+      statuses: [...this.state.values()],
+      changed,
+      removed
+    };
+  }
+
+  private string(r: ByteReader): string {
+    const ref = r.varint();
+    if (ref % 2 === 0) {
+      const value = this.strings[ref / 2];
+      if (value === undefined) throw new Error('dangling string reference');
+      return value;
+    }
+    const value = r.bytes((ref - 1) / 2).toString('utf8');
+    this.strings.push(value);
+    return value;
+  }
+}
+
+/** Decodes a stream (file or socket) frame by frame. */
+export async function* decodeSnapshots(source: AsyncIterable<Buffer>): AsyncGenerator<SnapshotFrame> {
+  const decoder = new SnapshotDecoder();
+  for await (const chunk of source) {
+    yield* decoder.push(chunk);
+  }
+}
+
+// ─── Exporter ─────────────────────────────────────────────────────────────────
+
+export interface SnapshotExporterOptions extends SnapshotEncoderOptions {
+  /** Append to this file (the header is only written to an empty file). */
+  path?: string;
+  /** Connect to this UNIX socket; reconnects with backoff when the connection fails or drops. */
+  socket?: string;
+  /** Write to this stream (takes precedence over `path` and `socket`). */
+  stream?: Writable;
+  /**
+   * Called on destination errors: collector down or gone, unwritable file.
+   * A file or stream that failed stays failed; a socket is reconnected.
+   */
+  onError?: (err: Error) => void;
+  /** First socket reconnect delay, in ms, doubled after each failure. Default 100. */
+  reconnectDelay?: number;
+  /** Longest socket reconnect delay, in ms. Default 30000. */
+  maxReconnectDelay?: number;
+}
+
+/**
+ * Writes encoded snapshots to a file, a UNIX socket or any writable stream.
+ *
+ * Each socket connection is a stream of its own: it starts with the header
+ * and a keyframe. Snapshots written while disconnected are dropped, since
+ * the next keyframe supersedes them.
+ */
+export class SnapshotExporter {
+  private readonly encoder: SnapshotEncoder;
+  private readonly onError: (err: Error) => void;
+  private readonly socket: string | null = null;
+  private readonly minDelay: number;
+  private readonly maxDelay: number;
+  private out: Writable | null = null;
+  /** Terminal error of a file or stream destination. */
+  private error: Error | null = null;
+  private delay: number;
+  private timer: NodeJS.Timeout | null = null;
+  private closed = false;
+
+  constructor(options: SnapshotExporterOptions) {
+    let header = options.header;
+    this.onError = options.onError ?? (() => {});
+    this.minDelay = Math.max(1, options.reconnectDelay ?? 100);
+    this.maxDelay = Math.max(this.minDelay, options.maxReconnectDelay ?? 30_000);
+    this.delay = this.minDelay;
+    if (options.stream) {
+      this.attach(options.stream);
+    } else if (options.path) {
+      let size = 0;
+      try {
+        size = fs.statSync(options.path).size;
+      } catch {
+        // new file
+      }
+      if (size > 0) header = false;
+      this.attach(fs.createWriteStream(options.path, { flags: 'a' }));
+    } else if (options.socket) {
+      this.socket = options.socket;
+    } else {
+      throw new TypeError('SnapshotExporter needs a path, socket or stream');
+    }
+    this.encoder = new SnapshotEncoder({ ...options, header });
+    if (this.socket) this.connect();
+  }
+
+  private attach(out: Writable): void {
+    this.out = out;
+    out.on('error', err => {
+      this.error ??= err;
+      this.onError(err);
+    });
+  }
+
+  private connect(): void {
+    const sock = net.createConnection(this.socket!);
+    this.out = sock;
+    this.encoder.restart();
+    sock.on('connect', () => { this.delay = this.minDelay; });
+    sock.on('error', err => this.onError(err));
+    // 'close' follows every error: retry from there.
+    sock.on('close', () => {
+      if (this.out === sock) this.out = null;
+      if (this.closed) return;
+      this.timer = setTimeout(() => {
+        this.timer = null;
+        if (!this.closed) this.connect();
+      }, this.delay);
+      this.timer.unref();
+      this.delay = Math.min(this.maxDelay, this.delay * 2);
+    });
+  }
+
+  /**
+   * Writes one snapshot. Returns `false` when the destination is backed up;
+   * wait for `drained()` before writing more.
+   *
+   * @throws If the file or stream destination has failed.
+   */
+  write(statuses: ReadonlyArray<ServiceStatus | ServiceStatusError>, timestamp = Date.now()): boolean {
+    if (this.error) throw this.error;
+    if (this.closed) throw new Error('SnapshotExporter is closed');
+    // Socket between connections: dropped, the next connection starts with a keyframe.
+    if (!this.out) return true;
+    return this.out.write(this.encoder.encode(statuses, timestamp));
+  }
+
+  /**
+   * Resolves once the destination accepts writes again (or a socket
+   * dropped). Rejects if the file or stream destination has failed.
+   */
+  drained(): Promise<void> {
+    const out = this.out;
+    if (this.error) return Promise.reject(this.error);
+    if (!out || !out.writableNeedDrain) return Promise.resolve();
+    return new Promise((resolve, reject) => {
+      const done = () => {
+        out.off('drain', done);
+        out.off('close', done);
+        if (this.error) reject(this.error);
+        else resolve();
+      };
+      out.once('drain', done);
+      out.once('close', done);
+    });
+  }
+
+  /** Flushes and closes the destination. Rejects if a file or stream destination failed. */
+  close(): Promise<void> {
+    this.closed = true;
+    if (this.timer) clearTimeout(this.timer);
+    this.timer = null;
+    const out = this.out;
+    if (!out || out.destroyed) return this.error ? Promise.reject(this.error) : Promise.resolve();
+    return new Promise((resolve, reject) => {
+      finished(out, err => {
+        // Socket errors were reported through onError already.
+        if (err && !this.socket) reject(this.error ?? err);
+        else resolve();
+      });
+      out.end();
+    });
+  }
+}
@@ -0,0 +1,108 @@
+'use strict';
+
+/**
+ * HDR-style histogram of non-negative integer values.
+ *
+ * Buckets are log-linear: values below 128 are exact, above that each power
+ * of two is split into 64 sub-buckets, so any recorded value is reported
+ * within 1/64 (≈1.6%) of its true value, whatever its magnitude. Memory is a
+ * fixed array of counters (≈23 KB), allocated on the first recorded value so
+ * that empty histograms — most services never transition — cost nothing;
+ * recording is O(1).
+ */
+
+// ─── Bucketing ────────────────────────────────────────────────────────────────
+
+const SUB_BUCKETS = 64;                      // per power of two, above the linear range
+const LINEAR = SUB_BUCKETS * 2;              // values below this are exact
+const MAX_EXPONENT = 44;                     // ≈ 2^51 — enough for µs over centuries
+const BUCKETS = LINEAR + MAX_EXPONENT * SUB_BUCKETS;
+
+function bucketOf(value: number): number {
+  if (value < LINEAR) return value;
+  // value / 2^exponent falls in [64, 128); log2 may be off by one at powers of two
+  let exponent = Math.floor(Math.log2(value)) - 6;
+  let sub = Math.floor(value / 2 ** exponent);
+  if (sub >= LINEAR) sub = Math.floor(value / 2 ** ++exponent);
+  else if (sub < SUB_BUCKETS) sub = Math.floor(value / 2 ** --exponent);
+  if (exponent > MAX_EXPONENT) return BUCKETS - 1;
+  return LINEAR + (exponent - 1) * SUB_BUCKETS + (sub - SUB_BUCKETS);
+}
+
+/** Highest value that lands in `bucket`. */
+function bucketMax(bucket: number): number {
+  if (bucket < LINEAR) return bucket;
+  const exponent = Math.floor((bucket - LINEAR) / SUB_BUCKETS) + 1;
+  const sub = (bucket - LINEAR) % SUB_BUCKETS + SUB_BUCKETS;
+  return (sub + 1) * 2 ** exponent - 1;
+}
+
+// ─── Histogram ────────────────────────────────────────────────────────────────
+
+/** Summary of a histogram, as returned by `Histogram.snapshot()`. */
+export interface HistogramSnapshot {
+  count: number;
+  min: number;
+  max: number;
+  mean: number;
+  p50: number;
+  p90: number;
+  p99: number;
+  p999: number;
+}
+
+export class Histogram {
+  private counts: Float64Array | null = null;
+  private total = 0;
+  private sum = 0;
+  private lowest = Infinity;
+  private highest = 0;
+
+  /** Records `value` (rounded down to an integer; negative values count as 0). */
+  record(value: number): void {
+    const v = Math.max(0, Math.floor(value));
+    if (!Number.isFinite(v)) return;
+    (this.counts ??= new Float64Array(BUCKETS))[bucketOf(v)]++;
+    this.total++;
+    this.sum += v;
+    if (v < this.lowest) this.lowest = v;
+    if (v > this.highest) this.highest = v;
+  }
+
+  get count(): number {
+    return this.total;
+  }
+
+  /** Value at percentile `p` (0–100), within the bucket precision. */
+  percentile(p: number): number {
+    if (this.total === 0 || !this.counts) return 0;
+    const rank = Math.max(1, Math.ceil((Math.min(100, Math.max(0, p)) / 100) * this.total));
+    let seen = 0;
+    for (let b = 0; b < BUCKETS; b++) {
+      seen += this.counts[b];
+      if (seen >= rank) return Math.min(this.highest, Math.max(this.lowest, bucketMax(b)));
+    }
+    return this.highest;
+  }
+
+  snapshot(): HistogramSnapshot {
+    return {
+      count: this.total,
+      min:   this.total ? this.lowest : 0,
+      max:   this.highest,
+      mean:  this.total ? this.sum / this.total : 0,
+      p50:   this.percentile(50),
+      p90:   this.percentile(90),
+      p99:   this.percentile(99),
+      p999:  this.percentile(99.9)
+    };
+  }
+
+  reset(): void {
+    this.counts = null;
+    this.total = 0;
+    this.sum = 0;
+    this.lowest = Infinity;
+    this.highest = 0;
+  }
+}
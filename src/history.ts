@@ -0,0 +1,425 @@
+'use strict';
+
+/**
+ * Durable on-host history of service states and resource use, in a local
+ * SQLite database (`node:sqlite`, Node ≥ 22.5).
+ *
+ * - **Transitions**: every state change observed by the library's watchers
+ *   (or passed to `observe()`), one row each.
+ * - **Samples**: numeric metrics per service (`fds`, `tasks`, `memory` from
+ *   the limit sampler, or anything passed to `recordSample()`).
+ *
+ * Writes are buffered and flushed as one transaction every `flushInterval`
+ * ms (or `maxBatch` rows), so the database sees a handful of commits per
+ * second at most, whatever the event rate.
+ *
+ * Compaction rolls raw samples up into 1-minute buckets and those into
+ * 1-hour buckets (count, sum, min, max), then drops each level past its
+ * retention. Watermarks in a `meta` table make each bucket be rolled up
+ * exactly once.
+ */
+
+import { ServiceChange, ServiceWatcher } from './types';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+export interface HistoryRetention {
+  /** Raw samples, in ms. Default 24 h. */
+  raw?: number;
+  /** 1-minute rollups, in ms. Default 30 days. */
+  minute?: number;
+  /** 1-hour rollups and transitions, in ms. Default 400 days. */
+  hour?: number;
+}
+
+export interface HistoryOptions {
+  /** Max time a write stays buffered, in ms. Default 1000. */
+  flushInterval?: number;
+  /** Buffered rows that trigger an immediate flush. Default 1000. */
+  maxBatch?: number;
+  /** Time between compactions, in ms. Default 60000. */
+  compactInterval?: number;
+  retention?: HistoryRetention;
+  /** Called when a flush or compaction fails; buffered rows are kept. */
+  onError?: (err: Error) => void;
+}
+
+export type HistoryResolution = 'raw' | 'minute' | 'hour';
+
+export interface HistoryRange {
+  /** Start, ms since the Unix epoch. Default: `to` minus one hour. */
+  from?: number;
+  /** End (exclusive), ms since the Unix epoch. Default: now. */
+  to?: number;
+  /**
+   * Sample resolution. Default: the finest one still retained for `from`
+   * and giving at most ~1500 points per metric.
+   */
+  resolution?: HistoryResolution;
+  /** Only these metrics. Default: all. */
+  metrics?: readonly string[];
+}
+
+export interface HistoryTransition {
+  timestamp: number;
+  from: string | null;
+  to: string;
+  pid: number;
+}
+
+/** One sample, or one rollup bucket (`timestamp` is the bucket start). */
+export interface HistoryPoint {
+  timestamp: number;
+  metric: string;
+  count: number;
+  min: number;
+  max: number;
+  mean: number;
+}
+
+export interface HistoryResult {
+  name: string;
+  from: number;
+  to: number;
+  resolution: HistoryResolution;
+  transitions: HistoryTransition[];
+  samples: HistoryPoint[];
+}
+
+const MINUTE = 60_000;
+const HOUR = 3_600_000;
+const BUCKET: Record<Exclude<HistoryResolution, 'raw'>, number> = { minute: MINUTE, hour: HOUR };
+
+const SCHEMA = `
+  CREATE TABLE IF NOT EXISTS transitions (
+    service TEXT NOT NULL, ts INTEGER NOT NULL, from_state TEXT, to_state TEXT NOT NULL, pid INTEGER NOT NULL
+  );
+  CREATE INDEX IF NOT EXISTS transitions_service_ts ON transitions (service, ts);
+  CREATE INDEX IF NOT EXISTS transitions_ts ON transitions (ts);
+  CREATE TABLE IF NOT EXISTS samples (
+    service TEXT NOT NULL, metric TEXT NOT NULL, ts INTEGER NOT NULL, value REAL NOT NULL
+  );
+  CREATE INDEX IF NOT EXISTS samples_service_metric_ts ON samples (service, metric, ts);
+  -- Compaction and retention select by time across every service.
+  CREATE INDEX IF NOT EXISTS samples_ts ON samples (ts);
+  CREATE TABLE IF NOT EXISTS rollups (
+    resolution INTEGER NOT NULL, service TEXT NOT NULL, metric TEXT NOT NULL, bucket INTEGER NOT NULL,
+    count INTEGER NOT NULL, sum REAL NOT NULL, min REAL NOT NULL, max REAL NOT NULL,
+    PRIMARY KEY (resolution, service, metric, bucket)
+  ) WITHOUT ROWID;
+  CREATE INDEX IF NOT EXISTS rollups_resolution_bucket ON rollups (resolution, bucket);
+  CREATE TABLE IF NOT EXISTS meta (key TEXT PRIMARY KEY, value INTEGER NOT NULL) WITHOUT ROWID;
+`;
+
+/** Merges freshly rolled-up rows with buckets rolled up earlier. */
+const ROLLUP_UPSERT = `
+  ON CONFLICT (resolution, service, metric, bucket) DO UPDATE SET
+    count = count + excluded.count, sum = sum + excluded.sum,
+    min = min(min, excluded.min), max = max(max, excluded.max)`;
+
+// ─── Store ────────────────────────────────────────────────────────────────────
+
+type Database = import('node:sqlite').DatabaseSync;
+type Statement = import('node:sqlite').StatementSync;
+
+function openDatabase(file: string): Database {
+  let sqlite: typeof import('node:sqlite');
+  try {
+    sqlite = require('node:sqlite');
+  } catch {
+    throw new Error(`history requires node:sqlite (Node >= 22.5), not available in Node ${process.versions.node}`);
+  }
+  return new sqlite.DatabaseSync(file);
+}
+
+export class HistoryStore {
+  private readonly db: Database;
+  private readonly insertTransition: Statement;
+  private readonly insertSample: Statement;
+  private readonly flushInterval: number;
+  private readonly maxBatch: number;
+  private readonly retention: Required<HistoryRetention>;
+  private readonly onError: (err: Error) => void;
+
+  private transitionRows: Array<[string, number, string | null, string, number]> = [];
+  private sampleRows: Array<[string, string, number, number]> = [];
+  /** Last recorded state per service, so unchanged observations are not stored. */
+  private readonly lastState = new Map<string, string>();
+  private flushTimer: NodeJS.Timeout | null = null;
+  private compactTimer: NodeJS.Timeout | null = null;
+  private closed = false;
+
+  /**
+   * Opens (or creates) the database at `file`.
+   * @throws If `node:sqlite` is unavailable or the file cannot be opened.
+   */
+  constructor(file: string, options: HistoryOptions = {}) {
+    this.flushInterval = Math.max(0, options.flushInterval ?? 1000);
+    this.maxBatch = Math.max(1, options.maxBatch ?? 1000);
+    this.retention = {
+      raw:    options.retention?.raw ?? 24 * HOUR,
+      minute: options.retention?.minute ?? 30 * 24 * HOUR,
+      hour:   options.retention?.hour ?? 400 * 24 * HOUR
+    };
+    this.onError = options.onError ?? (() => {});
+
+    this.db = openDatabase(file);
+    this.db.exec('PRAGMA journal_mode = WAL; PRAGMA synchronous = NORMAL;');
+    this.db.exec(SCHEMA);
+    this.insertTransition = this.db.prepare(
+      'INSERT INTO transitions (service, ts, from_state, to_state, pid) VALUES (?, ?, ?, ?, ?)');
+    this.insertSample = this.db.prepare('INSERT INTO samples (service, metric, ts, value) VALUES (?, ?, ?, ?)');
+
+    const compactInterval = options.compactInterval ?? MINUTE;
+    if (compactInterval > 0) {
+      this.compactTimer = setInterval(() => {
+        try {
+          this.compact();
+        } catch (err) {
+          this.onError(err as Error);
+        }
+      }, compactInterval);
+      this.compactTimer.unref();
+    }
+  }
+
+  /** Records a state transition. Observations repeating the last recorded state are ignored. */
+  observe(change: ServiceChange): void {
+    const { name, current } = change;
+    const last = this.lastState.get(name) ?? (change.previous ? change.previous.state : null);
+    if (last === current.state) {
+      this.lastState.set(name, current.state);
+      return;
+    }
+    this.lastState.set(name, current.state);
+    this.transitionRows.push([name, change.timestamp, last, current.state, current.pid]);
+    this.schedule();
+  }
+
+  /** Records numeric metrics of a service at `timestamp`. Non-finite values are skipped. */
+  recordSample(name: string, metrics: Record<string, number | null>, timestamp = Date.now()): void {
+    for (const [metric, value] of Object.entries(metrics)) {
+      if (typeof value === 'number' && Number.isFinite(value)) this.sampleRows.push([name, metric, timestamp, value]);
+    }
+    this.schedule();
+  }
+
+  /** Writes buffered rows in one transaction. */
+  flush(): void {
+    if (this.flushTimer) clearTimeout(this.flushTimer);
+    this.flushTimer = null;
+    if (this.transitionRows.length === 0 && this.sampleRows.length === 0) return;
+    const transitions = this.transitionRows;
+    const samples = this.sampleRows;
+    this.transaction(() => {
+      for (const row of transitions) this.insertTransition.run(...row);
+      for (const row of samples) this.insertSample.run(...row);
+    });
+    this.transitionRows = [];
+    this.sampleRows = [];
+  }
+
+  /**
+   * Rolls complete minutes of raw samples into 1-minute buckets and complete
+   * hours of those into 1-hour buckets, then applies retention.
+   */
+  compact(now = Date.now()): void {
+    this.flush();
+    this.transaction(() => {
+      // Leave one interval of slack for samples still being buffered elsewhere.
+      const minutesUntil = Math.floor((now - MINUTE) / MINUTE) * MINUTE;
+      this.rollUp('samples', 'ts', 'value', MINUTE, minutesUntil);
+      // An hour is rolled up only once all of its minutes have been.
+      this.rollUp('rollups', 'bucket', null, HOUR, Math.floor(minutesUntil / HOUR) * HOUR);
+      this.db.prepare('DELETE FROM samples WHERE ts < ?').run(now - this.retention.raw);
+      this.db.prepare('DELETE FROM rollups WHERE resolution = ? AND bucket < ?').run(MINUTE, now - this.retention.minute);
+      this.db.prepare('DELETE FROM rollups WHERE resolution = ? AND bucket < ?').run(HOUR, now - this.retention.hour);
+      this.db.prepare('DELETE FROM transitions WHERE ts < ?').run(now - this.retention.hour);
+    });
+  }
+
+  /** Transitions and samples of `name` within `range`. Buffered rows are flushed first. */
+  query(name: string, range: HistoryRange = {}): HistoryResult {
+    this.flush();
+    const to = range.to ?? Date.now();
+    const from = range.from ?? to - HOUR;
+    const resolution = range.resolution ?? this.autoResolution(from, to);
+
+    const transitions = (this.db.prepare(
+      'SELECT ts, from_state, to_state, pid FROM transitions WHERE service = ? AND ts >= ? AND ts < ? ORDER BY ts'
+    ).all(name, from, to) as any[]).map(r => ({ timestamp: r.ts, from: r.from_state, to: r.to_state, pid: r.pid }));
+
+    const metricFilter = range.metrics && range.metrics.length > 0
+      ? ` AND metric IN (${range.metrics.map(() => '?').join(', ')})`
+      : '';
+    const metricArgs = range.metrics ?? [];
+    let rows: any[];
+    if (resolution === 'raw') {
+      rows = this.db.prepare(
+        `SELECT ts, metric, 1 AS count, value AS sum, value AS min, value AS max FROM samples
+         WHERE service = ? AND ts >= ? AND ts < ?${metricFilter} ORDER BY metric, ts`
+      ).all(name, from, to, ...metricArgs) as any[];
+    } else {
+      const size = BUCKET[resolution];
+      rows = this.db.prepare(
+        `SELECT bucket AS ts, metric, count, sum, min, max FROM rollups
+         WHERE resolution = ? AND service = ? AND bucket >= ? AND bucket < ?${metricFilter} ORDER BY metric, bucket`
+      ).all(size, name, Math.floor(from / size) * size, to, ...metricArgs) as any[];
+    }
+    const samples = rows.map(r => ({
+      timestamp: r.ts, metric: r.metric, count: r.count, min: r.min, max: r.max, mean: r.sum / r.count
+    }));
+    return { name, from, to, resolution, transitions, samples };
+  }
+
+  close(): void {
+    if (this.closed) return;
+    this.closed = true;
+    if (this.compactTimer) clearInterval(this.compactTimer);
+    try {
+      this.flush();
+    } finally {
+      this.db.close();
+    }
+  }
+
+  private schedule(): void {
+    if (this.closed) return;
+    if (this.transitionRows.length + this.sampleRows.length >= this.maxBatch) {
+      this.safeFlush();
+    } else if (!this.flushTimer) {
+      this.flushTimer = setTimeout(() => this.safeFlush(), this.flushInterval);
+    }
+  }
+
+  private safeFlush(): void {
+    try {
+      this.flush();
+    } catch (err) {
+      this.onError(err as Error);
+    }
+  }
+
+  private transaction(fn: () => void): void {
+    this.db.exec('BEGIN');
+    try {
+      fn();
+      this.db.exec('COMMIT');
+    } catch (err) {
+      this.db.exec('ROLLBACK');
+      throw err;
+    }
+  }
+
+  /**
+   * Folds rows of `source` from the last watermark up to `until` into buckets
+   * of `size` ms. `valueColumn` is null when the source is itself a rollup.
+   */
+  private rollUp(source: 'samples' | 'rollups', tsColumn: string, valueColumn: string | null, size: number, until: number): void {
+    const key = `rollup.${size}`;
+    const row = this.db.prepare('SELECT value FROM meta WHERE key = ?').get(key) as { value: number } | undefined;
+    const since = row ? row.value : 0;
+    if (until <= since) return;
+    const aggregates = valueColumn
+      ? `COUNT(*), SUM(${valueColumn}), MIN(${valueColumn}), MAX(${valueColumn})`
+      : 'SUM(count), SUM(sum), MIN(min), MAX(max)';
+    const where = valueColumn ? '' : ` AND resolution = ${MINUTE}`;
+    this.db.prepare(
+      `INSERT INTO rollups (resolution, service, metric, bucket, count, sum, min, max)
+       SELECT ?1, service, metric, CAST(${tsColumn} / ?1 AS INTEGER) * ?1, ${aggregates} FROM ${source}
+       WHERE ${tsColumn} >= ?2 AND ${tsColumn} < ?3${where}
+       GROUP BY service, metric, CAST(${tsColumn} / ?1 AS INTEGER)
+       ${ROLLUP_UPSERT}`
+    ).run(size, since, until);
+    this.db.prepare('INSERT INTO meta (key, value) VALUES (?, ?) ON CONFLICT (key) DO UPDATE SET value = excluded.value')
+      .run(key, until);
+  }
+
+  private autoResolution(from: number, to: number): HistoryResolution {
+    const now = Date.now();
+    const span = to - from;
+    if (from >= now - this.retention.raw && span <= 6 * HOUR) return 'raw';
+    if (from >= now - this.retention.minute && span <= 1500 * MINUTE) return 'minute';
+    return 'hour';
+  }
+}
+
+// ─── Library-wide store ───────────────────────────────────────────────────────
+
+export interface EnableHistoryOptions extends HistoryOptions {
+  /** Services whose resource use is sampled every `sampleInterval`. Default none. */
+  services?: readonly string[];
+  /** Time between resource samples, in ms. Default 60000. */
+  sampleInterval?: number;
+}
+
+let active: { store: HistoryStore; sampler: ServiceWatcher | null } | null = null;
+
+/** Feeds the library-wide store, if enabled. Called by the watchers. */
+export function recordHistory(change: ServiceChange): void {
+  if (active) active.store.observe(change);
+}
+
+/**
+ * Starts recording every transition seen by the library's watchers (and
+ * resource samples of `options.services`) to the database at `file`.
+ * Replaces any store enabled before.
+ */
+export function enableHistory(file: string, options: EnableHistoryOptions = {}): HistoryStore {
+  disableHistory();
+  const store = new HistoryStore(file, options);
+  let sampler: ServiceWatcher | null = null;
+  if (options.services && options.services.length > 0) {
+    sampler = startSampling(store, options.services, options.sampleInterval ?? MINUTE, options.onError ?? (() => {}));
+  }
+  active = { store, sampler };
+  return store;
+}
+
+/** Stops recording and closes the library-wide store. */
+export function disableHistory(): void {
+  if (!active) return;
+  const { store, sampler } = active;
+  active = null;
+  sampler?.close();
+  store.close();
+}
+
+/**
+ * Reads the history of `name` from the library-wide store.
+ * @throws If history is not enabled.
+ */
+export function queryHistory(name: string, range?: HistoryRange): HistoryResult {
+  if (!active) throw new Error('history is not enabled; call enableHistory() first');
+  return active.store.query(name, range);
+}
+
+function startSampling(
+  store: HistoryStore, services: readonly string[], interval: number, onError: (err: Error) => void
+): ServiceWatcher {
+  const { LimitSampler }: typeof import('./limits') = require('./limits');
+  const sampler = new LimitSampler(services);
+  let closed = false;
+  let timer: NodeJS.Timeout | null = null;
+  const tick = async () => {
+    try {
+      const now = Date.now();
+      for (const report of await sampler.sample()) {
+        if (!closed && report.pid > 0) store.recordSample(report.name, report.used, now);
+      }
+    } catch (err) {
+      if (!closed) onError(err as Error);
+    }
+    if (!closed) {
+      timer = setTimeout(() => { void tick(); }, interval);
+      timer.unref();
+    }
+  };
+  void tick();
+  return {
+    close() {
+      closed = true;
+      if (timer) clearTimeout(timer);
+    }
+  };
+}
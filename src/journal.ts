@@ -0,0 +1,290 @@
+'use strict';
+
+/**
+ * Minimal sd-journal (libsystemd.so.0) bindings via koffi.
+ *
+ * Entries are read one field at a time with `sd_journal_get_data`, so only
+ * the fields a caller asks for are ever copied out of the mmapped journal
+ * files. Following is done with `sd_journal_wait` issued through koffi's
+ * asynchronous calls: one libuv threadpool thread blocks on the journal's
+ * inotify descriptor while the event loop stays free.
+ *
+ * A journal handle is not thread-safe; waits and reads are strictly
+ * serialized (the next wait is only issued once the entries it announced
+ * have been read on the main thread).
+ */
+
+import { ServiceWatcher } from './types';
+
+// ─── Bindings ────────────────────────────────────────────────────────────────
+
+/** Opaque native pointer (sd_journal *). */
+export type JournalPtr = object;
+
+interface JournalBindings {
+  koffi: any;
+  sd_journal_open: (ret: [JournalPtr | null], flags: number) => number;
+  sd_journal_close: (j: JournalPtr) => void;
+  sd_journal_add_match: (j: JournalPtr, data: Buffer, size: number) => number;
+  sd_journal_add_disjunction: (j: JournalPtr) => number;
+  sd_journal_flush_matches: (j: JournalPtr) => void;
+  sd_journal_seek_head: (j: JournalPtr) => number;
+  sd_journal_seek_tail: (j: JournalPtr) => number;
+  sd_journal_seek_realtime_usec: (j: JournalPtr, usec: number | bigint) => number;
+  sd_journal_next: (j: JournalPtr) => number;
+  sd_journal_previous: (j: JournalPtr) => number;
+  sd_journal_get_data: (j: JournalPtr, field: string, data: [object | null], length: [number]) => number;
+  sd_journal_get_realtime_usec: (j: JournalPtr, ret: [number | bigint]) => number;
+  sd_journal_set_data_threshold: (j: JournalPtr, size: number) => number;
+  sd_journal_wait: any;
+}
+
+/** `sd_journal_open` flags. */
+export const SD_JOURNAL_LOCAL_ONLY = 1;
+export const SD_JOURNAL_SYSTEM     = 4;
+
+/** `sd_journal_wait` results. */
+const SD_JOURNAL_NOP = 0;
+
+let _journal: JournalBindings | null = null;
+let _journalAvailable: boolean | null = null;
+
+/**
+ * Loads the sd-journal part of libsystemd.so.0 once. Returns `false` when
+ * koffi or the library is unavailable.
+ */
+export function tryLoadJournal(): boolean {
+  if (_journalAvailable !== null) return _journalAvailable;
+  try {
+    const koffi = require('koffi');
+    const lib = koffi.load('libsystemd.so.0');
+    _journal = {
+      koffi,
+      sd_journal_open: lib.func('int sd_journal_open(_Out_ void **ret, int flags)'),
+      sd_journal_close: lib.func('void sd_journal_close(void *j)'),
+      sd_journal_add_match: lib.func('int sd_journal_add_match(void *j, const void *data, size_t size)'),
+      sd_journal_add_disjunction: lib.func('int sd_journal_add_disjunction(void *j)'),
+      sd_journal_flush_matches: lib.func('void sd_journal_flush_matches(void *j)'),
+      sd_journal_seek_head: lib.func('int sd_journal_seek_head(void *j)'),
+      sd_journal_seek_tail: lib.func('int sd_journal_seek_tail(void *j)'),
+      sd_journal_seek_realtime_usec: lib.func('int sd_journal_seek_realtime_usec(void *j, uint64_t usec)'),
+      sd_journal_next: lib.func('int sd_journal_next(void *j)'),
+      sd_journal_previous: lib.func('int sd_journal_previous(void *j)'),
+      sd_journal_get_data: lib.func(
+        'int sd_journal_get_data(void *j, str field, _Out_ void **data, _Out_ size_t *length)'
+      ),
+      sd_journal_get_realtime_usec: lib.func('int sd_journal_get_realtime_usec(void *j, _Out_ uint64_t *ret)'),
+      sd_journal_set_data_threshold: lib.func('int sd_journal_set_data_threshold(void *j, size_t sz)'),
+      sd_journal_wait: lib.func('int sd_journal_wait(void *j, uint64_t timeout_usec)')
+    };
+    _journalAvailable = true;
+  } catch {
+    _journalAvailable = false;
+  }
+  return _journalAvailable;
+}
+
+function bindings(): JournalBindings {
+  if (!tryLoadJournal()) throw new Error('libsystemd (sd-journal) is not available');
+  return _journal!;
+}
+
+function check(r: number, what: string): number {
+  if (r < 0) throw new Error(`${what} failed (errno ${-r})`);
+  return r;
+}
+
+// ─── Journal ─────────────────────────────────────────────────────────────────
+
+export class Journal {
+  private j: JournalPtr | null;
+
+  /**
+   * Opens the journal files of this host (`SD_JOURNAL_LOCAL_ONLY` by default).
+   * @throws If libsystemd is unavailable or the journal cannot be opened.
+   */
+  constructor(flags = SD_JOURNAL_LOCAL_ONLY) {
+    const ref: [JournalPtr | null] = [null];
+    check(bindings().sd_journal_open(ref, flags), 'sd_journal_open');
+    this.j = ref[0];
+  }
+
+  private get handle(): JournalPtr {
+    if (!this.j) throw new Error('journal is closed');
+    return this.j;
+  }
+
+  /**
+   * Adds a `FIELD=value` match. Matches on different fields are ANDed, on the
+   * same field ORed; `or()` starts a new alternative.
+   */
+  match(match: string): this {
+    const data = Buffer.from(match, 'utf8');
+    check(bindings().sd_journal_add_match(this.handle, data, data.length), 'sd_journal_add_match');
+    return this;
+  }
+
+  or(): this {
+    check(bindings().sd_journal_add_disjunction(this.handle), 'sd_journal_add_disjunction');
+    return this;
+  }
+
+  clearMatches(): this {
+    bindings().sd_journal_flush_matches(this.handle);
+    return this;
+  }
+
+  seekHead(): this {
+    check(bindings().sd_journal_seek_head(this.handle), 'sd_journal_seek_head');
+    return this;
+  }
+
+  /** Positions after the last entry: `next()` then returns only new entries. */
+  seekTail(): this {
+    const lib = bindings();
+    check(lib.sd_journal_seek_tail(this.handle), 'sd_journal_seek_tail');
+    // seek_tail alone leaves the position unresolved; step onto the last entry.
+    lib.sd_journal_previous(this.handle);
+    return this;
+  }
+
+  /** Positions before the first entry at or after `ms` (Unix epoch). */
+  seekTime(ms: number): this {
+    check(bindings().sd_journal_seek_realtime_usec(this.handle, Math.max(0, Math.floor(ms * 1000))),
+      'sd_journal_seek_realtime_usec');
+    return this;
+  }
+
+  /** Advances to the next matching entry. Returns `false` at the end. */
+  next(): boolean {
+    return check(bindings().sd_journal_next(this.handle), 'sd_journal_next') > 0;
+  }
+
+  /** Value of `field` in the current entry, or `null` if it has none. */
+  field(field: string): string | null {
+    const lib = bindings();
+    const data: [object | null] = [null];
+    const length: [number] = [0];
+    if (lib.sd_journal_get_data(this.handle, field, data, length) < 0 || data[0] === null) return null;
+    const entry = lib.koffi.decode(data[0], 'char', Number(length[0])) as string;
+    return entry.slice(field.length + 1);        // "FIELD=value"
+  }
+
+  /**
+   * Size of `field`'s value in the current entry, in bytes, or `null` if it
+   * has none. Nothing is copied out of the journal file.
+   */
+  fieldLength(field: string): number | null {
+    const data: [object | null] = [null];
+    const length: [number] = [0];
+    if (bindings().sd_journal_get_data(this.handle, field, data, length) < 0 || data[0] === null) return null;
+    return Math.max(0, Number(length[0]) - field.length - 1);
+  }
+
+  /**
+   * Caps how much of a field `field`/`fieldLength` return (and decompress),
+   * in bytes; `0` for no cap. The default cap is 64 KiB.
+   */
+  setDataThreshold(bytes: number): this {
+    check(bindings().sd_journal_set_data_threshold(this.handle, Math.max(0, Math.floor(bytes))),
+      'sd_journal_set_data_threshold');
+    return this;
+  }
+
+  /** Reads `fields` of the current entry; missing fields are left out. */
+  fields(fields: readonly string[]): Record<string, string> {
+    const out: Record<string, string> = {};
+    for (const f of fields) {
+      const value = this.field(f);
+      if (value !== null) out[f] = value;
+    }
+    return out;
+  }
+
+  /** Wall-clock time of the current entry, in ms since the Unix epoch. */
+  time(): number {
+    const ret: [number | bigint] = [0];
+    check(bindings().sd_journal_get_realtime_usec(this.handle, ret), 'sd_journal_get_realtime_usec');
+    return Number(ret[0]) / 1000;
+  }
+
+  /**
+   * Waits up to `timeoutMs` for the journal to change, on a threadpool
+   * thread. Resolves to `false` on timeout.
+   */
+  wait(timeoutMs: number): Promise<boolean> {
+    const j = this.handle;
+    return new Promise((resolve, reject) => {
+      bindings().sd_journal_wait.async(j, Math.floor(timeoutMs * 1000), (err: Error | null, r: number) => {
+        if (err) reject(err);
+        else if (r < 0) reject(new Error(`sd_journal_wait failed (errno ${-r})`));
+        else resolve(r !== SD_JOURNAL_NOP);
+      });
+    });
+  }
+
+  close(): void {
+    if (this.j) bindings().sd_journal_close(this.j);
+    this.j = null;
+  }
+}
+
+// ─── Following ───────────────────────────────────────────────────────────────
+
+/**
+ * Calls `onEntry` for every entry after the journal's current position,
+ * with the journal positioned on it, until closed. Closes the journal when
+ * following stops.
+ */
+export function followEntries(
+  journal: Journal,
+  onEntry: (journal: Journal) => void,
+  onError: (err: Error) => void = () => {}
+): ServiceWatcher {
+  let closed = false;
+  const loop = async () => {
+    while (!closed) {
+      try {
+        // Bounded waits, so close() is noticed promptly by the waiting thread.
+        // Drain after every wait: reading past the end is cheap, and entries
+        // written before the first wait armed inotify are not missed.
+        await journal.wait(250);
+        while (!closed && journal.next()) onEntry(journal);
+      } catch (e) {
+        if (!closed) onError(e as Error);
+        break;
+      }
+    }
+    journal.close();
+  };
+  void loop();
+
+  return {
+    close() {
+      closed = true;
+    }
+  };
+}
+
+/**
+ * Calls `listener` with `fields` of every new entry matching `matches`
+ * (ANDed, or ORed on the same field) until closed.
+ *
+ * @throws If libsystemd is unavailable or the journal cannot be opened.
+ */
+export function followJournal(
+  matches: readonly string[],
+  fields: readonly string[],
+  listener: (entry: Record<string, string>, time: number) => void,
+  onError: (err: Error) => void = () => {}
+): ServiceWatcher {
+  const journal = new Journal();
+  try {
+    for (const m of matches) journal.match(m);
+    journal.seekTail();
+  } catch (e) {
+    journal.close();
+    throw e;
+  }
+  return followEntries(journal, j => listener(j.fields(fields), j.time()), onError);
+}
@@ -0,0 +1,302 @@
+'use strict';
+
+/**
+ * Early warning for resource-limit exhaustion.
+ *
+ * A service running out of file descriptors, tasks or memory usually stays
+ * `RUNNING` while it fails requests. This sampler compares what each service
+ * uses with what it is allowed:
+ *
+ * | Resource | Used                                          | Limit                              |
+ * | -------- | --------------------------------------------- | ---------------------------------- |
+ * | `fds`    | open FDs of its busiest process               | that process's `RLIMIT_NOFILE`     |
+ * | `tasks`  | cgroup `pids.current`, else sum of threads    | `TasksMax`, else cgroup `pids.max` |
+ * | `memory` | cgroup `memory.current`, else sum of RSS      | `MemoryMax`, else cgroup `memory.max` |
+ *
+ * Unit limits are fetched in bulk (one bus connection for all services) and
+ * kept until systemd reloads its configuration, detected from the manager's
+ * `UnitsLoadFinishTimestampMonotonic` — one property read per sample. FD
+ * limits are per process (services such as nginx raise their own soft limit),
+ * so they are read from `/proc/<pid>/limits` once per PID.
+ *
+ * FD counts come from the size of `/proc/<pid>/fd` (Linux ≥ 6.2 reports the
+ * number of open descriptors there), listing the directory only on older
+ * kernels.
+ */
+
+import fs from 'fs';
+import { ServiceWatcher } from './types';
+import { probes } from './probe';
+import { getServiceStatus, getUnitProperties, getManagerProperties, detectInitSystem } from './linux';
+import { serviceProcesses, serviceCgroup } from './threads';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+export type LimitResource = 'fds' | 'tasks' | 'memory';
+
+/** `null` means unlimited or unknown. */
+export type ResourceFigures = Record<LimitResource, number | null>;
+
+/** One service at one sample. */
+export interface LimitReport {
+  name: string;
+  /** Main PID; `0` when the service is not running (figures are then `null`). */
+  pid: number;
+  used: ResourceFigures;
+  limits: ResourceFigures;
+  /** The process the `fds` figures are for. */
+  fdPid: number;
+}
+
+export interface LimitWarning {
+  name: string;
+  resource: LimitResource;
+  used: number;
+  limit: number;
+  /** `used / limit`. */
+  utilization: number;
+  /** The threshold that was crossed. */
+  threshold: number;
+  timestamp: number;
+}
+
+export type LimitListener = (warning: LimitWarning) => void;
+
+export interface WatchLimitsOptions {
+  /** Time between samples, in ms. Default 10000. */
+  interval?: number;
+  /** Utilization levels (0–1) that trigger a warning when crossed upwards. Default `[0.8, 0.95]`. */
+  thresholds?: readonly number[];
+  /** Called when a sample fails; sampling continues. */
+  onError?: (err: Error) => void;
+}
+
+const RESOURCES: readonly LimitResource[] = ['fds', 'tasks', 'memory'];
+
+const UNIT_LIMIT_PROPERTIES = ['LimitNOFILESoft', 'TasksMax', 'MemoryMax'];
+
+/** Changes on every daemon-reload. */
+const RELOAD_PROPERTY = 'UnitsLoadFinishTimestampMonotonic';
+
+// ─── Parsing ──────────────────────────────────────────────────────────────────
+
+/**
+ * Converts a limit as reported by D-Bus (UINT64_MAX for infinity), systemctl
+ * (`infinity`) or cgroupfs (`max`) to a number, or `null` when unlimited.
+ */
+export function parseLimit(value: unknown): number | null {
+  const n = typeof value === 'number' ? value : /^\d+$/.test(String(value ?? '').trim()) ? Number(value) : NaN;
+  return Number.isFinite(n) && n > 0 && n < 2 ** 63 ? n : null;
+}
+
+/** The soft `Max open files` limit from `/proc/<pid>/limits`. */
+export function parseNofileLimit(limits: string): number | null {
+  const m = /^Max open files\s+(\S+)/m.exec(limits);
+  return m ? parseLimit(m[1]) : null;
+}
+
+/** Threads and resident bytes from `/proc/<pid>/status`. */
+function parseStatus(status: string): { threads: number; rss: number } {
+  const threads = /^Threads:\s+(\d+)/m.exec(status);
+  const rss = /^VmRSS:\s+(\d+) kB/m.exec(status);
+  return { threads: threads ? Number(threads[1]) : 0, rss: rss ? Number(rss[1]) * 1024 : 0 };
+}
+
+/** Number of open FDs of `pid`, or `null` if they cannot be read. */
+export async function countFds(pid: number): Promise<number | null> {
+  const dir = `/proc/${pid}/fd`;
+  try {
+    const { size } = await fs.promises.stat(dir);
+    if (size > 0) return size;
+    return (await fs.promises.readdir(dir)).length;
+  } catch {
+    return null;
+  }
+}
+
+// ─── Sampler ──────────────────────────────────────────────────────────────────
+
+export class LimitSampler {
+  private readonly names: string[];
+  private readonly systemd = detectInitSystem() === 'systemd';
+  private unitLimits: Array<Record<string, unknown>> | null = null;
+  private reloadStamp: unknown = undefined;
+  /** RLIMIT_NOFILE by PID. */
+  private nofile = new Map<number, number | null>();
+
+  constructor(serviceNames: readonly string[]) {
+    this.names = [...new Set(serviceNames)];
+  }
+
+  /** Samples usage and limits of every service. */
+  async sample(): Promise<LimitReport[]> {
+    if (this.systemd) this.refreshUnitLimits();
+    const statuses = await Promise.all(this.names.map(name => getServiceStatus(name).catch(() => null)));
+    const alive = new Set<number>();
+    const reports = await Promise.all(this.names.map(async (name, i) => {
+      const pid = statuses[i]?.pid ?? 0;
+      if (pid <= 0) return { name, pid, used: nullFigures(), limits: nullFigures(), fdPid: 0 };
+      const report = await this.sampleService(name, pid, this.unitLimits?.[i] ?? {});
+      for (const p of report.pids) alive.add(p);
+      return report.report;
+    }));
+    for (const pid of this.nofile.keys()) if (!alive.has(pid)) this.nofile.delete(pid);
+    return reports;
+  }
+
+  /** Re-reads the unit limits on the first sample and after each daemon-reload. */
+  private refreshUnitLimits(): void {
+    const stamp = getManagerProperties([RELOAD_PROPERTY])[RELOAD_PROPERTY];
+    if (this.unitLimits && stamp === this.reloadStamp) return;
+    this.unitLimits = getUnitProperties(this.names, UNIT_LIMIT_PROPERTIES);
+    this.reloadStamp = stamp;
+    this.nofile.clear();
+  }
+
+  private async sampleService(
+    name: string, pid: number, unit: Record<string, unknown>
+  ): Promise<{ report: LimitReport; pids: number[] }> {
+    const [pids, cgroup] = await Promise.all([serviceProcesses(pid), serviceCgroup(pid)]);
+    const cgroupFile = (file: string) =>
+      (cgroup && cgroup.unified ? probes.read(`${cgroup.dir}/${file}`) : Promise.resolve(null));
+
+    const [fds, statuses, pidsCurrent, memoryCurrent, pidsMax, memoryMax] = await Promise.all([
+      Promise.all(pids.map(countFds)),
+      Promise.all(pids.map(p => probes.read(`/proc/${p}/status`))),
+      cgroupFile('pids.current'),
+      cgroupFile('memory.current'),
+      this.systemd ? null : cgroupFile('pids.max'),
+      this.systemd ? null : cgroupFile('memory.max')
+    ]);
+
+    let fdPid = pid;
+    let fdCount: number | null = null;
+    for (let i = 0; i < pids.length; i++) {
+      const count = fds[i];
+      if (count !== null && (fdCount === null || count > fdCount)) {
+        fdCount = count;
+        fdPid = pids[i];
+      }
+    }
+    if (!this.nofile.has(fdPid)) {
+      const limits = await probes.read(`/proc/${fdPid}/limits`);
+      this.nofile.set(fdPid, limits ? parseNofileLimit(limits) : null);
+    }
+
+    let threads = 0;
+    let rss = 0;
+    for (const status of statuses) {
+      if (!status) continue;
+      const parsed = parseStatus(status);
+      threads += parsed.threads;
+      rss += parsed.rss;
+    }
+
+    return {
+      pids,
+      report: {
+        name,
+        pid,
+        fdPid,
+        used: {
+          fds:    fdCount,
+          tasks:  pidsCurrent ? Number(pidsCurrent) : threads,
+          memory: memoryCurrent ? Number(memoryCurrent) : rss
+        },
+        limits: {
+          fds:    this.nofile.get(fdPid) ?? parseLimit(unit['LimitNOFILESoft']),
+          tasks:  this.systemd ? parseLimit(unit['TasksMax']) : parseLimit(pidsMax),
+          memory: this.systemd ? parseLimit(unit['MemoryMax']) : parseLimit(memoryMax)
+        }
+      }
+    };
+  }
+}
+
+const nullFigures = (): ResourceFigures => ({ fds: null, tasks: null, memory: null });
+
+// ─── Thresholds ───────────────────────────────────────────────────────────────
+
+/**
+ * Turns reports into warnings, edge-triggered: a warning is emitted when
+ * utilization crosses a threshold upwards, and that threshold is re-armed
+ * once utilization falls back below it.
+ */
+export class LimitAlarm {
+  private readonly thresholds: number[];
+  /** Number of thresholds currently exceeded, by service and resource. */
+  private readonly levels = new Map<string, number>();
+
+  constructor(thresholds: readonly number[] = [0.8, 0.95]) {
+    this.thresholds = [...new Set(thresholds)].filter(t => t > 0).sort((a, b) => a - b);
+  }
+
+  check(report: LimitReport, timestamp = Date.now()): LimitWarning[] {
+    const warnings: LimitWarning[] = [];
+    for (const resource of RESOURCES) {
+      const key = `${report.name}\0${resource}`;
+      const used = report.used[resource];
+      const limit = report.limits[resource];
+      if (used === null || limit === null) {
+        this.levels.delete(key);
+        continue;
+      }
+      const utilization = used / limit;
+      const level = this.thresholds.filter(t => utilization >= t).length;
+      if (level > (this.levels.get(key) ?? 0)) {
+        const threshold = this.thresholds[level - 1];
+        warnings.push({ name: report.name, resource, used, limit, utilization, threshold, timestamp });
+      }
+      this.levels.set(key, level);
+    }
+    return warnings;
+  }
+}
+
+// ─── Watcher ──────────────────────────────────────────────────────────────────
+
+/**
+ * Samples `serviceNames` every `interval` ms and reports each threshold
+ * crossing to `listener`.
+ */
+export function watchLimits(
+  serviceNames: readonly string[],
+  listener: LimitListener,
+  options: WatchLimitsOptions = {}
+): ServiceWatcher {
+  if (!Array.isArray(serviceNames)) {
+    throw new TypeError('serviceNames must be an array');
+  }
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const interval = Math.max(100, options.interval ?? 10_000);
+  const onError = options.onError ?? (() => {});
+  const sampler = new LimitSampler(serviceNames);
+  const alarm = new LimitAlarm(options.thresholds);
+  let closed = false;
+  let timer: NodeJS.Timeout | null = null;
+
+  const tick = async () => {
+    timer = null;
+    try {
+      const reports = await sampler.sample();
+      const now = Date.now();
+      for (const report of reports) {
+        for (const warning of alarm.check(report, now)) if (!closed) listener(warning);
+      }
+    } catch (err) {
+      if (!closed) onError(err as Error);
+    }
+    if (!closed) timer = setTimeout(() => { void tick(); }, interval);
+  };
+  void tick();
+
+  return {
+    close() {
+      closed = true;
+      if (timer) clearTimeout(timer);
+      timer = null;
+    }
+  };
+}
@@ -9,47 +9,88 @@
  */
 
 import fs from 'fs';
-import { execFileSync } from 'child_process';
-import { ServiceStatus } from './types';
+import readline from 'readline';
+import { execFileSync, spawn } from 'child_process';
+import { ServiceStatus, IterateServicesOptions, UnitTimestamps } from './types';
+import { scheduler } from './scheduler';
+import { probes } from './probe';
+import { tracing, traceSync, traceAsync } from './trace';
+import {
+  tryLoadLibsystemd, openSystemBus, closeBus, withSystemBus, callMethod, freeMessage, newMethodCall, callPipelined,
+  BusPtr, BusCallError, BusMessageReader, BusMessageWriter, SYSTEMD_PATH, MANAGER_IFACE, UNIT_IFACE, PROPERTIES_IFACE
+} from './sdbus';
 
 // ─── Filesystem helpers ───────────────────────────────────────────────────────
 
 function fsExistsSync(p: string): boolean {
-  try {
-    fs.accessSync(p);
-    return true;
-  } catch {
-    return false;
-  }
-}
-
-function readPidFile(...paths: string[]): number {
-  for (const p of paths) {
+  return traceSync('fs.existsSync', [p], () => {
     try {
-      const raw = fs.readFileSync(p, 'utf8').trim();
-      const pid = parseInt(raw, 10);
-      if (pid > 0) return pid;
+      fs.accessSync(p);
+      return true;
     } catch {
-      // try next
+      return false;
     }
+  });
+}
+
+/** Non-blocking existence check, batched through the shared probe engine. */
+function fsExists(p: string): Promise<boolean> {
+  return traceAsync('fs.exists', [p], () => probes.exists(p));
+}
+
+/** Non-blocking read; `null` if the file cannot be read. */
+function fsRead(p: string): Promise<string | null> {
+  return traceAsync('fs.read', [p], () => probes.read(p));
+}
+
+/**
+ * Reads the first valid PID among `paths`. All files are read concurrently;
+ * earlier paths still take precedence.
+ */
+async function readPidFile(...paths: string[]): Promise<number> {
+  const contents = await Promise.all(paths.map(fsRead));
+  for (const raw of contents) {
+    if (raw === null) continue;
+    const pid = parseInt(raw.trim(), 10);
+    if (pid > 0) return pid;
   }
   return 0;
 }
 
 // ─── Init system detection ────────────────────────────────────────────────────
 
-type InitSystem = 'systemd' | 'openrc' | 'sysv';
+export type InitSystem = 'systemd' | 'openrc' | 'sysv';
 
-export function detectInitSystem(): InitSystem {
-  if (fsExistsSync('/run/systemd/private') || fsExistsSync('/sys/fs/cgroup/systemd')) {
+/**
+ * Detects the init system of the host, or of the system rooted at `root`
+ * (e.g. a container's `/proc/<pid>/root`).
+ */
+export function detectInitSystem(root = ''): InitSystem {
+  if (fsExistsSync(`${root}/run/systemd/private`) || (!root && fsExistsSync('/sys/fs/cgroup/systemd'))) {
     return 'systemd';
   }
-  if (fsExistsSync('/run/openrc/softlevel') || fsExistsSync('/run/openrc')) {
+  if (fsExistsSync(`${root}/run/openrc/softlevel`) || fsExistsSync(`${root}/run/openrc`)) {
     return 'openrc';
   }
   return 'sysv';
 }
 
+let _initSystem: InitSystem | null = null;
+
+/** `detectInitSystem()`, evaluated once: the init system does not change at runtime. */
+function initSystem(): InitSystem {
+  const cached = () => {
+    if (_initSystem === null) _initSystem = detectInitSystem();
+    return _initSystem;
+  };
+  // Traced so that a replay reproduces the recorded host, not this one.
+  return tracing() ? traceSync('init', [], cached) : cached();
+}
+
+function haveLibsystemd(): boolean {
+  return traceSync('libsystemd', [], tryLoadLibsystemd);
+}
+
 // ─── Systemd state map ────────────────────────────────────────────────────────
 
 const SYSTEMD_STATE_MAP: Record<string, string> = {
@@ -61,49 +102,115 @@ const SYSTEMD_STATE_MAP: Record<string, string> = {
   reloading:    'CONTINUE_PENDING'
 };
 
-// ─── systemd backend — koffi + libsystemd ────────────────────────────────────
+/** `FreezerState` (systemd ≥ 246) of a frozen or freezing unit; it stays `active` meanwhile. */
+const SYSTEMD_FREEZER_MAP: Record<string, string> = {
+  frozen:               'PAUSED',
+  'frozen-by-parent':   'PAUSED',
+  freezing:             'PAUSE_PENDING',
+  'freezing-by-parent': 'PAUSE_PENDING',
+  thawing:              'CONTINUE_PENDING'
+};
+
+// ─── systemd unit types ───────────────────────────────────────────────────────
+
+/** Type-specific interface and the properties fetched alongside the Unit ones. */
+const UNIT_TYPE_PROPERTIES: Record<string, { iface: string; properties: string[] }> = {
+  service: { iface: 'org.freedesktop.systemd1.Service', properties: ['MainPID'] },
+  timer:   { iface: 'org.freedesktop.systemd1.Timer',   properties: ['NextElapseUSecRealtime', 'LastTriggerUSec', 'Unit'] },
+  socket:  { iface: 'org.freedesktop.systemd1.Socket',  properties: ['NConnections', 'NAccepted'] },
+  mount:   { iface: 'org.freedesktop.systemd1.Mount',   properties: ['Where', 'What', 'Type'] },
+  path:    { iface: 'org.freedesktop.systemd1.Path',    properties: ['Unit'] }
+};
+
+const UNIT_TIMESTAMP_PROPERTIES = [
+  'InactiveExitTimestampMonotonic', 'ActiveEnterTimestampMonotonic',
+  'ActiveExitTimestampMonotonic', 'InactiveEnterTimestampMonotonic'
+];
+
+const UNIT_PROPERTIES = ['LoadState', 'ActiveState', 'SubState', 'FreezerState', ...UNIT_TIMESTAMP_PROPERTIES];
 
-interface LibsystemdBindings {
-  sd_bus_open_system: (ret: object) => number;
-  sd_bus_get_property_string: (
-    bus: object, dest: string, path: string, iface: string,
-    member: string, error: object, ret: object
-  ) => number;
-  sd_bus_unref: (bus: object) => object;
+/** The unit of a service name: `nginx` → `nginx.service`; names with a suffix are kept. */
+export function unitName(serviceName: string): string {
+  return serviceName.includes('.') ? serviceName : `${serviceName}.service`;
 }
 
-let _libsystemd: LibsystemdBindings | null = null;
-let _libsystemdAvailable: boolean | null = null;
+function unitType(unit: string): string {
+  return unit.slice(unit.lastIndexOf('.') + 1);
+}
 
-function tryLoadLibsystemd(): boolean {
-  if (_libsystemdAvailable !== null) return _libsystemdAvailable;
-  try {
-    const koffi = require('koffi');
-    const lib = koffi.load('libsystemd.so.0');
-    _libsystemd = {
-      sd_bus_open_system: lib.func('int sd_bus_open_system(void **ret)'),
-      sd_bus_get_property_string: lib.func(
-        'int sd_bus_get_property_string(void *bus, str dest, str path, str iface, str member, void **error, char **ret)'
-      ),
-      sd_bus_unref: lib.func('void *sd_bus_unref(void *bus)')
-    };
-    _libsystemdAvailable = true;
-  } catch {
-    _libsystemdAvailable = false;
+/**
+ * Converts a µs timestamp to ms since the epoch. Accepts raw D-Bus values
+ * and `systemctl show` output (`n/a`, `@<seconds>` or a UTC date).
+ */
+function usecToMs(value: unknown): number | null {
+  if (typeof value === 'number') {
+    // 0 means "never", UINT64_MAX means "infinity"
+    return value > 0 && value < 2 ** 63 ? Math.floor(value / 1000) : null;
   }
-  return _libsystemdAvailable;
+  const str = String(value ?? '').trim();
+  if (/^\d+$/.test(str)) return usecToMs(Number(str));
+  if (/^@\d+$/.test(str)) return Number(str.slice(1)) * 1000;
+  const ms = Date.parse(str.replace(/^[A-Za-z]{3} /, ''));
+  return Number.isNaN(ms) ? null : ms;
 }
 
-const SYSTEMD_DEST = 'org.freedesktop.systemd1';
-const UNIT_IFACE   = 'org.freedesktop.systemd1.Unit';
+/** µs per unit of a systemd time span, as `systemctl show` prints it (`1min 30s`). */
+const TIMESPAN_UNITS: Record<string, number> = {
+  us: 1, usec: 1, 'µs': 1, 'μs': 1,
+  ms: 1e3, msec: 1e3,
+  s: 1e6, sec: 1e6, second: 1e6, seconds: 1e6,
+  m: 60e6, min: 60e6, minute: 60e6, minutes: 60e6,
+  h: 3600e6, hr: 3600e6, hour: 3600e6, hours: 3600e6,
+  d: 86_400e6, day: 86_400e6, days: 86_400e6,
+  w: 604_800e6, week: 604_800e6, weeks: 604_800e6,
+  M: 2_629_800e6, month: 2_629_800e6, months: 2_629_800e6,
+  y: 31_557_600e6, year: 31_557_600e6, years: 31_557_600e6
+};
 
-function unitObjectPath(serviceName: string): string {
-  const unit = serviceName.includes('.') ? serviceName : `${serviceName}.service`;
-  const encoded = Array.from(unit).map(c => {
-    if (/[A-Za-z0-9]/.test(c)) return c;
-    return `_${c.charCodeAt(0).toString(16).padStart(2, '0')}`;
-  }).join('');
-  return `/org/freedesktop/systemd1/unit/${encoded}`;
+/**
+ * Converts a systemd time span (`*USec` property) to ms, or `null` for none
+ * (`0`, `infinity`). Accepts raw D-Bus values and `systemctl show` output.
+ */
+export function timespanToMs(value: unknown): number | null {
+  if (typeof value === 'number' || typeof value === 'bigint') {
+    const usec = Number(value);
+    return usec > 0 && usec < 2 ** 63 ? usec / 1000 : null;
+  }
+  const str = String(value ?? '').trim();
+  if (/^\d+$/.test(str)) return timespanToMs(Number(str));
+  let usec = 0;
+  let rest = str;
+  for (const m of str.matchAll(/(\d+(?:\.\d+)?)\s*([A-Za-zµμ]+)/g)) {
+    const factor = TIMESPAN_UNITS[m[2]];
+    if (factor === undefined) return null;
+    usec += Number(m[1]) * factor;
+    rest = rest.replace(m[0], '');
+  }
+  return rest.trim() === '' && usec > 0 ? usec / 1000 : null;
+}
+
+/** The type-specific fields of a status, from raw property values. */
+function unitDetails(type: string, props: Record<string, unknown>): Partial<ServiceStatus> {
+  const str = (key: string) => (props[key] === undefined ? '' : String(props[key]));
+  const num = (key: string) => Number(props[key]) || 0;
+  switch (type) {
+    case 'timer':
+      return {
+        timer: {
+          nextElapse:  usecToMs(props['NextElapseUSecRealtime']),
+          lastTrigger: usecToMs(props['LastTriggerUSec']),
+          unit:        str('Unit')
+        }
+      };
+    case 'socket':
+      return { socket: { connections: num('NConnections'), accepted: num('NAccepted') } };
+    case 'mount':
+      return { mount: { where: str('Where'), what: str('What'), fsType: str('Type') } };
+    case 'path':
+      return { path: { unit: str('Unit') } };
+    default:
+      return {};
+  }
 }
 
 interface SystemdQueryResult {
@@ -111,50 +218,158 @@ interface SystemdQueryResult {
   activeState: string;
   subState:    string;
   mainPid:     number;
+  type:        string;
+  /** Raw values of the type-specific properties. */
+  props:       Record<string, unknown>;
 }
 
-function queryLibsystemd(serviceName: string): SystemdQueryResult {
-  const lib = _libsystemd!;
-  const busRef = [null];
-  if (lib.sd_bus_open_system(busRef) < 0 || busRef[0] === null) {
-    throw new Error('sd_bus_open_system failed');
+/** Monotonic transition times, when the backend reported them. */
+function unitTimestamps(props: Record<string, unknown>): UnitTimestamps | undefined {
+  if (props['ActiveEnterTimestampMonotonic'] === undefined) return undefined;
+  const [inactiveExit, activeEnter, activeExit, inactiveEnter] =
+    UNIT_TIMESTAMP_PROPERTIES.map(key => Number(props[key]) || 0);
+  return { inactiveExit, activeEnter, activeExit, inactiveEnter };
+}
+
+function systemdStatus(serviceName: string, result: SystemdQueryResult): ServiceStatus {
+  const { activeState, mainPid, type, props } = result;
+  const status: ServiceStatus = {
+    name:    serviceName,
+    exists:  true,
+    state:   SYSTEMD_FREEZER_MAP[String(props['FreezerState'] ?? '')]
+             || SYSTEMD_STATE_MAP[activeState] || `UNKNOWN(${activeState})`,
+    pid:     mainPid,
+    rawCode: activeState,
+    type,
+    ...unitDetails(type, props)
+  };
+  const timestamps = unitTimestamps(props);
+  if (timestamps) status.timestamps = timestamps;
+  return status;
+}
+
+// ─── systemd backend — koffi + libsystemd ────────────────────────────────────
+
+export function unitObjectPath(serviceName: string): string {
+  const encoded = Array.from(unitName(serviceName)).map(c => {
+    if (/[A-Za-z0-9]/.test(c)) return c;
+    return `_${c.charCodeAt(0).toString(16).padStart(2, '0')}`;
+  }).join('');
+  return `/org/freedesktop/systemd1/unit/${encoded}`;
+}
+
+function getAllProperties(
+  bus: BusPtr, path: string, iface: string, wanted: ReadonlySet<string>
+): Record<string, unknown> {
+  const reply = callMethod(bus, path, PROPERTIES_IFACE, 'GetAll', w => w.string(iface));
+  try {
+    return new BusMessageReader(reply).properties(wanted);
+  } finally {
+    freeMessage(reply);
   }
-  const bus = busRef[0];
-  const path = unitObjectPath(serviceName);
+}
 
-  function getProp(member: string): string {
-    const retRef = [null];
-    const r = lib.sd_bus_get_property_string(bus, SYSTEMD_DEST, path, UNIT_IFACE, member, [null], retRef);
-    if (r < 0) return '';
-    return retRef[0] ? String(retRef[0]) : '';
+function getUnitAllProperties(
+  bus: BusPtr, path: string, spec: { iface: string } | undefined, wanted: ReadonlySet<string>
+): Record<string, unknown> {
+  try {
+    // An empty interface name returns every interface in one round trip.
+    return getAllProperties(bus, path, '', wanted);
+  } catch (e) {
+    if (!(e instanceof BusCallError)) throw e;
+    const props = getAllProperties(bus, path, UNIT_IFACE, wanted);
+    if (spec) Object.assign(props, getAllProperties(bus, path, spec.iface, wanted));
+    return props;
   }
+}
 
+/**
+ * `getUnitAllProperties` of many units: every `GetAll` is sent before any
+ * reply is read, so n units cost about one round trip instead of n. Units
+ * whose call fails (older managers reject the empty interface name) are
+ * retried one by one; units that still fail get `{}`.
+ */
+function getUnitsAllProperties(
+  bus: BusPtr, units: readonly string[], wanted: ReadonlySet<string>
+): Array<Record<string, unknown>> {
+  const messages: BusPtr[] = [];
   try {
-    const loadState   = getProp('LoadState');
-    const activeState = getProp('ActiveState');
-    const subState    = getProp('SubState');
-    const mainPidStr  = getProp('MainPID');
+    for (const unit of units) {
+      const m = newMethodCall(bus, unitObjectPath(unit), PROPERTIES_IFACE, 'GetAll');
+      messages.push(m);
+      new BusMessageWriter(m).string('');
+    }
+  } catch (e) {
+    for (const m of messages) freeMessage(m);
+    throw e;
+  }
+  const replies = callPipelined(bus, messages, 'GetAll');
+  const results: Array<Record<string, unknown>> = [];
+  let i = 0;
+  try {
+    for (; i < units.length; i++) {
+      const reply = replies[i];
+      if (reply instanceof BusCallError) {
+        try {
+          results.push(getUnitAllProperties(bus, unitObjectPath(units[i]), UNIT_TYPE_PROPERTIES[unitType(units[i])], wanted));
+        } catch (e) {
+          if (!(e instanceof BusCallError)) throw e;
+          results.push({});
+        }
+        continue;
+      }
+      try {
+        results.push(new BusMessageReader(reply).properties(wanted));
+      } finally {
+        freeMessage(reply);
+      }
+    }
+  } catch (e) {
+    for (const r of replies.slice(i + 1)) if (!(r instanceof BusCallError)) freeMessage(r);
+    throw e;
+  }
+  return results;
+}
+
+/** Properties a status query of `unit` reads: the common ones, then those of its type. */
+export function statusProperties(unit: string): string[] {
+  const spec = UNIT_TYPE_PROPERTIES[unitType(unit)];
+  return [...UNIT_PROPERTIES, ...(spec ? spec.properties : [])];
+}
+
+function queryLibsystemd(serviceName: string): SystemdQueryResult {
+  const unit = unitName(serviceName);
+  const type = unitType(unit);
+  const spec = UNIT_TYPE_PROPERTIES[type];
+  const wanted = new Set(statusProperties(unit));
+  const path = unitObjectPath(serviceName);
+
+  return traceSync('dbus.unit', [serviceName], () => withSystemBus(bus => {
+    const props = getUnitAllProperties(bus, path, spec, wanted);
     return {
-      loadState,
-      activeState,
-      subState,
-      mainPid: parseInt(mainPidStr, 10) || 0
+      loadState:   String(props['LoadState'] ?? ''),
+      activeState: String(props['ActiveState'] ?? ''),
+      subState:    String(props['SubState'] ?? ''),
+      mainPid:     Number(props['MainPID']) || 0,
+      type,
+      props
     };
-  } finally {
-    lib.sd_bus_unref(bus);
-  }
+  }));
 }
 
 // ─── systemd fallback — systemctl CLI ─────────────────────────────────────────
 
 function querySystemctl(serviceName: string): SystemdQueryResult {
-  const unit = serviceName.includes('.') ? serviceName : `${serviceName}.service`;
+  const unit = unitName(serviceName);
+  const type = unitType(unit);
+  const properties = statusProperties(unit);
   try {
-    const output = execFileSync(
+    const output = traceSync('systemctl.show', [unit, properties], () => execFileSync(
       'systemctl',
-      ['show', unit, '--property=LoadState,ActiveState,SubState,MainPID', '--no-pager'],
-      { encoding: 'utf8', timeout: 5000, stdio: ['pipe', 'pipe', 'pipe'] }
-    );
+      ['show', unit, `--property=${properties.join(',')}`, '--no-pager'],
+      // TZ=UTC so that timestamps are printed in a zone Date.parse understands
+      { encoding: 'utf8', timeout: 5000, stdio: ['pipe', 'pipe', 'pipe'], env: { ...process.env, TZ: 'UTC' } }
+    ));
     const props: Record<string, string> = {};
     for (const line of output.trim().split('\n')) {
       const idx = line.indexOf('=');
@@ -166,44 +381,109 @@ function querySystemctl(serviceName: string): SystemdQueryResult {
       loadState:   props['LoadState']   || '',
       activeState: props['ActiveState'] || '',
       subState:    props['SubState']    || '',
-      mainPid:     parseInt(props['MainPID'] || '0', 10) || 0
+      mainPid:     parseInt(props['MainPID'] || '0', 10) || 0,
+      type,
+      props
     };
   } catch {
     throw new Error(`systemctl query failed for "${serviceName}"`);
   }
 }
 
+// ─── systemd bulk property reads ──────────────────────────────────────────────
+
+function parseShowBlocks(output: string): Array<Record<string, string>> {
+  return output.split(/\n\n+/).filter(block => block.trim()).map(block => {
+    const props: Record<string, string> = {};
+    for (const line of block.split('\n')) {
+      const idx = line.indexOf('=');
+      if (idx > 0) props[line.slice(0, idx)] = line.slice(idx + 1);
+    }
+    return props;
+  });
+}
+
+/**
+ * Reads `properties` of several units over one bus connection, with the
+ * calls pipelined (or one `systemctl show` run), in the order of
+ * `serviceNames`. Values are raw: numbers over D-Bus, strings from
+ * systemctl. Units that cannot be read yield an empty record. systemd only.
+ *
+ * Synchronous: blocks the event loop until the last reply, about one round
+ * trip plus systemd's time to serialize every unit.
+ */
+export function getUnitProperties(
+  serviceNames: readonly string[], properties: readonly string[]
+): Array<Record<string, unknown>> {
+  if (serviceNames.length === 0) return [];
+  const units = serviceNames.map(unitName);
+  if (haveLibsystemd()) {
+    const wanted = new Set(properties);
+    return traceSync('dbus.units', [units, properties], () => withSystemBus(bus => getUnitsAllProperties(bus, units, wanted)));
+  }
+  const output = traceSync('systemctl.show', [units, properties], () => execFileSync(
+    'systemctl',
+    ['show', ...units, `--property=${properties.join(',')}`, '--no-pager'],
+    { encoding: 'utf8', timeout: 5000, stdio: ['pipe', 'pipe', 'pipe'], env: { ...process.env, TZ: 'UTC' } }
+  ));
+  const blocks = parseShowBlocks(output);
+  return units.map((_, i) => blocks[i] ?? {});
+}
+
+/** Reads `properties` of the systemd manager itself. systemd only. */
+export function getManagerProperties(properties: readonly string[]): Record<string, unknown> {
+  if (haveLibsystemd()) {
+    const wanted = new Set(properties);
+    return traceSync('dbus.manager', [properties], () =>
+      withSystemBus(bus => getAllProperties(bus, SYSTEMD_PATH, MANAGER_IFACE, wanted)));
+  }
+  const output = traceSync('systemctl.show', [[], properties], () => execFileSync(
+    'systemctl',
+    ['show', `--property=${properties.join(',')}`, '--no-pager'],
+    { encoding: 'utf8', timeout: 5000, stdio: ['pipe', 'pipe', 'pipe'] }
+  ));
+  return parseShowBlocks(output)[0] ?? {};
+}
+
 // ─── OpenRC backend ───────────────────────────────────────────────────────────
 
-function openrcExists(serviceName: string): boolean {
-  return (
-    fsExistsSync(`/etc/init.d/${serviceName}`) ||
-    fsExistsSync(`/etc/runlevels/default/${serviceName}`)
-  );
+async function openrcExists(serviceName: string): Promise<boolean> {
+  const [script, runlevel] = await Promise.all([
+    fsExists(`/etc/init.d/${serviceName}`),
+    fsExists(`/etc/runlevels/default/${serviceName}`)
+  ]);
+  return script || runlevel;
 }
 
-function openrcState(serviceName: string): string {
-  if (fsExistsSync(`/run/openrc/started/${serviceName}`))  return 'RUNNING';
-  if (fsExistsSync(`/run/openrc/starting/${serviceName}`)) return 'START_PENDING';
-  if (fsExistsSync(`/run/openrc/stopping/${serviceName}`)) return 'STOP_PENDING';
+async function openrcState(serviceName: string, root = ''): Promise<string> {
+  const [started, starting, stopping] = await Promise.all([
+    fsExists(`${root}/run/openrc/started/${serviceName}`),
+    fsExists(`${root}/run/openrc/starting/${serviceName}`),
+    fsExists(`${root}/run/openrc/stopping/${serviceName}`)
+  ]);
+  if (started)  return 'RUNNING';
+  if (starting) return 'START_PENDING';
+  if (stopping) return 'STOP_PENDING';
   return 'STOPPED';
 }
 
 // ─── SysV backend ─────────────────────────────────────────────────────────────
 
-function sysvExists(serviceName: string): boolean {
-  return fsExistsSync(`/etc/init.d/${serviceName}`);
+function sysvExists(serviceName: string): Promise<boolean> {
+  return fsExists(`/etc/init.d/${serviceName}`);
 }
 
-function sysvRunning(serviceName: string): { running: boolean; pid: number } {
-  const pid = readPidFile(`/var/run/${serviceName}.pid`, `/run/${serviceName}.pid`);
+async function sysvRunning(serviceName: string, root = ''): Promise<{ running: boolean; pid: number }> {
+  // Lock files are probed alongside the pidfiles rather than after them.
+  const [pid, varLock, runLock] = await Promise.all([
+    readPidFile(`${root}/var/run/${serviceName}.pid`, `${root}/run/${serviceName}.pid`),
+    fsExists(`${root}/var/run/${serviceName}.lock`),
+    fsExists(`${root}/run/${serviceName}.lock`)
+  ]);
   if (pid > 0) {
-    return { running: fsExistsSync(`/proc/${pid}`), pid };
+    return { running: await fsExists(`${root}/proc/${pid}`), pid };
   }
-  const hasLock =
-    fsExistsSync(`/var/run/${serviceName}.lock`) ||
-    fsExistsSync(`/run/${serviceName}.lock`);
-  return { running: hasLock, pid: 0 };
+  return { running: varLock || runLock, pid: 0 };
 }
 
 // ─── Public API ───────────────────────────────────────────────────────────────
@@ -219,10 +499,13 @@ export async function serviceExists(serviceName: string): Promise<boolean> {
     throw new TypeError('serviceName must be a non-empty string');
   }
 
-  const init = detectInitSystem();
+  const init = initSystem();
+  return scheduler.run(init, () => _serviceExists(serviceName, init));
+}
 
+async function _serviceExists(serviceName: string, init: InitSystem): Promise<boolean> {
   if (init === 'systemd') {
-    if (tryLoadLibsystemd()) {
+    if (haveLibsystemd()) {
       try {
         const { loadState } = queryLibsystemd(serviceName);
         return loadState !== 'not-found' && loadState !== '';
@@ -261,11 +544,14 @@ export async function getServiceStatus(serviceName: string): Promise<ServiceStat
     throw new TypeError('serviceName must be a non-empty string');
   }
 
-  const init = detectInitSystem();
+  const init = initSystem();
+  return scheduler.run(init, () => _getServiceStatus(serviceName, init));
+}
 
+async function _getServiceStatus(serviceName: string, init: InitSystem): Promise<ServiceStatus> {
   // ── systemd ────────────────────────────────────────────────────────────────
   if (init === 'systemd') {
-    if (tryLoadLibsystemd()) {
+    if (haveLibsystemd()) {
       let result: SystemdQueryResult;
       try {
         result = queryLibsystemd(serviceName);
@@ -273,17 +559,10 @@ export async function getServiceStatus(serviceName: string): Promise<ServiceStat
         // libsystemd query failed — try systemctl CLI
         return _systemctlStatus(serviceName);
       }
-      const { loadState, activeState, mainPid } = result;
-      if (loadState === 'not-found' || loadState === '') {
+      if (result.loadState === 'not-found' || result.loadState === '') {
         throw new Error(`Service "${serviceName}" does not exist`);
       }
-      return {
-        name:    serviceName,
-        exists:  true,
-        state:   SYSTEMD_STATE_MAP[activeState] || `UNKNOWN(${activeState})`,
-        pid:     mainPid,
-        rawCode: activeState
-      };
+      return systemdStatus(serviceName, result);
     }
     // libsystemd unavailable — try systemctl CLI
     return _systemctlStatus(serviceName);
@@ -291,29 +570,61 @@ export async function getServiceStatus(serviceName: string): Promise<ServiceStat
 
   // ── OpenRC ─────────────────────────────────────────────────────────────────
   if (init === 'openrc') {
-    if (!openrcExists(serviceName)) {
+    if (!(await openrcExists(serviceName))) {
       throw new Error(`Service "${serviceName}" does not exist`);
     }
-    const state = openrcState(serviceName);
-    const pid   = readPidFile(`/run/${serviceName}.pid`, `/var/run/${serviceName}.pid`);
-    return {
-      name:    serviceName,
-      exists:  true,
-      state,
-      pid,
-      rawCode: state.toLowerCase()
-    };
+    return cgroupFreezerStatus(await _openrcStatus(serviceName));
   }
 
   // ── SysV ───────────────────────────────────────────────────────────────────
-  return _sysvStatus(serviceName);
+  return cgroupFreezerStatus(await _sysvStatus(serviceName));
 }
 
-function _sysvStatus(serviceName: string): ServiceStatus {
-  if (!sysvExists(serviceName)) {
+/** cgroups frozen by `pauseService`, by service name (OpenRC/SysV). */
+export const frozenCgroups = new Map<string, string>();
+
+/** The `frozen` flag of a `cgroup.events` file, or `null` if absent. */
+export function parseFrozen(events: string | null): boolean | null {
+  const m = events ? /^frozen (\d)$/m.exec(events) : null;
+  return m ? m[1] === '1' : null;
+}
+
+/**
+ * OpenRC/SysV: `PAUSED` (or `PAUSE_PENDING`) for running services whose
+ * cgroup `pauseService` froze. Other services cost no extra read.
+ */
+async function cgroupFreezerStatus(status: ServiceStatus): Promise<ServiceStatus> {
+  const dir = frozenCgroups.get(status.name);
+  if (!dir || status.state !== 'RUNNING') return status;
+  const frozen = parseFrozen(await fsRead(`${dir}/cgroup.events`));
+  if (frozen === null) return status;
+  const state = frozen ? 'PAUSED' : 'PAUSE_PENDING';
+  return { ...status, state, rawCode: state.toLowerCase() };
+}
+
+async function _openrcStatus(serviceName: string, root = ''): Promise<ServiceStatus> {
+  const [state, pid] = await Promise.all([
+    openrcState(serviceName, root),
+    readPidFile(`${root}/run/${serviceName}.pid`, `${root}/var/run/${serviceName}.pid`)
+  ]);
+  return {
+    name:    serviceName,
+    exists:  true,
+    state,
+    pid,
+    rawCode: state.toLowerCase()
+  };
+}
+
+async function _sysvStatus(serviceName: string): Promise<ServiceStatus> {
+  if (!(await sysvExists(serviceName))) {
     throw new Error(`Service "${serviceName}" does not exist`);
   }
-  const { running, pid } = sysvRunning(serviceName);
+  return _sysvRunningStatus(serviceName);
+}
+
+async function _sysvRunningStatus(serviceName: string, root = ''): Promise<ServiceStatus> {
+  const { running, pid } = await sysvRunning(serviceName, root);
   return {
     name:    serviceName,
     exists:  true,
@@ -323,7 +634,7 @@ function _sysvStatus(serviceName: string): ServiceStatus {
   };
 }
 
-function _systemctlStatus(serviceName: string): ServiceStatus {
+async function _systemctlStatus(serviceName: string): Promise<ServiceStatus> {
   let result: SystemdQueryResult;
   try {
     result = querySystemctl(serviceName);
@@ -331,16 +642,306 @@ function _systemctlStatus(serviceName: string): ServiceStatus {
     // systemctl unavailable — fall through to SysV
     return _sysvStatus(serviceName);
   }
-  const { loadState, activeState, mainPid } = result;
-  if (loadState === 'not-found' || loadState === '') {
+  if (result.loadState === 'not-found' || result.loadState === '') {
     // Service not known to systemd — fall through to SysV
     return _sysvStatus(serviceName);
   }
+  return systemdStatus(serviceName, result);
+}
+
+// ─── Service listing ──────────────────────────────────────────────────────────
+
+/** Entries decoded between two yields to the event loop. */
+const LIST_YIELD_EVERY = 256;
+
+/** /etc/init.d entries that are helpers rather than services. */
+const INITD_IGNORE = new Set(['README', 'skeleton', 'rc', 'rcS', 'rc.local', 'functions', 'functions.sh']);
+
+function globToRegExp(glob: string): RegExp {
+  let re = '';
+  for (const c of glob) {
+    if (c === '*') re += '.*';
+    else if (c === '?') re += '.';
+    else re += c.replace(/[\\^$.|+()[\]{}]/g, '\\$&');
+  }
+  return new RegExp(`^${re}$`);
+}
+
+function nameMatcher(patterns: readonly string[] | undefined): (name: string) => boolean {
+  if (!patterns || patterns.length === 0) return () => true;
+  const res = patterns.map(globToRegExp);
+  return name => res.some(re => re.test(name));
+}
+
+/** Unit-name globs for systemd: bare patterns are scoped to the requested types. */
+function unitPatterns(patterns: readonly string[] | undefined, types: readonly string[]): string[] {
+  if (!patterns || patterns.length === 0) return types.map(t => `*.${t}`);
+  return patterns.flatMap(p => (p.includes('.') ? [p] : types.map(t => `${p}.${t}`)));
+}
+
+/** The name listings report for `serviceName`: `nginx` for `nginx.service`, `backup.timer` as is. */
+export function listedName(serviceName: string): string {
+  return displayName(unitName(serviceName));
+}
+
+function displayName(unit: string): string {
+  return unit.endsWith('.service') ? unit.slice(0, -'.service'.length) : unit;
+}
+
+function systemdListEntry(unit: string, activeState: string): ServiceStatus {
   return {
-    name:    serviceName,
+    name:    displayName(unit),
     exists:  true,
     state:   SYSTEMD_STATE_MAP[activeState] || `UNKNOWN(${activeState})`,
-    pid:     mainPid,
-    rawCode: activeState
+    pid:     0,
+    rawCode: activeState,
+    type:    unitType(unit)
   };
 }
+
+const yieldToEventLoop = () => new Promise<void>(resolve => setImmediate(resolve));
+
+/**
+ * Decodes a `ListUnits`/`ListUnitsByPatterns` reply — `a(ssssssouso)` — one
+ * struct at a time. Only the id, load and active states are materialized.
+ */
+async function* decodeUnitList(
+  reply: BusMessageReader, accept: (unit: string) => boolean
+): AsyncGenerator<ServiceStatus> {
+  reply.enter('a', '(ssssssouso)');
+  let n = 0;
+  while (reply.enter('r', 'ssssssouso')) {
+    const unit = reply.string();
+    reply.skip('s');                       // description
+    const loadState   = reply.string();
+    const activeState = reply.string();
+    reply.skip('ssouso');                  // sub, following, path, job id/type/path
+    reply.exit();
+    if (loadState !== 'not-found' && accept(unit)) {
+      yield systemdListEntry(unit, activeState);
+    }
+    if (++n % LIST_YIELD_EVERY === 0) await yieldToEventLoop();
+  }
+  reply.exit();
+}
+
+/** Sends `ListUnitsByPatterns`, else `ListUnits`, on `bus`; returns the reply. */
+function listUnitsReply(bus: BusPtr, patterns: string[]): BusPtr {
+  try {
+    return callMethod(bus, SYSTEMD_PATH, MANAGER_IFACE, 'ListUnitsByPatterns', w => {
+      w.strings([]);
+      w.strings(patterns);
+    });
+  } catch (e) {
+    if (!(e instanceof BusCallError)) throw e;
+    // systemd < 230 has no server-side filtering
+    return callMethod(bus, SYSTEMD_PATH, MANAGER_IFACE, 'ListUnits');
+  }
+}
+
+async function* listLibsystemd(
+  patterns: string[], openBus: () => BusPtr = openSystemBus
+): AsyncGenerator<ServiceStatus> {
+  const bus = openBus();
+  let reply: BusPtr;
+  try {
+    reply = listUnitsReply(bus, patterns);
+  } finally {
+    closeBus(bus);
+  }
+  try {
+    yield* decodeUnitList(new BusMessageReader(reply), nameMatcher(patterns));
+  } finally {
+    freeMessage(reply);
+  }
+}
+
+/**
+ * The `MainPID` of each service unit, `0` where the call fails. Every `Get`
+ * is sent before any reply is read (see `getUnitsAllProperties`).
+ */
+function getUnitsMainPid(bus: BusPtr, units: readonly string[]): number[] {
+  const messages: BusPtr[] = [];
+  try {
+    for (const unit of units) {
+      const m = newMethodCall(bus, unitObjectPath(unit), PROPERTIES_IFACE, 'Get');
+      messages.push(m);
+      new BusMessageWriter(m).string(UNIT_TYPE_PROPERTIES.service.iface).string('MainPID');
+    }
+  } catch (e) {
+    for (const m of messages) freeMessage(m);
+    throw e;
+  }
+  return callPipelined(bus, messages, 'Get').map(reply => {
+    if (reply instanceof BusCallError) return 0;
+    try {
+      return Number(new BusMessageReader(reply).value()) || 0;
+    } finally {
+      freeMessage(reply);
+    }
+  });
+}
+
+/**
+ * `listLibsystemd` for a system that is not ours: `ListUnits` only carries
+ * states, so the `MainPID` of the services that are not stopped is read over
+ * the same connection, in one pipelined round trip, before it is closed.
+ */
+async function* listLibsystemdWithPids(
+  patterns: string[], openBus: () => BusPtr
+): AsyncGenerator<ServiceStatus> {
+  const listed: ServiceStatus[] = [];
+  const bus = openBus();
+  try {
+    const reply = listUnitsReply(bus, patterns);
+    try {
+      for await (const s of decodeUnitList(new BusMessageReader(reply), nameMatcher(patterns))) listed.push(s);
+    } finally {
+      freeMessage(reply);
+    }
+    const live = listed.filter(s => s.type === 'service' && s.state !== 'STOPPED');
+    getUnitsMainPid(bus, live.map(s => s.name)).forEach((pid, i) => { live[i].pid = pid; });
+  } finally {
+    closeBus(bus);
+  }
+  yield* listed;
+}
+
+async function* listSystemctl(patterns: string[]): AsyncGenerator<ServiceStatus> {
+  const child = spawn(
+    'systemctl',
+    ['list-units', '--all', '--plain', '--full', '--no-legend', '--no-pager', ...patterns],
+    { stdio: ['ignore', 'pipe', 'ignore'] }
+  );
+  let spawnFailed = false;
+  child.on('error', () => { spawnFailed = true; });
+  const closed = new Promise<number | null>(resolve => child.on('close', resolve));
+  const rl = readline.createInterface({ input: child.stdout!, crlfDelay: Infinity });
+  const accept = nameMatcher(patterns);
+
+  let count = 0;
+  try {
+    for await (const line of rl) {
+      // UNIT LOAD ACTIVE SUB DESCRIPTION…
+      const [unit, loadState, activeState] = line.replace(/^[●*]\s*/, '').trim().split(/\s+/);
+      if (!unit || !activeState || loadState === 'not-found' || !accept(unit)) continue;
+      count++;
+      yield systemdListEntry(unit, activeState);
+    }
+  } finally {
+    rl.close();
+    if (child.exitCode === null) child.kill();
+  }
+
+  const code = await closed;
+  if (count === 0 && (spawnFailed || code !== 0)) {
+    // systemctl unavailable — fall back to SysV scripts
+    yield* listInitD('sysv');
+  }
+}
+
+async function* listInitD(init: InitSystem, root = ''): AsyncGenerator<ServiceStatus> {
+  let dir: fs.Dir;
+  try {
+    dir = await fs.promises.opendir(`${root}/etc/init.d`);
+  } catch {
+    return;
+  }
+  for await (const entry of dir) {
+    if (entry.name.startsWith('.') || INITD_IGNORE.has(entry.name)) continue;
+    if (!entry.isFile() && !entry.isSymbolicLink()) continue;
+    yield init === 'openrc' ? await _openrcStatus(entry.name, root) : await _sysvRunningStatus(entry.name, root);
+  }
+}
+
+/**
+ * Lists the services of the system rooted at `root` — a container's
+ * `/proc/<pid>/root` — whose init system is `init`. systemd is asked over the
+ * connection returned by `openBus`; OpenRC and SysV state is read under
+ * `root`. PIDs are the ones seen inside that system; systemd's are read with
+ * `Get(MainPID)` after the listing, over the same connection.
+ */
+export async function* listServicesAt(
+  root: string, init: InitSystem, openBus: () => BusPtr, patterns?: string[]
+): AsyncGenerator<ServiceStatus> {
+  if (init === 'systemd') {
+    yield* listLibsystemdWithPids(unitPatterns(patterns, ['service']), openBus);
+    return;
+  }
+  const accept = nameMatcher(patterns);
+  for await (const s of listInitD(init, root)) if (accept(s.name)) yield s;
+}
+
+async function listSource(
+  init: InitSystem, patterns: string[] | undefined, types: string[]
+): Promise<AsyncGenerator<ServiceStatus> | null> {
+  if (init === 'systemd') {
+    const unitGlobs = unitPatterns(patterns, types);
+    if (haveLibsystemd()) {
+      const viaLib = listLibsystemd(unitGlobs);
+      try {
+        // Prime the generator so bus failures fall back before anything is yielded.
+        const first = await viaLib.next();
+        return (async function* () {
+          if (!first.done) yield first.value;
+          yield* viaLib;
+        })();
+      } catch {
+        // libsystemd query failed — try systemctl CLI
+      }
+    }
+    return listSystemctl(unitGlobs);
+  }
+  if (!types.includes('service')) {
+    // OpenRC and SysV only know services
+    return null;
+  }
+  const accept = nameMatcher(patterns);
+  return (async function* () {
+    for await (const s of listInitD(init)) if (accept(s.name)) yield s;
+  })();
+}
+
+/**
+ * Lists installed services, yielding each one as soon as it is decoded.
+ *
+ * - **systemd**: one `ListUnitsByPatterns` call. `sd_bus_call` is
+ *   synchronous — it blocks the event loop until the reply arrives — and
+ *   holds the whole reply in memory; only the decoding into results is
+ *   incremental, yielding to the loop every `LIST_YIELD_EVERY` entries.
+ *   The `systemctl list-units` fallback streams its output line by line.
+ *   `pid` is `0`; use `getServiceStatus` for the main PID and the
+ *   type-specific details. `types` selects timers, sockets, mounts, ….
+ * - **OpenRC / SysV**: `/etc/init.d` is read with `opendir`, one entry at a
+ *   time, so memory stays bounded by one entry regardless of the number of
+ *   services.
+ *
+ * @example
+ *   for await (const s of iterateServices({ patterns: ['php*'] })) console.log(s.name, s.state);
+ */
+export async function* iterateServices(opts: IterateServicesOptions = {}): AsyncGenerator<ServiceStatus> {
+  const states = opts.states && opts.states.length > 0 ? new Set(opts.states) : null;
+  const types = opts.types && opts.types.length > 0 ? opts.types : ['service'];
+  const init = initSystem();
+
+  let source: AsyncIterable<ServiceStatus> | Iterable<ServiceStatus> | null;
+  if (tracing()) {
+    // A trace stores results, not streams: the listing is recorded whole.
+    source = await traceAsync('list', [init, opts.patterns ?? [], types], async () => {
+      const live = await listSource(init, opts.patterns, types);
+      const all: ServiceStatus[] = [];
+      if (live) for await (const s of live) all.push(s);
+      return all;
+    });
+  } else {
+    source = await listSource(init, opts.patterns, types);
+  }
+  if (!source) return;
+
+  // Explicit `types` also apply to patterns that carry their own suffix
+  const typeSet = opts.types && opts.types.length > 0 ? new Set(types) : null;
+  for await (const s of source) {
+    if (typeSet && s.type !== undefined && !typeSet.has(s.type)) continue;
+    if (!states || states.has(s.state)) yield s;
+  }
+}
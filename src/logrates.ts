@@ -0,0 +1,263 @@
+'use strict';
+
+/**
+ * Per-unit journal volume: entries and bytes per second over a sliding
+ * window, to find the services flooding journald before its I/O saturates.
+ *
+ * The window is read in one streaming pass with sd-journal. Per entry, only
+ * `_SYSTEMD_UNIT` (or `_TRANSPORT` for entries without a unit) is copied
+ * out. `MESSAGE` is only measured: the journal's data threshold keeps
+ * compressed messages from being decompressed past `maxMessageBytes`, and
+ * sizes are capped at it too, since uncompressed fields come back whole.
+ *
+ * Counters are kept in per-second buckets, one ring per unit, so following
+ * the journal after the initial pass updates them in O(1) per entry, and
+ * expired seconds drop out without rescanning. A report covers whole seconds
+ * back from its current, partial one: rates are divided by the span that
+ * covers, from the start of its oldest second to now.
+ */
+
+import { ServiceWatcher } from './types';
+import { Journal, followEntries } from './journal';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** Log volume of one unit over the window. */
+export interface LogRate {
+  /** `_SYSTEMD_UNIT`, or `(<transport>)` (`(kernel)`, `(audit)`) for entries without one. */
+  unit: string;
+  entries: number;
+  /** Sum of `MESSAGE` sizes, in bytes. */
+  bytes: number;
+  entriesPerSec: number;
+  bytesPerSec: number;
+}
+
+export interface LogRates {
+  /**
+   * Span the counts cover, in ms since the Unix epoch: `from` is the start
+   * of the oldest whole second, so `to - from` is between `window` and
+   * `window` + 1 s. Rates are per second of that span.
+   */
+  from: number;
+  to: number;
+  /** One entry per unit that logged in the window, largest `bytes` first. */
+  units: LogRate[];
+  /** All units together. */
+  total: LogRate;
+}
+
+export interface LogRatesOptions {
+  /** Window length, in ms. Default 60000. */
+  window?: number;
+  /** Only count these units (names as for `getServiceStatus`). */
+  units?: readonly string[];
+  /** Largest `MESSAGE` size measured, in bytes; larger ones count as this. Default 65536. */
+  maxMessageBytes?: number;
+}
+
+export interface FollowLogRatesOptions extends LogRatesOptions {
+  /** Time between reports, in ms. Default 5000. */
+  interval?: number;
+  /** Called when reading the journal fails; following stops. */
+  onError?: (err: Error) => void;
+}
+
+export type LogRatesListener = (rates: LogRates) => void;
+
+/** Entries read between two yields to the event loop during the initial pass. */
+const PASS_YIELD_EVERY = 4096;
+
+// ─── Counters ─────────────────────────────────────────────────────────────────
+
+interface Ring {
+  /** Second (Unix time) each slot currently counts. */
+  secs: Float64Array;
+  entries: Float64Array;
+  bytes: Float64Array;
+  /** Latest second counted. */
+  last: number;
+}
+
+/**
+ * Per-unit entry and byte counts over a sliding window of whole seconds:
+ * the current second and the `seconds` before it.
+ */
+export class LogRateCounter {
+  private readonly seconds: number;
+  /** Ring slots: the window's seconds plus the current, partial one. */
+  private readonly slots: number;
+  private readonly rings = new Map<string, Ring>();
+
+  constructor(windowMs: number) {
+    this.seconds = Math.max(1, Math.ceil(windowMs / 1000));
+    this.slots = this.seconds + 1;
+  }
+
+  /** Start of the span counted by a snapshot taken at `now`, in ms. */
+  windowStart(now = Date.now()): number {
+    return (Math.floor(now / 1000) - this.seconds) * 1000;
+  }
+
+  /** Counts one entry of `unit`, `bytes` long, logged at `time` (ms). */
+  add(unit: string, bytes: number, time: number): void {
+    const sec = Math.floor(time / 1000);
+    let ring = this.rings.get(unit);
+    if (!ring) {
+      ring = {
+        secs: new Float64Array(this.slots).fill(-1),
+        entries: new Float64Array(this.slots),
+        bytes: new Float64Array(this.slots),
+        last: sec
+      };
+      this.rings.set(unit, ring);
+    }
+    if (sec <= ring.last - this.slots) return;        // older than the window
+    const slot = sec % this.slots;
+    if (ring.secs[slot] !== sec) {
+      ring.secs[slot] = sec;
+      ring.entries[slot] = 0;
+      ring.bytes[slot] = 0;
+    }
+    ring.entries[slot]++;
+    ring.bytes[slot] += bytes;
+    if (sec > ring.last) ring.last = sec;
+  }
+
+  /** Rates over the window ending at `now` (ms). Units silent over it are dropped. */
+  snapshot(now = Date.now()): LogRates {
+    const end = Math.floor(now / 1000);
+    const start = end - this.seconds;
+    const from = start * 1000;
+    const span = Math.max(1, now - from) / 1000;
+    const units: LogRate[] = [];
+    let entries = 0;
+    let bytes = 0;
+    for (const [unit, ring] of this.rings) {
+      let e = 0;
+      let b = 0;
+      for (let i = 0; i < this.slots; i++) {
+        const sec = ring.secs[i];
+        if (sec >= start && sec <= end) {
+          e += ring.entries[i];
+          b += ring.bytes[i];
+        }
+      }
+      if (e === 0) {
+        if (ring.last < start) this.rings.delete(unit);
+        continue;
+      }
+      units.push(rate(unit, e, b, span));
+      entries += e;
+      bytes += b;
+    }
+    units.sort((x, y) => y.bytes - x.bytes || y.entries - x.entries);
+    return { from, to: now, units, total: rate('*', entries, bytes, span) };
+  }
+}
+
+/** `entries` and `bytes` counted over `span` seconds. */
+function rate(unit: string, entries: number, bytes: number, span: number): LogRate {
+  return { unit, entries, bytes, entriesPerSec: entries / span, bytesPerSec: bytes / span };
+}
+
+// ─── Reading ──────────────────────────────────────────────────────────────────
+
+/** `options.maxMessageBytes`, defaulted and at least 1. */
+function maxMessageBytes(options: LogRatesOptions): number {
+  return Math.max(1, options.maxMessageBytes ?? 65_536);
+}
+
+/** Opens the journal at the start of `counter`'s window, matched on `units`. */
+function openWindow(options: LogRatesOptions, counter: LogRateCounter): Journal {
+  const journal = new Journal();
+  try {
+    journal.setDataThreshold(maxMessageBytes(options));
+    // Matches on the same field are ORed.
+    for (const name of options.units ?? []) {
+      journal.match(`_SYSTEMD_UNIT=${name.includes('.') ? name : `${name}.service`}`);
+    }
+    journal.seekTime(counter.windowStart());
+  } catch (e) {
+    journal.close();
+    throw e;
+  }
+  return journal;
+}
+
+/** Counts the current entry, its `MESSAGE` size capped at `maxBytes`. */
+function count(journal: Journal, counter: LogRateCounter, maxBytes: number): void {
+  const unit = journal.field('_SYSTEMD_UNIT') ?? `(${journal.field('_TRANSPORT') ?? 'unknown'})`;
+  counter.add(unit, Math.min(journal.fieldLength('MESSAGE') ?? 0, maxBytes), journal.time());
+}
+
+/** Reads to the end of the journal, yielding to the event loop periodically. */
+async function pass(journal: Journal, counter: LogRateCounter, maxBytes: number): Promise<void> {
+  let n = 0;
+  while (journal.next()) {
+    count(journal, counter, maxBytes);
+    if (++n % PASS_YIELD_EVERY === 0) await new Promise(resolve => setImmediate(resolve));
+  }
+}
+
+/**
+ * Per-unit journal entry and byte rates over the last `window` ms, from
+ * one pass over that part of the journal.
+ *
+ * @throws If libsystemd is unavailable or the journal cannot be opened.
+ */
+export async function getLogRates(options: LogRatesOptions = {}): Promise<LogRates> {
+  const windowMs = Math.max(1000, options.window ?? 60_000);
+  const counter = new LogRateCounter(windowMs);
+  const journal = openWindow(options, counter);
+  try {
+    await pass(journal, counter, maxMessageBytes(options));
+  } finally {
+    journal.close();
+  }
+  return counter.snapshot();
+}
+
+/**
+ * Reports per-unit rates over a sliding `window` every `interval` ms: one
+ * pass over the window, then each new entry is counted as it is written.
+ *
+ * @throws If libsystemd is unavailable or the journal cannot be opened.
+ */
+export function followLogRates(listener: LogRatesListener, options: FollowLogRatesOptions = {}): ServiceWatcher {
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const windowMs = Math.max(1000, options.window ?? 60_000);
+  const interval = Math.max(100, options.interval ?? 5000);
+  const onError = options.onError ?? (() => {});
+  const counter = new LogRateCounter(windowMs);
+  const journal = openWindow(options, counter);
+  const maxBytes = maxMessageBytes(options);
+  let closed = false;
+  let follower: ServiceWatcher | null = null;
+  let timer: NodeJS.Timeout | null = null;
+
+  pass(journal, counter, maxBytes).then(() => {
+    if (closed) {
+      journal.close();
+      return;
+    }
+    // Continues from where the pass ended: nothing is read twice.
+    follower = followEntries(journal, j => count(j, counter, maxBytes), onError);
+    listener(counter.snapshot());
+    timer = setInterval(() => listener(counter.snapshot()), interval);
+  }, err => {
+    journal.close();
+    if (!closed) onError(err as Error);
+  });
+
+  return {
+    close() {
+      closed = true;
+      follower?.close();
+      if (timer) clearInterval(timer);
+      timer = null;
+    }
+  };
+}
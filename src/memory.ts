@@ -0,0 +1,127 @@
+'use strict';
+
+/**
+ * Proportional memory accounting for a service.
+ *
+ * RSS counts every shared page in full in each process that maps it, so the
+ * RSS of a pre-forked service (php-fpm, gunicorn, nginx workers) overstates
+ * what it really occupies several times over. This module reports instead,
+ * summed over every process of the service:
+ *
+ * - **PSS**: each page divided by the number of processes sharing it;
+ * - **USS**: pages private to a process (`Private_Clean + Private_Dirty`),
+ *   i.e. what stopping the service would free;
+ * - **swap**, plain and proportional.
+ *
+ * Figures come from `/proc/<pid>/smaps_rollup` (Linux ≥ 4.14), which the
+ * kernel sums in one pass — a handful of lines per process instead of the
+ * thousands of a full `smaps`. Processes are read in parallel through the
+ * shared probe engine.
+ */
+
+import { probes } from './probe';
+import { getServiceStatus } from './linux';
+import { serviceProcesses } from './threads';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** Memory figures, in bytes. */
+export interface MemoryUsage {
+  /** Resident set size: shared pages counted in full. */
+  rss: number;
+  /** Proportional set size: shared pages divided among their users. */
+  pss: number;
+  /** Unique set size: pages mapped by this process only. */
+  uss: number;
+  /** Resident pages also mapped by other processes. */
+  shared: number;
+  /** Swapped-out pages. */
+  swap: number;
+  /** Swapped-out pages, divided among their users. */
+  swapPss: number;
+}
+
+export interface ProcessMemory extends MemoryUsage {
+  pid: number;
+}
+
+/** Result of `getServiceMemory`. */
+export interface ServiceMemory {
+  name: string;
+  /** Sum over `processes`. */
+  total: MemoryUsage;
+  /** Every process of the service whose figures could be read. */
+  processes: ProcessMemory[];
+}
+
+// ─── /proc parsing ────────────────────────────────────────────────────────────
+
+const ROLLUP_FIELDS: Record<string, keyof MemoryUsage | 'privateClean' | 'privateDirty' | 'sharedClean' | 'sharedDirty'> = {
+  Rss:           'rss',
+  Pss:           'pss',
+  Private_Clean: 'privateClean',
+  Private_Dirty: 'privateDirty',
+  Shared_Clean:  'sharedClean',
+  Shared_Dirty:  'sharedDirty',
+  Swap:          'swap',
+  SwapPss:       'swapPss'
+};
+
+const emptyUsage = (): MemoryUsage => ({ rss: 0, pss: 0, uss: 0, shared: 0, swap: 0, swapPss: 0 });
+
+/**
+ * Parses `/proc/<pid>/smaps_rollup`. Returns `null` when the content has no
+ * `Rss:` line (kernel threads, or a process that exited while being read).
+ */
+export function parseSmapsRollup(text: string): MemoryUsage | null {
+  const kb: Record<string, number> = {};
+  for (const line of text.split('\n')) {
+    const colon = line.indexOf(':');
+    if (colon < 0) continue;
+    const field = ROLLUP_FIELDS[line.slice(0, colon)];
+    if (field) kb[field] = parseInt(line.slice(colon + 1), 10);
+  }
+  if (kb.rss === undefined) return null;
+  const bytes = (field: string) => (kb[field] ?? 0) * 1024;
+  return {
+    rss:     bytes('rss'),
+    pss:     bytes('pss'),
+    uss:     bytes('privateClean') + bytes('privateDirty'),
+    shared:  bytes('sharedClean') + bytes('sharedDirty'),
+    swap:    bytes('swap'),
+    swapPss: bytes('swapPss')
+  };
+}
+
+/** Reads the memory figures of `pids`, in parallel. Unreadable processes are left out. */
+export async function sampleMemory(pids: readonly number[]): Promise<ProcessMemory[]> {
+  const rollups = await Promise.all(pids.map(pid => probes.read(`/proc/${pid}/smaps_rollup`)));
+  const processes: ProcessMemory[] = [];
+  pids.forEach((pid, i) => {
+    const usage = rollups[i] && parseSmapsRollup(rollups[i]!);
+    if (usage) processes.push({ pid, ...usage });
+  });
+  return processes;
+}
+
+// ─── Public API ───────────────────────────────────────────────────────────────
+
+/**
+ * Returns the PSS, USS, RSS and swap of a running service, per process and
+ * in total.
+ *
+ * @throws If the service does not exist or is not running.
+ */
+export async function getServiceMemory(serviceName: string): Promise<ServiceMemory> {
+  const { pid } = await getServiceStatus(serviceName);
+  if (pid <= 0) {
+    throw new Error(`Service "${serviceName}" is not running`);
+  }
+  const processes = await sampleMemory(await serviceProcesses(pid));
+  const total = emptyUsage();
+  for (const p of processes) {
+    for (const key of Object.keys(total) as Array<keyof MemoryUsage>) total[key] += p[key];
+  }
+  processes.sort((a, b) => b.pss - a.pss || a.pid - b.pid);
+  return { name: serviceName, total, processes };
+}
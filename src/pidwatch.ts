@@ -0,0 +1,270 @@
+'use strict';
+
+/**
+ * Event-driven start/stop detection for SysV and OpenRC services from
+ * their pidfiles and lockfiles.
+ *
+ * The status backends read `/run/<name>.pid`, `/var/run/<name>.pid` and the
+ * matching `.lock` files. This watcher puts one inotify watch on each of
+ * those directories instead: creating, writing or removing one of those
+ * files re-queries its service, whose status then checks `/proc/<pid>`.
+ * Start and stop transitions are reported as they happen, and nothing is
+ * polled. Unlike `watchProcEvents`, no privileges are needed.
+ *
+ * A daemon that dies without removing its pidfile (a crash) changes no
+ * file. For those, each running service's main PID is held as a pidfd
+ * (`pidfd_open`, Linux ≥ 5.3), which becomes readable when the process
+ * exits; the pidfds are waited on together with `poll`, on one threadpool
+ * thread, and an exit re-queries its service.
+ */
+
+import fs from 'fs';
+import {
+  ServiceStatus, ServiceChange, ServiceChangeListener, ServiceWatcher
+} from './types';
+import { getServiceStatus, iterateServices } from './linux';
+import { transitions } from './transitions';
+import { recordHistory } from './history';
+import { unitTable } from './unittable';
+
+export interface PidFileWatchOptions {
+  /** Services to watch. Default: every service `iterateServices` lists. */
+  services?: readonly string[];
+  /** Directories holding the pidfiles and lockfiles. Default `['/run', '/var/run']`. */
+  dirs?: readonly string[];
+  /** Status query run on each file event. Defaults to `getServiceStatus`. */
+  query?: (name: string) => Promise<ServiceStatus>;
+  /**
+   * Hold a pidfd per running service to report daemons that die leaving
+   * their pidfile. Default `true`; without koffi or `pidfd_open`, only file
+   * events are reported.
+   */
+  pidfds?: boolean;
+  /** Called on watch or query errors; the watcher keeps running. */
+  onError?: (err: Error) => void;
+}
+
+/** Delays (ms) at which a service is re-queried after a file event: the
+ *  first coalesces a create/write burst, the second catches a pidfile that
+ *  was created before its daemon had finished starting. */
+const REPROBE_DELAYS = [20, 250];
+
+const PID_FILE = /^(.+)\.(?:pid|lock)$/;
+
+// ─── pidfds ──────────────────────────────────────────────────────────────────
+
+const SYS_pidfd_open = 434;                   // same number on every architecture
+const ESRCH  = 3;
+const POLLIN = 0x1;
+const POLLFD_SIZE = 8;                        // struct pollfd { int fd; short events, revents; }
+/** Bound on each blocking poll, so new pidfds and close() are picked up promptly. */
+const POLL_TIMEOUT_MS = 250;
+
+interface LibcBindings {
+  koffi: any;
+  syscall: any;
+  poll: any;
+  close: any;
+}
+
+let _libc: LibcBindings | null | undefined;
+
+function loadLibc(): LibcBindings | null {
+  if (_libc !== undefined) return _libc;
+  try {
+    const koffi = require('koffi');
+    const lib = koffi.load('libc.so.6');
+    _libc = {
+      koffi,
+      syscall: lib.func('long syscall(long number, ...)'),
+      poll:    lib.func('int poll(void *fds, unsigned long nfds, int timeout)'),
+      close:   lib.func('int close(int fd)')
+    };
+  } catch {
+    _libc = null;
+  }
+  return _libc;
+}
+
+interface ExitWatch {
+  name: string;
+  pid: number;
+  fd: number;
+}
+
+/**
+ * Calls `onExit(name)` when the process armed for `name` exits. Blocking
+ * `poll` calls over every pidfd run through koffi's asynchronous calls, so
+ * one threadpool thread is busy while at least one pid is armed.
+ */
+class ExitWatcher {
+  private readonly watches = new Map<string, ExitWatch>();
+  /** pidfds disarmed while a poll was running: closed once it returns. */
+  private retired: number[] = [];
+  private polling = false;
+  private closed = false;
+
+  constructor(private readonly libc: LibcBindings, private readonly onExit: (name: string) => void) {}
+
+  /** Watches `pid` as the process of `name`, replacing its previous one. */
+  arm(name: string, pid: number): void {
+    if (this.closed || this.watches.get(name)?.pid === pid) return;
+    this.disarm(name);
+    const fd = Number(this.libc.syscall(SYS_pidfd_open, 'int', pid, 'unsigned int', 0));
+    if (fd < 0) {
+      // Exited since it was queried; other errors (ENOSYS, EPERM) leave
+      // the service to file events.
+      if (this.libc.koffi.errno() === ESRCH) this.onExit(name);
+      return;
+    }
+    this.watches.set(name, { name, pid, fd });
+    this.pump();
+  }
+
+  disarm(name: string): void {
+    const watch = this.watches.get(name);
+    if (!watch) return;
+    this.watches.delete(name);
+    // A running poll may still be waiting on the fd: closing it now could
+    // let the poll see a reused fd.
+    if (this.polling) this.retired.push(watch.fd);
+    else this.libc.close(watch.fd);
+  }
+
+  close(): void {
+    if (this.closed) return;
+    this.closed = true;
+    for (const name of [...this.watches.keys()]) this.disarm(name);
+  }
+
+  private pump(): void {
+    if (this.polling || this.closed || this.watches.size === 0) return;
+    const list = [...this.watches.values()];
+    const fds = Buffer.alloc(list.length * POLLFD_SIZE);
+    list.forEach((w, i) => {
+      fds.writeInt32LE(w.fd, i * POLLFD_SIZE);
+      fds.writeInt16LE(POLLIN, i * POLLFD_SIZE + 4);
+    });
+    this.polling = true;
+    this.libc.poll.async(fds, list.length, POLL_TIMEOUT_MS, (err: Error | null, n: number) => {
+      this.polling = false;
+      for (const fd of this.retired) this.libc.close(fd);
+      this.retired = [];
+      if (this.closed) return;
+      if (!err && n > 0) {
+        list.forEach((w, i) => {
+          // POLLIN once the process has exited; POLLNVAL/POLLERR re-query too.
+          if (fds.readInt16LE(i * POLLFD_SIZE + 6) === 0 || this.watches.get(w.name) !== w) return;
+          this.disarm(w.name);
+          this.onExit(w.name);
+        });
+      }
+      // n === 0: timed out; n < 0 (EINTR): retry. Either way, poll again.
+      this.pump();
+    });
+  }
+}
+
+/**
+ * Watches the pidfiles and lockfiles of SysV/OpenRC services and calls
+ * `listener` with a {@link ServiceChange} each time a service's normalized
+ * state differs from the last one seen.
+ *
+ * @throws If none of the directories can be watched.
+ */
+export async function watchPidFiles(
+  listener: ServiceChangeListener,
+  options: PidFileWatchOptions = {}
+): Promise<ServiceWatcher> {
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const onError = options.onError ?? (() => {});
+  const query = options.query ?? getServiceStatus;
+
+  const last   = new Map<string, ServiceStatus | null>();
+  const timers = new Map<string, NodeJS.Timeout[]>();
+  let closed = false;
+
+  const schedule = (name: string) => {
+    for (const t of timers.get(name) ?? []) clearTimeout(t);
+    timers.set(name, REPROBE_DELAYS.map(ms => setTimeout(() => { void probe(name); }, ms)));
+  };
+
+  const libc = (options.pidfds ?? true) ? loadLibc() : null;
+  const exits = libc ? new ExitWatcher(libc, schedule) : null;
+  /** Follows the main PID of `status`, if it runs. */
+  const track = (name: string, status: ServiceStatus | null) => {
+    if (!exits) return;
+    if (status && status.state === 'RUNNING' && status.pid > 0) exits.arm(name, status.pid);
+    else exits.disarm(name);
+  };
+
+  // Baseline statuses. A transition racing it is picked up by the next event.
+  if (options.services) {
+    const names = [...new Set(options.services)];
+    const statuses = await Promise.all(names.map(name => query(name).catch(() => null)));
+    names.forEach((name, i) => last.set(name, statuses[i]));
+  } else {
+    for await (const s of iterateServices()) last.set(s.name, s);
+  }
+  for (const [name, status] of last) track(name, status);
+
+  const probe = async (name: string) => {
+    let current: ServiceStatus;
+    try {
+      current = await query(name);
+    } catch (err) {
+      onError(err as Error);
+      return;
+    }
+    if (closed) return;
+    const previous = last.get(name) ?? null;
+    last.set(name, current);
+    track(name, current);
+    const change: ServiceChange = { name, previous, current, timestamp: Date.now() };
+    transitions.observe(change);
+    recordHistory(change);
+    unitTable.observe(change);
+    if (!previous || previous.state !== current.state) listener(change);
+  };
+
+  // /var/run is usually a symlink to /run: watch each directory once.
+  const dirs = new Set<string>();
+  for (const dir of options.dirs ?? ['/run', '/var/run']) {
+    try {
+      dirs.add(fs.realpathSync(dir));
+    } catch {
+      // absent on this host
+    }
+  }
+
+  const watchers: fs.FSWatcher[] = [];
+  for (const dir of dirs) {
+    try {
+      const watcher = fs.watch(dir, (_event, file) => {
+        if (closed || !file) return;
+        const m = PID_FILE.exec(file.toString());
+        if (m && last.has(m[1])) schedule(m[1]);
+      });
+      watcher.on('error', onError);
+      watchers.push(watcher);
+    } catch (e) {
+      onError(e as Error);
+    }
+  }
+  if (watchers.length === 0) {
+    exits?.close();
+    throw new Error(`cannot watch any of ${[...(options.dirs ?? ['/run', '/var/run'])].join(', ')}`);
+  }
+
+  return {
+    close() {
+      closed = true;
+      for (const w of watchers) w.close();
+      exits?.close();
+      for (const list of timers.values()) list.forEach(clearTimeout);
+      timers.clear();
+    }
+  };
+}
@@ -0,0 +1,179 @@
+'use strict';
+
+/**
+ * Adaptive polling for backends without an event source (SysV lock-file
+ * services, containers where inotify or netlink are not permitted).
+ *
+ * Each service has its own interval: it drops to `minInterval` right after a
+ * change and doubles (`backoff`) every time a poll finds the service
+ * unchanged, up to `maxInterval`. Delays carry random jitter so that services
+ * watched together drift apart instead of polling in lockstep.
+ *
+ * Every poll takes a token from a global budget shared by all pollers, so the
+ * number of status queries per second stays bounded however many services
+ * are watched. A poll that finds the budget empty is deferred, not dropped.
+ *
+ * Changes are reported through the same {@link ServiceChangeListener} as the
+ * event-driven watchers.
+ */
+
+import { ServiceStatus, ServiceChange, ServiceChangeListener, ServiceWatcher } from './types';
+import { transitions } from './transitions';
+import { recordHistory } from './history';
+import { unitTable } from './unittable';
+
+// ─── Budget ───────────────────────────────────────────────────────────────────
+
+/**
+ * Token bucket bounding status queries per second.
+ */
+export class PollBudget {
+  private tokens: number;
+  private updated = Date.now();
+
+  /**
+   * @param rate  - Queries allowed per second.
+   * @param burst - Queries allowed at once after an idle period. Defaults to `rate`.
+   */
+  constructor(private rate: number, private burst = rate) {
+    this.tokens = burst;
+  }
+
+  /** Changes the rate (and burst) of the bucket. */
+  setRate(rate: number, burst = rate): void {
+    if (!Number.isFinite(rate) || rate <= 0) {
+      throw new RangeError('rate must be a positive number');
+    }
+    this.refill(Date.now());
+    this.rate = rate;
+    this.burst = burst;
+    this.tokens = Math.min(this.tokens, burst);
+  }
+
+  /** Takes one token. Returns `0` on success, else the ms until one is available. */
+  take(now = Date.now()): number {
+    this.refill(now);
+    if (this.tokens >= 1) {
+      this.tokens--;
+      return 0;
+    }
+    return Math.ceil(((1 - this.tokens) / this.rate) * 1000);
+  }
+
+  private refill(now: number): void {
+    this.tokens = Math.min(this.burst, this.tokens + ((now - this.updated) / 1000) * this.rate);
+    this.updated = now;
+  }
+}
+
+/** The budget shared by every poller unless one is given explicitly. */
+export const pollBudget = new PollBudget(200);
+
+// ─── Poller ───────────────────────────────────────────────────────────────────
+
+export interface PollOptions {
+  /** Interval right after a change, in ms. Default 250. */
+  minInterval?: number;
+  /** Interval ceiling while the service is stable, in ms. Default 30000. */
+  maxInterval?: number;
+  /** Interval multiplier applied after each unchanged poll. Default 2. */
+  backoff?: number;
+  /** Random spread applied to each delay, as a fraction (0.2 → ±20%). Default 0.2. */
+  jitter?: number;
+  /** Query budget. Defaults to the library-wide one. */
+  budget?: PollBudget;
+  /** Called when a status query fails; the service keeps being polled. */
+  onError?: (err: Error) => void;
+}
+
+interface PolledService {
+  name: string;
+  interval: number;
+  last: ServiceStatus | null;
+  timer: NodeJS.Timeout | null;
+}
+
+/**
+ * Polls `serviceNames` with `query` and reports state transitions to
+ * `listener`. The first poll of each service sets its baseline and is not
+ * reported.
+ */
+export function pollServices(
+  serviceNames: readonly string[],
+  query: (name: string) => Promise<ServiceStatus>,
+  listener: ServiceChangeListener,
+  options: PollOptions = {}
+): ServiceWatcher {
+  if (!Array.isArray(serviceNames)) {
+    throw new TypeError('serviceNames must be an array');
+  }
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const minInterval = Math.max(1, options.minInterval ?? 250);
+  const maxInterval = Math.max(minInterval, options.maxInterval ?? 30_000);
+  const backoff     = Math.max(1, options.backoff ?? 2);
+  const jitter      = Math.min(1, Math.max(0, options.jitter ?? 0.2));
+  const budget      = options.budget ?? pollBudget;
+  const onError     = options.onError ?? (() => {});
+  let closed = false;
+
+  const spread = (ms: number) => Math.max(1, Math.round(ms * (1 + jitter * (2 * Math.random() - 1))));
+
+  const arm = (svc: PolledService, delay: number) => {
+    svc.timer = setTimeout(() => { void poll(svc); }, delay);
+  };
+
+  const poll = async (svc: PolledService) => {
+    svc.timer = null;
+    if (closed) return;
+    const wait = budget.take();
+    if (wait > 0) {
+      arm(svc, spread(wait));
+      return;
+    }
+
+    let current: ServiceStatus | null = null;
+    try {
+      current = await query(svc.name);
+    } catch (err) {
+      if (!closed) onError(err as Error);
+    }
+    if (closed) return;
+
+    const previous = svc.last;
+    if (current) {
+      svc.last = current;
+      const change: ServiceChange = { name: svc.name, previous, current, timestamp: Date.now() };
+      // Every poll: systemd timestamps reveal restarts faster than the interval.
+      transitions.observe(change);
+      recordHistory(change);
+      unitTable.observe(change);
+      if (previous && previous.state !== current.state) {
+        svc.interval = minInterval;
+        listener(change);
+      } else if (previous) {
+        svc.interval = Math.min(maxInterval, svc.interval * backoff);
+      }
+    } else {
+      svc.interval = Math.min(maxInterval, svc.interval * backoff);
+    }
+    if (!closed) arm(svc, spread(svc.interval));
+  };
+
+  const services: PolledService[] = [...new Set(serviceNames)].map(name => ({
+    name, interval: minInterval, last: null, timer: null
+  }));
+  // Spread the baseline polls over the first interval.
+  for (const svc of services) arm(svc, Math.floor(Math.random() * jitter * minInterval));
+
+  return {
+    close() {
+      closed = true;
+      for (const svc of services) {
+        if (svc.timer) clearTimeout(svc.timer);
+        svc.timer = null;
+      }
+    }
+  };
+}
@@ -0,0 +1,135 @@
+'use strict';
+
+/**
+ * Batched asynchronous filesystem probes for the OpenRC and SysV backends.
+ *
+ * Probes requested during one tick (existence checks, pidfile and
+ * `/proc/<pid>/stat` reads) are collected, de-duplicated by path and
+ * submitted together as non-blocking fs operations: `stat` (statx) for
+ * existence, `readFile` (open/fstat/read/close) for contents. libuv
+ * completes them on the io_uring ring where it uses one for filesystem
+ * work (Linux ≥ 5.10 with `UV_USE_IO_URING=1` on Node 20), and on its
+ * threadpool otherwise — the event loop never blocks on a probe either way.
+ *
+ * Submission is bounded: at most `maxInFlight` operations are outstanding,
+ * the rest wait in FIFO order.
+ */
+
+import fs from 'fs';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+type ProbeKind = 'exists' | 'read';
+
+interface PendingProbe {
+  kind: ProbeKind;
+  path: string;
+  waiters: Array<(value: any) => void>;
+}
+
+/** Engine counters, for benchmarks and diagnostics. */
+export interface ProbeStats {
+  /** Probes requested by callers. */
+  requested: number;
+  /** Filesystem operations actually issued (after de-duplication). */
+  issued: number;
+  /** Batches flushed. */
+  batches: number;
+  /** Operations currently outstanding. */
+  inFlight: number;
+}
+
+export interface ProbeEngineOptions {
+  /** Maximum outstanding filesystem operations. Default 64. */
+  maxInFlight?: number;
+}
+
+// ─── Probe engine ─────────────────────────────────────────────────────────────
+
+export class ProbeEngine {
+  private readonly maxInFlight: number;
+  /** Probes gathered during the current tick, keyed by kind and path. */
+  private batch = new Map<string, PendingProbe>();
+  /** Probes flushed but not yet started because of the in-flight cap. */
+  private backlog: PendingProbe[] = [];
+  private backlogHead = 0;
+  private flushScheduled = false;
+  private readonly counters: ProbeStats = { requested: 0, issued: 0, batches: 0, inFlight: 0 };
+
+  constructor(options: ProbeEngineOptions = {}) {
+    this.maxInFlight = Math.max(1, options.maxInFlight ?? 64);
+  }
+
+  /** Resolves to `true` if `path` exists, following symlinks like `fs.access`. */
+  exists(path: string): Promise<boolean> {
+    return this.request('exists', path);
+  }
+
+  /** Resolves to the UTF-8 contents of `path`, or `null` if it cannot be read. */
+  read(path: string): Promise<string | null> {
+    return this.request('read', path);
+  }
+
+  stats(): ProbeStats {
+    return { ...this.counters };
+  }
+
+  private request<T>(kind: ProbeKind, path: string): Promise<T> {
+    this.counters.requested++;
+    return new Promise<T>(resolve => {
+      const key = `${kind}\0${path}`;
+      let probe = this.batch.get(key);
+      if (!probe) {
+        probe = { kind, path, waiters: [] };
+        this.batch.set(key, probe);
+      }
+      probe.waiters.push(resolve);
+      if (!this.flushScheduled) {
+        this.flushScheduled = true;
+        process.nextTick(() => this.flush());
+      }
+    });
+  }
+
+  private flush(): void {
+    this.flushScheduled = false;
+    const batch = this.batch;
+    this.batch = new Map();
+    this.counters.batches++;
+    for (const probe of batch.values()) this.backlog.push(probe);
+    this.pump();
+  }
+
+  private pump(): void {
+    while (this.counters.inFlight < this.maxInFlight && this.backlogHead < this.backlog.length) {
+      const probe = this.backlog[this.backlogHead++];
+      if (this.backlogHead === this.backlog.length) {
+        this.backlog = [];
+        this.backlogHead = 0;
+      }
+      this.counters.inFlight++;
+      this.counters.issued++;
+      this.issue(probe).then(value => {
+        this.counters.inFlight--;
+        for (const resolve of probe.waiters) resolve(value);
+        this.pump();
+      });
+    }
+  }
+
+  private issue(probe: PendingProbe): Promise<boolean | string | null> {
+    // Callback APIs: fs.promises.readFile goes through a FileHandle and
+    // costs several extra threadpool round trips per small file. Existence
+    // is a stat, not fs.access: libuv has no io_uring op for faccessat.
+    return new Promise(resolve => {
+      if (probe.kind === 'exists') {
+        fs.stat(probe.path, err => resolve(!err));
+      } else {
+        fs.readFile(probe.path, 'utf8', (err, data) => resolve(err ? null : data));
+      }
+    });
+  }
+}
+
+/** The engine shared by the Linux filesystem backends. */
+export const probes = new ProbeEngine();
@@ -0,0 +1,398 @@
+'use strict';
+
+/**
+ * Process event stream from the kernel proc connector
+ * (`NETLINK_CONNECTOR` / `CN_IDX_PROC`), and a service watcher built on it
+ * for init systems without native events (SysV, OpenRC).
+ *
+ * The kernel multicasts one message per fork/exec/exit on the host. The
+ * watcher matches those against an index of the init scripts' daemons and
+ * pidfiles, re-queries only the affected services and emits the transitions
+ * `getServiceStatus` reports — no polling.
+ *
+ * Subscribing requires `CAP_NET_ADMIN` (root in the initial user namespace).
+ */
+
+import fs from 'fs';
+import path from 'path';
+import {
+  ServiceStatus, ServiceChange, ServiceChangeListener, ServiceWatcher
+} from './types';
+import { getServiceStatus, iterateServices, detectInitSystem } from './linux';
+import { transitions } from './transitions';
+import { recordHistory } from './history';
+import { unitTable } from './unittable';
+
+// ─── Kernel ABI ──────────────────────────────────────────────────────────────
+
+const AF_NETLINK        = 16;
+const SOCK_DGRAM        = 2;
+const SOCK_CLOEXEC      = 0o2000000;
+const NETLINK_CONNECTOR = 11;
+const SOL_SOCKET        = 1;
+const SO_RCVBUF         = 8;
+const SO_RCVTIMEO       = 20;
+const NLMSG_DONE        = 3;
+const CN_IDX_PROC       = 1;
+const CN_VAL_PROC       = 1;
+const PROC_CN_MCAST_LISTEN = 1;
+const PROC_CN_MCAST_IGNORE = 2;
+
+const PROC_EVENT_FORK = 0x00000001;
+const PROC_EVENT_EXEC = 0x00000002;
+const PROC_EVENT_EXIT = 0x80000000;
+
+const NLMSG_HDRLEN = 16;
+const CN_MSG_LEN   = 20;
+/** Offset of `struct proc_event` within a received datagram. */
+const EVENT_OFFSET = NLMSG_HDRLEN + CN_MSG_LEN;
+
+/** A decoded proc connector event. `pid` is the thread id, `tgid` the process id. */
+export interface ProcEvent {
+  type: 'fork' | 'exec' | 'exit';
+  pid: number;
+  tgid: number;
+  /** fork: the parent's pid/tgid. */
+  parentPid?: number;
+  parentTgid?: number;
+  /** exit: raw wait status and terminating signal. */
+  exitCode?: number;
+  exitSignal?: number;
+}
+
+// ─── libc bindings ───────────────────────────────────────────────────────────
+
+interface LibcBindings {
+  koffi: any;
+  socket: any;
+  bind: any;
+  send: any;
+  recv: any;
+  setsockopt: any;
+  close: any;
+}
+
+let _libc: LibcBindings | null = null;
+
+function loadLibc(): LibcBindings {
+  if (_libc) return _libc;
+  const koffi = require('koffi');
+  const lib = koffi.load('libc.so.6');
+  _libc = {
+    koffi,
+    socket:     lib.func('int socket(int domain, int type, int protocol)'),
+    bind:       lib.func('int bind(int fd, const void *addr, uint32_t len)'),
+    send:       lib.func('long send(int fd, const void *buf, size_t len, int flags)'),
+    recv:       lib.func('long recv(int fd, void *buf, size_t len, int flags)'),
+    setsockopt: lib.func('int setsockopt(int fd, int level, int name, const void *val, uint32_t len)'),
+    close:      lib.func('int close(int fd)')
+  };
+  return _libc;
+}
+
+function errnoError(what: string, errno: number): Error {
+  const err: NodeJS.ErrnoException = new Error(`${what} failed (errno ${errno})`);
+  err.errno = errno;
+  if (errno === 1) err.code = 'EPERM';
+  return err;
+}
+
+// ─── Netlink socket ──────────────────────────────────────────────────────────
+
+function controlMessage(op: number): Buffer {
+  const buf = Buffer.alloc(NLMSG_HDRLEN + CN_MSG_LEN + 4);
+  buf.writeUInt32LE(buf.length, 0);          // nlmsg_len
+  buf.writeUInt16LE(NLMSG_DONE, 4);          // nlmsg_type
+  buf.writeUInt32LE(process.pid, 12);        // nlmsg_pid
+  buf.writeUInt32LE(CN_IDX_PROC, 16);        // cn_msg.id.idx
+  buf.writeUInt32LE(CN_VAL_PROC, 20);        // cn_msg.id.val
+  buf.writeUInt16LE(4, 32);                  // cn_msg.len
+  buf.writeUInt32LE(op, 36);                 // enum proc_cn_mcast_op
+  return buf;
+}
+
+/**
+ * Decodes every proc event in a received datagram.
+ */
+export function parseProcEvents(buf: Buffer, length: number): ProcEvent[] {
+  const events: ProcEvent[] = [];
+  let off = 0;
+  while (off + EVENT_OFFSET + 16 <= length) {
+    const msgLen = buf.readUInt32LE(off);
+    if (msgLen < NLMSG_HDRLEN || off + msgLen > length) break;
+    const idx = buf.readUInt32LE(off + NLMSG_HDRLEN);
+    const val = buf.readUInt32LE(off + NLMSG_HDRLEN + 4);
+    if (idx === CN_IDX_PROC && val === CN_VAL_PROC) {
+      const ev   = off + EVENT_OFFSET;
+      const what = buf.readUInt32LE(ev);
+      const data = ev + 16;                  // what, cpu, timestamp_ns
+      switch (what) {
+        case PROC_EVENT_FORK:
+          events.push({
+            type: 'fork',
+            parentPid:  buf.readUInt32LE(data),
+            parentTgid: buf.readUInt32LE(data + 4),
+            pid:        buf.readUInt32LE(data + 8),
+            tgid:       buf.readUInt32LE(data + 12)
+          });
+          break;
+        case PROC_EVENT_EXEC:
+          events.push({ type: 'exec', pid: buf.readUInt32LE(data), tgid: buf.readUInt32LE(data + 4) });
+          break;
+        case PROC_EVENT_EXIT:
+          events.push({
+            type: 'exit',
+            pid:        buf.readUInt32LE(data),
+            tgid:       buf.readUInt32LE(data + 4),
+            exitCode:   buf.readUInt32LE(data + 8),
+            exitSignal: buf.readUInt32LE(data + 12)
+          });
+          break;
+        default:
+          break;
+      }
+    }
+    off += (msgLen + 3) & ~3;                // NLMSG_ALIGN
+  }
+  return events;
+}
+
+/**
+ * Subscribes to the kernel proc connector and calls `listener` for every
+ * fork/exec/exit on the host.
+ *
+ * Reads are blocking `recv` calls issued through koffi's asynchronous call
+ * mechanism, so one libuv threadpool thread is dedicated to the stream while
+ * it is open.
+ *
+ * @throws If koffi is unavailable or the socket cannot be subscribed
+ *         (`code === 'EPERM'` without CAP_NET_ADMIN).
+ */
+export function openProcConnector(
+  listener: (event: ProcEvent) => void,
+  onError: (err: Error) => void = () => {}
+): ServiceWatcher {
+  const libc = loadLibc();
+  const { koffi } = libc;
+
+  const fd: number = libc.socket(AF_NETLINK, SOCK_DGRAM | SOCK_CLOEXEC, NETLINK_CONNECTOR);
+  if (fd < 0) throw errnoError('socket(NETLINK_CONNECTOR)', koffi.errno());
+
+  let closed = false;
+  const fail = (what: string) => {
+    const err = errnoError(what, koffi.errno());
+    libc.close(fd);
+    throw err;
+  };
+
+  const sockaddr = Buffer.alloc(12);          // struct sockaddr_nl
+  sockaddr.writeUInt16LE(AF_NETLINK, 0);
+  sockaddr.writeUInt32LE(CN_IDX_PROC, 8);     // nl_groups
+  if (libc.bind(fd, sockaddr, sockaddr.length) < 0) fail('bind');
+
+  const intOpt = (v: number) => { const b = Buffer.alloc(4); b.writeInt32LE(v); return b; };
+  libc.setsockopt(fd, SOL_SOCKET, SO_RCVBUF, intOpt(1 << 20), 4);
+  // Bounded blocking reads, so close() is noticed promptly by the reader thread.
+  const timeout = Buffer.alloc(16);           // struct timeval { 0s, 250ms }
+  timeout.writeBigInt64LE(250_000n, 8);
+  libc.setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, timeout, timeout.length);
+
+  const listen = controlMessage(PROC_CN_MCAST_LISTEN);
+  if (libc.send(fd, listen, listen.length, 0) < 0) fail('send(PROC_CN_MCAST_LISTEN)');
+
+  const buf = Buffer.alloc(4096);
+  /** A recv is queued or running on the threadpool: the fd must stay open until it returns. */
+  let reading = false;
+  const readNext = () => {
+    reading = true;
+    libc.recv.async(fd, buf, buf.length, 0, (err: Error | null, n: number) => {
+      reading = false;
+      if (closed) {
+        libc.close(fd);
+        return;
+      }
+      if (err) {
+        onError(err);
+        return;
+      }
+      // n < 0: SO_RCVTIMEO expired, or ENOBUFS after the kernel dropped
+      // events under load — either way, keep reading.
+      if (n > 0) {
+        for (const ev of parseProcEvents(buf, n)) listener(ev);
+      }
+      readNext();
+    });
+  };
+  readNext();
+
+  return {
+    close() {
+      if (closed) return;
+      closed = true;
+      const ignore = controlMessage(PROC_CN_MCAST_IGNORE);
+      libc.send(fd, ignore, ignore.length, 0);
+      // A pending recv returns within SO_RCVTIMEO (once a threadpool thread
+      // runs it) and closes the fd itself: closing it now could let the recv
+      // run on a reused fd.
+      if (!reading) libc.close(fd);
+    }
+  };
+}
+
+// ─── Service index ───────────────────────────────────────────────────────────
+
+/** Init-script lines naming the daemon binary (LSB, Red Hat and OpenRC styles). */
+const DAEMON_PATTERNS = [
+  /^\s*(?:DAEMON|EXEC|PROG|command)=["']?([^"'\s;]+)/m,
+  /^#\s*processname:\s*(\S+)/m
+];
+
+/**
+ * Reads `<initDir>/<name>` and returns the basenames of the daemons it
+ * starts: the service name itself plus `DAEMON=`/`command=`/`# processname:`.
+ */
+async function daemonNames(serviceName: string, initDir: string): Promise<string[]> {
+  const names = new Set([serviceName]);
+  try {
+    const script = await fs.promises.readFile(path.join(initDir, serviceName), 'utf8');
+    for (const re of DAEMON_PATTERNS) {
+      const m = re.exec(script);
+      if (m && m[1] && !m[1].includes('$')) names.add(path.basename(m[1]));
+    }
+  } catch {
+    // unreadable script — the service name alone is the best guess
+  }
+  return [...names];
+}
+
+/** Delays (ms) at which an affected service is re-queried: pidfiles are
+ *  written after exec and zombies keep `/proc/<pid>` alive until reaped. */
+const REPROBE_DELAYS = [20, 250, 1000];
+
+export interface ProcEventsWatchOptions {
+  /** Called on stream or query errors; the watcher keeps running. */
+  onError?: (err: Error) => void;
+  /** Services to watch. Default: every service `iterateServices` lists. */
+  services?: readonly string[];
+  /**
+   * Status query run when a service's process events arrive. Defaults to
+   * `getServiceStatus`; with a custom query, systemd hosts are accepted too.
+   */
+  query?: (name: string) => Promise<ServiceStatus>;
+  /** Directory of the init scripts indexed for daemon names. Default `/etc/init.d`. */
+  initDir?: string;
+}
+
+// ─── Service watcher ─────────────────────────────────────────────────────────
+
+/**
+ * Watches SysV/OpenRC services through kernel process events.
+ *
+ * - **exec** of a binary named by an init script (`DAEMON=`, `command=`,
+ *   `# processname:` or the service name) re-queries that service;
+ * - **exit** of a known main PID (pidfile) re-queries its service.
+ *
+ * `listener` receives a {@link ServiceChange} each time a service's
+ * normalized state differs from the last one seen.
+ *
+ * @throws If the proc connector cannot be opened (see `openProcConnector`).
+ */
+export async function watchProcEvents(
+  listener: ServiceChangeListener,
+  options: ProcEventsWatchOptions = {}
+): Promise<ServiceWatcher> {
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const onError = options.onError ?? (() => {});
+  const query = options.query ?? getServiceStatus;
+  const initDir = options.initDir ?? '/etc/init.d';
+  if (!options.query && detectInitSystem() === 'systemd') {
+    throw new Error('watchProcEvents: systemd hosts publish unit events on D-Bus; use a systemd watcher');
+  }
+
+  const last    = new Map<string, ServiceStatus>();
+  const byExe   = new Map<string, Set<string>>();
+  const byPid   = new Map<number, Set<string>>();
+  const timers  = new Map<string, NodeJS.Timeout[]>();
+  let closed = false;
+
+  const trackPid = (pid: number, name: string) => {
+    if (pid <= 0) return;
+    let set = byPid.get(pid);
+    if (!set) byPid.set(pid, set = new Set());
+    set.add(name);
+  };
+
+  const probe = async (name: string) => {
+    let current: ServiceStatus;
+    try {
+      current = await query(name);
+    } catch (err) {
+      onError(err as Error);
+      return;
+    }
+    if (closed) return;
+    const previous = last.get(name) ?? null;
+    last.set(name, current);
+    trackPid(current.pid, name);
+    const change: ServiceChange = { name, previous, current, timestamp: Date.now() };
+    transitions.observe(change);
+    recordHistory(change);
+    unitTable.observe(change);
+    if (!previous || previous.state !== current.state) listener(change);
+  };
+
+  const schedule = (name: string) => {
+    for (const t of timers.get(name) ?? []) clearTimeout(t);
+    timers.set(name, REPROBE_DELAYS.map(ms => setTimeout(() => { void probe(name); }, ms)));
+  };
+
+  // Baseline statuses and the daemon index. A transition racing this initial
+  // listing is picked up by the next event for that service.
+  const index = async (name: string, status: ServiceStatus | null) => {
+    if (status) {
+      last.set(name, status);
+      trackPid(status.pid, name);
+    }
+    for (const exe of await daemonNames(name, initDir)) {
+      let set = byExe.get(exe);
+      if (!set) byExe.set(exe, set = new Set());
+      set.add(name);
+    }
+  };
+  if (options.services) {
+    for (const name of new Set(options.services)) await index(name, await query(name).catch(() => null));
+  } else {
+    for await (const s of iterateServices()) await index(s.name, s);
+  }
+
+  const onEvent = (ev: ProcEvent) => {
+    if (ev.pid !== ev.tgid) return;          // thread, not process
+    if (ev.type === 'exit') {
+      const names = byPid.get(ev.tgid);
+      if (!names) return;
+      byPid.delete(ev.tgid);
+      for (const name of names) schedule(name);
+    } else if (ev.type === 'exec') {
+      fs.promises.readlink(`/proc/${ev.tgid}/exe`).then(exe => {
+        const names = byExe.get(path.basename(exe));
+        if (!names) return;
+        for (const name of names) {
+          trackPid(ev.tgid, name);           // exits of candidates re-probe too
+          schedule(name);
+        }
+      }, () => { /* already gone */ });
+    }
+  };
+
+  const conn = openProcConnector(onEvent, onError);
+  return {
+    close() {
+      closed = true;
+      conn.close();
+      for (const list of timers.values()) list.forEach(clearTimeout);
+      timers.clear();
+    }
+  };
+}
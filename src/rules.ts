@@ -0,0 +1,580 @@
+'use strict';
+
+/**
+ * Incremental alert rule engine over service state.
+ *
+ * Rules are boolean expressions compiled once, e.g.
+ *
+ *   state(nginx)=='RUNNING' && state(php-fpm)=='RUNNING'
+ *   count(state=='failed') > 0
+ *
+ * The engine keeps a table of the latest `ServiceStatus` per service and a
+ * reverse index from service name to the rules that mention it, so feeding
+ * one status update re-evaluates only the rules that depend on that service.
+ * `count(...)` aggregates are maintained incrementally: an update adjusts the
+ * match set of each aggregate by one entry instead of rescanning the table.
+ *
+ * Grammar:
+ *   expr    := and ('||' and)*
+ *   and     := unary ('&&' unary)*
+ *   unary   := '!' unary | compare
+ *   compare := primary (('=='|'!='|'<'|'<='|'>'|'>=') primary)?
+ *   primary := '(' expr ')' | number | string | true | false
+ *            | state(<svc>) | raw(<svc>) | pid(<svc>) | exists(<svc>)
+ *            | count(<expr>)
+ *
+ * Inside `count(...)` the bare fields `state`, `raw`, `pid` and `name` refer
+ * to each service in turn. A state compared with `==`/`!=` matches either the
+ * normalized state or the raw OS code, case-insensitively, so both
+ * `'STOPPED'` and `'failed'` are valid literals.
+ */
+
+import { ServiceStatus } from './types';
+
+// ─── Values ───────────────────────────────────────────────────────────────────
+
+/** A service state as seen by an expression: normalized and raw forms. */
+class StateValue {
+  constructor(readonly state: string, readonly raw: string) {}
+
+  matches(literal: string): boolean {
+    const l = literal.toLowerCase();
+    return this.state.toLowerCase() === l || this.raw.toLowerCase() === l;
+  }
+}
+
+type Value = string | number | boolean | null | StateValue;
+
+interface EvalContext {
+  table: ReadonlyMap<string, ServiceStatus>;
+  /** The service being tested inside a `count(...)` predicate. */
+  current: ServiceStatus | null;
+}
+
+type Evaluator = (ctx: EvalContext) => Value;
+
+function truthy(v: Value): boolean {
+  if (v instanceof StateValue) return true;
+  return Boolean(v);
+}
+
+function looseEquals(a: Value, b: Value): boolean {
+  if (a instanceof StateValue && b instanceof StateValue) return a.state === b.state;
+  if (a instanceof StateValue) return b !== null && a.matches(String(b));
+  if (b instanceof StateValue) return a !== null && b.matches(String(a));
+  return a === b;
+}
+
+function toNumber(v: Value): number {
+  if (v instanceof StateValue || v === null) return NaN;
+  return Number(v);
+}
+
+// ─── Tokenizer ────────────────────────────────────────────────────────────────
+
+type TokenKind = 'num' | 'str' | 'ident' | 'op' | '(' | ')' | 'eof';
+
+interface Token {
+  kind: TokenKind;
+  text: string;
+  pos: number;
+}
+
+const OPERATORS = ['==', '!=', '<=', '>=', '&&', '||', '<', '>', '!'];
+
+function tokenize(src: string): Token[] {
+  const tokens: Token[] = [];
+  let i = 0;
+  while (i < src.length) {
+    const c = src[i];
+    if (/\s/.test(c)) { i++; continue; }
+    if (c === '(' || c === ')') {
+      tokens.push({ kind: c, text: c, pos: i });
+      i++;
+      continue;
+    }
+    if (c === '"' || c === "'") {
+      const end = src.indexOf(c, i + 1);
+      if (end < 0) throw new SyntaxError(`Unterminated string at ${i} in rule "${src}"`);
+      tokens.push({ kind: 'str', text: src.slice(i + 1, end), pos: i });
+      i = end + 1;
+      continue;
+    }
+    const op = OPERATORS.find(o => src.startsWith(o, i));
+    if (op) {
+      tokens.push({ kind: 'op', text: op, pos: i });
+      i += op.length;
+      continue;
+    }
+    const num = /^\d+(\.\d+)?/.exec(src.slice(i));
+    if (num) {
+      tokens.push({ kind: 'num', text: num[0], pos: i });
+      i += num[0].length;
+      continue;
+    }
+    // Identifiers double as bare service names, which may contain - . @ : \
+    const ident = /^[A-Za-z_][\w.@:\\-]*/.exec(src.slice(i));
+    if (ident) {
+      tokens.push({ kind: 'ident', text: ident[0], pos: i });
+      i += ident[0].length;
+      continue;
+    }
+    throw new SyntaxError(`Unexpected character "${c}" at ${i} in rule "${src}"`);
+  }
+  tokens.push({ kind: 'eof', text: '', pos: src.length });
+  return tokens;
+}
+
+// ─── Expression parser ────────────────────────────────────────────────────────
+
+/**
+ * An incrementally maintained `count(...)` aggregate. Identical predicates
+ * are shared between rules, keyed by their normalized source
+ * (`predicateKey`): whitespace between tokens is ignored, whitespace inside
+ * string literals is not.
+ */
+class CountAggregate {
+  /** Names of the services currently matching the predicate. */
+  readonly matches = new Set<string>();
+
+  constructor(readonly key: string, readonly predicate: Evaluator) {}
+
+  /** Re-tests one service; returns true when the count changed. */
+  update(name: string, status: ServiceStatus | null, table: ReadonlyMap<string, ServiceStatus>): boolean {
+    const was = this.matches.has(name);
+    const now = status !== null && truthy(this.predicate({ table, current: status }));
+    if (was === now) return false;
+    if (now) this.matches.add(name);
+    else this.matches.delete(name);
+    return true;
+  }
+}
+
+const SERVICE_FUNCTIONS = new Set(['state', 'raw', 'pid', 'exists']);
+const BARE_FIELDS = new Set(['state', 'raw', 'pid', 'name']);
+
+class Parser {
+  private tokens: Token[];
+  private idx = 0;
+  private countDepth = 0;
+  private countStart = 0;
+
+  readonly services = new Set<string>();
+  readonly aggregates: Array<{ key: string; predicate: Evaluator }> = [];
+
+  constructor(private readonly src: string) {
+    this.tokens = tokenize(src);
+  }
+
+  parse(): Evaluator {
+    const e = this.parseOr();
+    this.expect('eof');
+    return e;
+  }
+
+  private peek(): Token {
+    return this.tokens[this.idx];
+  }
+
+  private next(): Token {
+    return this.tokens[this.idx++];
+  }
+
+  private expect(kind: TokenKind, text?: string): Token {
+    const t = this.next();
+    if (t.kind !== kind || (text !== undefined && t.text !== text)) {
+      const what = text ?? kind;
+      throw new SyntaxError(`Expected "${what}" at ${t.pos} in rule "${this.src}"`);
+    }
+    return t;
+  }
+
+  private isOp(text: string): boolean {
+    const t = this.peek();
+    return t.kind === 'op' && t.text === text;
+  }
+
+  private parseOr(): Evaluator {
+    let left = this.parseAnd();
+    while (this.isOp('||')) {
+      this.next();
+      const l = left, r = this.parseAnd();
+      left = ctx => truthy(l(ctx)) || truthy(r(ctx));
+    }
+    return left;
+  }
+
+  private parseAnd(): Evaluator {
+    let left = this.parseUnary();
+    while (this.isOp('&&')) {
+      this.next();
+      const l = left, r = this.parseUnary();
+      left = ctx => truthy(l(ctx)) && truthy(r(ctx));
+    }
+    return left;
+  }
+
+  private parseUnary(): Evaluator {
+    if (this.isOp('!')) {
+      this.next();
+      const operand = this.parseUnary();
+      return ctx => !truthy(operand(ctx));
+    }
+    return this.parseCompare();
+  }
+
+  private parseCompare(): Evaluator {
+    const left = this.parsePrimary();
+    const t = this.peek();
+    if (t.kind !== 'op' || !['==', '!=', '<', '<=', '>', '>='].includes(t.text)) {
+      return left;
+    }
+    this.next();
+    const right = this.parsePrimary();
+    switch (t.text) {
+      case '==': return ctx => looseEquals(left(ctx), right(ctx));
+      case '!=': return ctx => !looseEquals(left(ctx), right(ctx));
+      case '<':  return ctx => toNumber(left(ctx)) <  toNumber(right(ctx));
+      case '<=': return ctx => toNumber(left(ctx)) <= toNumber(right(ctx));
+      case '>':  return ctx => toNumber(left(ctx)) >  toNumber(right(ctx));
+      default:   return ctx => toNumber(left(ctx)) >= toNumber(right(ctx));
+    }
+  }
+
+  private parsePrimary(): Evaluator {
+    const t = this.next();
+    switch (t.kind) {
+      case '(': {
+        const e = this.parseOr();
+        this.expect(')');
+        return e;
+      }
+      case 'num': {
+        const n = Number(t.text);
+        return () => n;
+      }
+      case 'str': {
+        const s = t.text;
+        return () => s;
+      }
+      case 'ident':
+        return this.parseIdent(t);
+      default:
+        throw new SyntaxError(`Unexpected "${t.text || t.kind}" at ${t.pos} in rule "${this.src}"`);
+    }
+  }
+
+  private parseIdent(t: Token): Evaluator {
+    if (t.text === 'true')  return () => true;
+    if (t.text === 'false') return () => false;
+
+    if (this.peek().kind === '(') {
+      if (t.text === 'count') return this.parseCount(t);
+      if (SERVICE_FUNCTIONS.has(t.text)) return this.parseServiceCall(t);
+      throw new SyntaxError(`Unknown function "${t.text}" at ${t.pos} in rule "${this.src}"`);
+    }
+
+    if (this.countDepth > 0 && BARE_FIELDS.has(t.text)) {
+      return fieldAccessor(t.text);
+    }
+    throw new SyntaxError(`Unexpected identifier "${t.text}" at ${t.pos} in rule "${this.src}"`);
+  }
+
+  private parseServiceCall(fn: Token): Evaluator {
+    if (this.countDepth > 0) {
+      throw new SyntaxError(`${fn.text}(<service>) is not allowed inside count() in rule "${this.src}"`);
+    }
+    this.expect('(');
+    const arg = this.next();
+    if (arg.kind !== 'ident' && arg.kind !== 'str') {
+      throw new SyntaxError(`Expected a service name at ${arg.pos} in rule "${this.src}"`);
+    }
+    this.expect(')');
+    const name = arg.text;
+    this.services.add(name);
+    const field = fn.text === 'exists' ? 'exists' : fn.text;
+    const get = fieldAccessor(field);
+    return ctx => {
+      const status = ctx.table.get(name) ?? null;
+      if (field === 'exists') return status !== null && status.exists;
+      if (status === null) return null;
+      return get({ table: ctx.table, current: status });
+    };
+  }
+
+  private parseCount(fn: Token): Evaluator {
+    if (this.countDepth > 0) {
+      throw new SyntaxError(`Nested count() at ${fn.pos} in rule "${this.src}"`);
+    }
+    this.expect('(');
+    const first = this.idx;
+    this.countDepth++;
+    const predicate = this.parseOr();
+    this.countDepth--;
+    const key = predicateKey(this.tokens.slice(first, this.idx));
+    this.expect(')');
+    const slot = this.aggregates.length;
+    this.aggregates.push({ key, predicate });
+    // Resolved against the engine's shared aggregates once the rule is bound.
+    return ctx => (ctx as BoundContext).aggregates[slot].matches.size;
+  }
+}
+
+/**
+ * Normalized source of a predicate: its tokens re-joined without the
+ * whitespace between them, string literals quoted verbatim.
+ */
+function predicateKey(tokens: readonly Token[]): string {
+  return tokens.map(t => {
+    if (t.kind !== 'str') return t.text;
+    return t.text.includes("'") ? `"${t.text}"` : `'${t.text}'`;
+  }).join('');
+}
+
+interface BoundContext extends EvalContext {
+  aggregates: CountAggregate[];
+}
+
+function fieldAccessor(field: string): Evaluator {
+  switch (field) {
+    case 'state': return ctx => ctx.current && new StateValue(ctx.current.state, String(ctx.current.rawCode));
+    case 'raw':   return ctx => ctx.current && String(ctx.current.rawCode);
+    case 'pid':   return ctx => ctx.current && ctx.current.pid;
+    default:      return ctx => ctx.current && ctx.current.name;
+  }
+}
+
+// ─── Compiled rules ───────────────────────────────────────────────────────────
+
+/**
+ * A rule expression compiled once into closures, with its dependencies.
+ */
+export interface CompiledRule {
+  /** The source expression. */
+  readonly expression: string;
+  /** Service names referenced through state()/raw()/pid()/exists(). */
+  readonly services: readonly string[];
+  /** Source keys of the count() predicates, in evaluation slot order. */
+  readonly aggregates: readonly string[];
+}
+
+interface CompiledRuleInternal extends CompiledRule {
+  readonly evaluate: Evaluator;
+  readonly predicates: Evaluator[];
+}
+
+/**
+ * Parses and compiles a rule expression.
+ *
+ * @throws {SyntaxError} If the expression is malformed.
+ */
+export function compileRule(expression: string): CompiledRule {
+  if (!expression || typeof expression !== 'string') {
+    throw new TypeError('expression must be a non-empty string');
+  }
+  const parser = new Parser(expression);
+  const evaluate = parser.parse();
+  const compiled: CompiledRuleInternal = {
+    expression,
+    services:   [...parser.services],
+    aggregates: parser.aggregates.map(a => a.key),
+    evaluate,
+    predicates: parser.aggregates.map(a => a.predicate)
+  };
+  return compiled;
+}
+
+/** Called when a rule's truth value changes. */
+export type RuleListener = (value: boolean, rule: Rule) => void;
+
+/**
+ * A rule registered with a {@link RuleEngine}.
+ */
+export interface Rule {
+  readonly id: number;
+  readonly expression: string;
+  /** Truth value as of the last evaluation. */
+  readonly value: boolean;
+}
+
+class RuleEntry implements Rule {
+  value = false;
+
+  constructor(
+    readonly id: number,
+    readonly compiled: CompiledRuleInternal,
+    readonly aggregates: CountAggregate[],
+    readonly listener: RuleListener
+  ) {}
+
+  get expression(): string {
+    return this.compiled.expression;
+  }
+}
+
+// ─── Rule engine ──────────────────────────────────────────────────────────────
+
+/**
+ * Holds the latest known status of each service and a set of rules, and
+ * notifies listeners when a rule changes truth value.
+ *
+ * @example
+ *   const engine = new RuleEngine();
+ *   engine.addRule("state(nginx)=='RUNNING' && state(php-fpm)=='RUNNING'", ok => …);
+ *   engine.update(await getServiceStatus('nginx'));
+ */
+export class RuleEngine {
+  private readonly table = new Map<string, ServiceStatus>();
+  private readonly rules = new Map<number, RuleEntry>();
+  /** Reverse index: service name → rules that mention it by name. */
+  private readonly byService = new Map<string, Set<RuleEntry>>();
+  /** Shared count() aggregates, keyed by normalized predicate source (`predicateKey`). */
+  private readonly aggregates = new Map<string, CountAggregate>();
+  /** Reverse index: aggregate → rules that use it. */
+  private readonly byAggregate = new Map<CountAggregate, Set<RuleEntry>>();
+  private nextId = 1;
+
+  /** Number of registered rules. */
+  get size(): number {
+    return this.rules.size;
+  }
+
+  /**
+   * Registers a rule. It is evaluated immediately against the current table;
+   * `listener` fires only on subsequent changes of its truth value.
+   *
+   * @throws {SyntaxError} If the expression is malformed.
+   */
+  addRule(expression: string | CompiledRule, listener: RuleListener): Rule {
+    if (typeof listener !== 'function') {
+      throw new TypeError('listener must be a function');
+    }
+    const compiled = (typeof expression === 'string'
+      ? compileRule(expression)
+      : expression) as CompiledRuleInternal;
+
+    const aggs = compiled.aggregates.map((key, i) => this.acquireAggregate(key, compiled.predicates[i]));
+    const entry = new RuleEntry(this.nextId++, compiled, aggs, listener);
+    this.rules.set(entry.id, entry);
+
+    for (const name of compiled.services) {
+      let set = this.byService.get(name);
+      if (!set) this.byService.set(name, set = new Set());
+      set.add(entry);
+    }
+    for (const agg of aggs) {
+      this.byAggregate.get(agg)!.add(entry);
+    }
+
+    entry.value = this.evaluate(entry);
+    return entry;
+  }
+
+  /** Unregisters a rule. Returns `false` if it was not registered. */
+  removeRule(rule: Rule): boolean {
+    const entry = this.rules.get(rule.id);
+    if (!entry) return false;
+    this.rules.delete(entry.id);
+    for (const name of entry.compiled.services) {
+      const set = this.byService.get(name)!;
+      set.delete(entry);
+      if (set.size === 0) this.byService.delete(name);
+    }
+    for (const agg of entry.aggregates) {
+      const set = this.byAggregate.get(agg);
+      if (!set) continue; // same count() used twice in one rule
+      set.delete(entry);
+      if (set.size === 0) {
+        this.byAggregate.delete(agg);
+        this.aggregates.delete(agg.key);
+      }
+    }
+    return true;
+  }
+
+  /**
+   * Records a new status for `status.name` and re-evaluates the rules that
+   * depend on it. A status identical to the previous one is a no-op.
+   */
+  update(status: ServiceStatus): void {
+    this.updateAll([status]);
+  }
+
+  /**
+   * Records several statuses, then re-evaluates each dependent rule once:
+   * a listener fires at most once per call, with the rule's value over the
+   * whole batch. A throwing listener does not keep the others from being
+   * called; the first error is rethrown after all of them.
+   */
+  updateAll(statuses: Iterable<ServiceStatus>): void {
+    const changed = new Map<string, ServiceStatus>();
+    for (const s of statuses) {
+      const prev = this.table.get(s.name);
+      if (prev && sameStatus(prev, s)) continue;
+      this.table.set(s.name, s);
+      changed.set(s.name, s);
+    }
+    if (changed.size > 0) this.propagate(changed);
+  }
+
+  /** Forgets a service, e.g. after it was uninstalled. */
+  delete(name: string): void {
+    if (!this.table.delete(name)) return;
+    this.propagate(new Map([[name, null]]));
+  }
+
+  /** Latest known status of a service, if any. */
+  get(name: string): ServiceStatus | undefined {
+    return this.table.get(name);
+  }
+
+  private propagate(changes: ReadonlyMap<string, ServiceStatus | null>): void {
+    const dirty = new Set<RuleEntry>();
+    for (const name of changes.keys()) {
+      for (const r of this.byService.get(name) ?? []) dirty.add(r);
+    }
+    for (const [agg, rules] of this.byAggregate) {
+      let counted = false;
+      for (const [name, status] of changes) counted = agg.update(name, status, this.table) || counted;
+      if (counted) for (const r of rules) dirty.add(r);
+    }
+
+    const changed: RuleEntry[] = [];
+    for (const entry of dirty) {
+      const value = this.evaluate(entry);
+      if (value !== entry.value) {
+        entry.value = value;
+        changed.push(entry);
+      }
+    }
+    let error: { thrown: unknown } | null = null;
+    for (const entry of changed) {
+      try {
+        entry.listener(entry.value, entry);
+      } catch (e) {
+        error ??= { thrown: e };
+      }
+    }
+    if (error) throw error.thrown;
+  }
+
+  private evaluate(entry: RuleEntry): boolean {
+    const ctx: BoundContext = { table: this.table, current: null, aggregates: entry.aggregates };
+    return truthy(entry.compiled.evaluate(ctx));
+  }
+
+  private acquireAggregate(key: string, predicate: Evaluator): CountAggregate {
+    let agg = this.aggregates.get(key);
+    if (!agg) {
+      agg = new CountAggregate(key, predicate);
+      for (const [name, status] of this.table) agg.update(name, status, this.table);
+      this.aggregates.set(key, agg);
+      this.byAggregate.set(agg, new Set());
+    }
+    return agg;
+  }
+}
+
+function sameStatus(a: ServiceStatus, b: ServiceStatus): boolean {
+  return a.state === b.state && a.rawCode === b.rawCode && a.pid === b.pid && a.exists === b.exists;
+}
@@ -0,0 +1,184 @@
+'use strict';
+
+/**
+ * Library-wide concurrency limiter for backend work.
+ *
+ * Each backend ("lane": `systemd`, `openrc`, `sysv`, …) has a cap on
+ * in-flight operations. Work beyond the cap waits in a queue, so callers get
+ * backpressure through the promise they await instead of the library issuing
+ * unbounded parallel spawns or fs reads.
+ *
+ * Queued work is grouped by caller. A batch call runs all of its items in one
+ * group, while a standalone call is a group of its own, and a lane serves its
+ * groups round-robin — a caller asking for 5,000 statuses gets one slot per
+ * turn, just like a caller asking for one.
+ *
+ * The current group travels with the async context (AsyncLocalStorage), so
+ * backends only need `scheduler.run(lane, task)`.
+ *
+ * Caps and fairness only shape tasks that yield. A task that does its work
+ * synchronously — a libsystemd D-Bus query — blocks the event loop until it
+ * is done, so such tasks run one at a time in the order they start, and a
+ * batch of them runs back to back whatever the cap. On the `systemd` lane
+ * the cap applies to the `systemctl` fallback, whose spawns do yield.
+ */
+
+import { AsyncLocalStorage } from 'async_hooks';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** Opaque token identifying a caller whose queued work is served as one unit. */
+export type SchedulerGroup = object;
+
+/** Per-lane counters. */
+export interface LaneStats {
+  /** Maximum concurrent operations. */
+  limit: number;
+  /** Operations currently running. */
+  inFlight: number;
+  /** Operations waiting for a slot. */
+  queued: number;
+  /** Distinct callers with queued operations. */
+  groups: number;
+}
+
+/** Scheduler counters, as returned by `getSchedulerStats()`. */
+export interface SchedulerStats {
+  inFlight: number;
+  /** Total queue depth across lanes. */
+  queued: number;
+  lanes: Record<string, LaneStats>;
+}
+
+// ─── Lanes ────────────────────────────────────────────────────────────────────
+
+/** Default caps: the fs backends tolerate more parallelism than PID 1. */
+const DEFAULT_LIMITS: Record<string, number> = {
+  systemd: 8,
+  openrc:  32,
+  sysv:    32
+};
+
+const DEFAULT_LIMIT = 8;
+
+class Lane {
+  inFlight = 0;
+  queued = 0;
+  /**
+   * Waiting work per group. Map iteration order is the round-robin order:
+   * a group served with work left is re-inserted at the back.
+   */
+  readonly pending = new Map<SchedulerGroup, Array<() => void>>();
+
+  constructor(public limit: number) {}
+}
+
+// ─── Scheduler ────────────────────────────────────────────────────────────────
+
+export class Scheduler {
+  private readonly lanes = new Map<string, Lane>();
+  private readonly context = new AsyncLocalStorage<SchedulerGroup>();
+
+  constructor(private readonly limits: Record<string, number> = DEFAULT_LIMITS) {}
+
+  /** Creates a group token for a batch of related operations. */
+  createGroup(): SchedulerGroup {
+    return {};
+  }
+
+  /**
+   * Runs `fn` with `group` as the current group: every `run()` issued from
+   * it, directly or through awaited calls, is queued under that group.
+   */
+  withGroup<T>(group: SchedulerGroup, fn: () => T): T {
+    return this.context.run(group, fn);
+  }
+
+  /**
+   * Runs `task` on `lane` once a slot is free. Tasks start synchronously
+   * when the lane has spare capacity and nothing is queued.
+   *
+   * A task must not schedule further work on its own lane; it would hold a
+   * slot while waiting for one.
+   */
+  run<T>(lane: string, task: () => T | Promise<T>): Promise<T> {
+    const l = this.lane(lane);
+    const group = this.context.getStore() ?? {};
+
+    return new Promise<T>((resolve, reject) => {
+      const start = () => {
+        l.inFlight++;
+        let result: Promise<T>;
+        try {
+          result = Promise.resolve(task());
+        } catch (err) {
+          result = Promise.reject(err);
+        }
+        result.then(resolve, reject).finally(() => {
+          l.inFlight--;
+          this.drain(l);
+        });
+      };
+
+      if (l.inFlight < l.limit && l.queued === 0) {
+        start();
+        return;
+      }
+      let queue = l.pending.get(group);
+      if (!queue) l.pending.set(group, queue = []);
+      queue.push(start);
+      l.queued++;
+    });
+  }
+
+  /** Changes the concurrency cap of a lane (minimum 1). */
+  setLimit(lane: string, limit: number): void {
+    if (!Number.isInteger(limit) || limit < 1) {
+      throw new RangeError('limit must be a positive integer');
+    }
+    const l = this.lane(lane);
+    l.limit = limit;
+    this.drain(l);
+  }
+
+  /** Total number of operations waiting for a slot. */
+  get queueDepth(): number {
+    let n = 0;
+    for (const l of this.lanes.values()) n += l.queued;
+    return n;
+  }
+
+  stats(): SchedulerStats {
+    const lanes: Record<string, LaneStats> = {};
+    let inFlight = 0, queued = 0;
+    for (const [name, l] of this.lanes) {
+      lanes[name] = { limit: l.limit, inFlight: l.inFlight, queued: l.queued, groups: l.pending.size };
+      inFlight += l.inFlight;
+      queued   += l.queued;
+    }
+    return { inFlight, queued, lanes };
+  }
+
+  private lane(name: string): Lane {
+    let l = this.lanes.get(name);
+    if (!l) {
+      l = new Lane(this.limits[name] ?? DEFAULT_LIMIT);
+      this.lanes.set(name, l);
+    }
+    return l;
+  }
+
+  private drain(l: Lane): void {
+    while (l.inFlight < l.limit && l.queued > 0) {
+      const [group, queue] = l.pending.entries().next().value as [SchedulerGroup, Array<() => void>];
+      const start = queue.shift()!;
+      l.pending.delete(group);
+      if (queue.length > 0) l.pending.set(group, queue);
+      l.queued--;
+      start();
+    }
+  }
+}
+
+/** The scheduler shared by every backend of the library. */
+export const scheduler = new Scheduler();
@@ -0,0 +1,796 @@
+'use strict';
+
+/**
+ * Minimal sd-bus (libsystemd.so.0) bindings via koffi, shared by the systemd
+ * backend and the features built on it.
+ *
+ * Only the non-variadic part of the API is bound: messages are built with
+ * `sd_bus_message_append_basic` / `open_container` and decoded one field at a
+ * time with `sd_bus_message_read_basic` / `enter_container`, which lets large
+ * replies (e.g. `ListUnits` on hosts with tens of thousands of units) be
+ * consumed incrementally instead of being materialized up front.
+ */
+
+// ─── Bindings ────────────────────────────────────────────────────────────────
+
+/** Opaque native pointers (sd_bus *, sd_bus_message *). */
+export type BusPtr = object;
+
+export interface LibsystemdBindings {
+  sd_bus_open_system: (ret: [BusPtr | null]) => number;
+  sd_bus_new: (ret: [BusPtr | null]) => number;
+  sd_bus_set_address: (bus: BusPtr, address: string) => number;
+  sd_bus_set_bus_client: (bus: BusPtr, b: number) => number;
+  sd_bus_start: (bus: BusPtr) => number;
+  sd_bus_get_property_string: (
+    bus: BusPtr, dest: string, path: string, iface: string,
+    member: string, error: object, ret: object
+  ) => number;
+  sd_bus_unref: (bus: BusPtr) => object;
+  sd_bus_process: (bus: BusPtr, ret: [BusPtr | null]) => number;
+  sd_bus_send: (bus: BusPtr, m: BusPtr, cookie: [number | bigint]) => number;
+  sd_bus_wait: ((bus: BusPtr, usec: number) => number) & {
+    async: (bus: BusPtr, usec: number, cb: (err: Error | null, r: number) => void) => void;
+  };
+
+  sd_bus_message_new_method_call: (
+    bus: BusPtr, ret: [BusPtr | null], dest: string, path: string, iface: string, member: string
+  ) => number;
+  sd_bus_call: (bus: BusPtr, m: BusPtr, usec: number, error: object, reply: [BusPtr | null]) => number;
+  sd_bus_message_unref: (m: BusPtr) => object;
+  sd_bus_error_free: (error: object) => void;
+  sd_bus_message_is_signal: (m: BusPtr, iface: string, member: string) => number;
+  sd_bus_message_get_path: (m: BusPtr) => string | null;
+  sd_bus_message_is_method_error: (m: BusPtr, name: string | null) => number;
+  sd_bus_message_get_error: (m: BusPtr) => object | null;
+  sd_bus_message_get_reply_cookie: (m: BusPtr, cookie: [number | bigint]) => number;
+  sd_bus_message_ref: (m: BusPtr) => BusPtr;
+
+  sd_bus_message_append_string: (m: BusPtr, type: number, value: string) => number;
+  sd_bus_message_append_int32: (m: BusPtr, type: number, value: [number]) => number;
+  sd_bus_message_append_uint32: (m: BusPtr, type: number, value: [number]) => number;
+  sd_bus_message_append_int64: (m: BusPtr, type: number, value: [number | bigint]) => number;
+  sd_bus_message_append_uint64: (m: BusPtr, type: number, value: [number | bigint]) => number;
+  sd_bus_message_append_double: (m: BusPtr, type: number, value: [number]) => number;
+  sd_bus_message_open_container: (m: BusPtr, type: number, contents: string) => number;
+  sd_bus_message_close_container: (m: BusPtr) => number;
+
+  sd_bus_message_enter_container: (m: BusPtr, type: number, contents: string | null) => number;
+  sd_bus_message_exit_container: (m: BusPtr) => number;
+  sd_bus_message_peek_type: (m: BusPtr, type: [number], contents: [string | null]) => number;
+  sd_bus_message_skip: (m: BusPtr, types: string | null) => number;
+  sd_bus_message_read_string: (m: BusPtr, type: number, ret: [string | null]) => number;
+  sd_bus_message_read_uint8: (m: BusPtr, type: number, ret: [number]) => number;
+  sd_bus_message_read_int16: (m: BusPtr, type: number, ret: [number]) => number;
+  sd_bus_message_read_uint16: (m: BusPtr, type: number, ret: [number]) => number;
+  sd_bus_message_read_int32: (m: BusPtr, type: number, ret: [number]) => number;
+  sd_bus_message_read_uint32: (m: BusPtr, type: number, ret: [number]) => number;
+  sd_bus_message_read_int64: (m: BusPtr, type: number, ret: [number | bigint]) => number;
+  sd_bus_message_read_uint64: (m: BusPtr, type: number, ret: [number | bigint]) => number;
+  sd_bus_message_read_double: (m: BusPtr, type: number, ret: [number]) => number;
+}
+
+// ─── Loading ─────────────────────────────────────────────────────────────────
+
+let _koffi: any = null;
+let _libsystemd: LibsystemdBindings | null = null;
+let _libsystemdAvailable: boolean | null = null;
+
+/**
+ * Loads libsystemd.so.0 once. Returns `false` when koffi or the library is
+ * unavailable (containers, musl builds without systemd).
+ */
+export function tryLoadLibsystemd(): boolean {
+  if (_libsystemdAvailable !== null) return _libsystemdAvailable;
+  try {
+    const koffi = require('koffi');
+    const lib = koffi.load('libsystemd.so.0');
+    const readBasic = (out: string) =>
+      lib.func(`int sd_bus_message_read_basic(void *m, char type, _Out_ ${out} p)`);
+    const appendBasic = (value: string) =>
+      lib.func(`int sd_bus_message_append_basic(void *m, char type, ${value} p)`);
+    _libsystemd = {
+      sd_bus_open_system: lib.func('int sd_bus_open_system(_Out_ void **ret)'),
+      sd_bus_new: lib.func('int sd_bus_new(_Out_ void **ret)'),
+      sd_bus_set_address: lib.func('int sd_bus_set_address(void *bus, str address)'),
+      sd_bus_set_bus_client: lib.func('int sd_bus_set_bus_client(void *bus, int b)'),
+      sd_bus_start: lib.func('int sd_bus_start(void *bus)'),
+      sd_bus_get_property_string: lib.func(
+        'int sd_bus_get_property_string(void *bus, str dest, str path, str iface, str member, void **error, char **ret)'
+      ),
+      sd_bus_unref: lib.func('void *sd_bus_unref(void *bus)'),
+      sd_bus_process: lib.func('int sd_bus_process(void *bus, _Out_ void **ret)'),
+      sd_bus_send: lib.func('int sd_bus_send(void *bus, void *m, _Out_ uint64_t *cookie)'),
+      sd_bus_wait: lib.func('int sd_bus_wait(void *bus, uint64_t usec)'),
+
+      sd_bus_message_new_method_call: lib.func(
+        'int sd_bus_message_new_method_call(void *bus, _Out_ void **m, str dest, str path, str iface, str member)'
+      ),
+      sd_bus_call: lib.func(
+        'int sd_bus_call(void *bus, void *m, uint64_t usec, void *error, _Out_ void **reply)'
+      ),
+      sd_bus_message_unref: lib.func('void *sd_bus_message_unref(void *m)'),
+      sd_bus_error_free: lib.func('void sd_bus_error_free(void *e)'),
+      sd_bus_message_is_signal: lib.func('int sd_bus_message_is_signal(void *m, str iface, str member)'),
+      sd_bus_message_get_path: lib.func('const char *sd_bus_message_get_path(void *m)'),
+      sd_bus_message_is_method_error: lib.func('int sd_bus_message_is_method_error(void *m, str name)'),
+      sd_bus_message_get_error: lib.func('const void *sd_bus_message_get_error(void *m)'),
+      sd_bus_message_get_reply_cookie: lib.func(
+        'int sd_bus_message_get_reply_cookie(void *m, _Out_ uint64_t *cookie)'
+      ),
+      sd_bus_message_ref: lib.func('void *sd_bus_message_ref(void *m)'),
+
+      sd_bus_message_append_string: appendBasic('str'),
+      sd_bus_message_append_int32:  appendBasic('const int32_t *'),
+      sd_bus_message_append_uint32: appendBasic('const uint32_t *'),
+      sd_bus_message_append_int64:  appendBasic('const int64_t *'),
+      sd_bus_message_append_uint64: appendBasic('const uint64_t *'),
+      sd_bus_message_append_double: appendBasic('const double *'),
+      sd_bus_message_open_container: lib.func(
+        'int sd_bus_message_open_container(void *m, char type, str contents)'
+      ),
+      sd_bus_message_close_container: lib.func('int sd_bus_message_close_container(void *m)'),
+
+      sd_bus_message_enter_container: lib.func(
+        'int sd_bus_message_enter_container(void *m, char type, str contents)'
+      ),
+      sd_bus_message_exit_container: lib.func('int sd_bus_message_exit_container(void *m)'),
+      sd_bus_message_peek_type: lib.func(
+        'int sd_bus_message_peek_type(void *m, _Out_ uint8_t *type, _Out_ const char **contents)'
+      ),
+      sd_bus_message_skip: lib.func('int sd_bus_message_skip(void *m, str types)'),
+      sd_bus_message_read_string: readBasic('const char **'),
+      sd_bus_message_read_uint8:  readBasic('uint8_t *'),
+      sd_bus_message_read_int16:  readBasic('int16_t *'),
+      sd_bus_message_read_uint16: readBasic('uint16_t *'),
+      sd_bus_message_read_int32:  readBasic('int32_t *'),
+      sd_bus_message_read_uint32: readBasic('uint32_t *'),
+      sd_bus_message_read_int64:  readBasic('int64_t *'),
+      sd_bus_message_read_uint64: readBasic('uint64_t *'),
+      sd_bus_message_read_double: readBasic('double *')
+    };
+    _koffi = koffi;
+    _libsystemdAvailable = true;
+  } catch {
+    _libsystemdAvailable = false;
+  }
+  return _libsystemdAvailable;
+}
+
+/** The loaded bindings. Only valid after `tryLoadLibsystemd()` returned true. */
+export function libsystemd(): LibsystemdBindings {
+  return _libsystemd!;
+}
+
+export const SYSTEMD_DEST    = 'org.freedesktop.systemd1';
+export const SYSTEMD_PATH    = '/org/freedesktop/systemd1';
+export const MANAGER_IFACE   = 'org.freedesktop.systemd1.Manager';
+export const UNIT_IFACE      = 'org.freedesktop.systemd1.Unit';
+export const PROPERTIES_IFACE = 'org.freedesktop.DBus.Properties';
+
+/** Default method call timeout (µs) — same budget as the systemctl fallback. */
+const CALL_TIMEOUT_USEC = 5_000_000;
+
+// ─── Bus connections ─────────────────────────────────────────────────────────
+
+/**
+ * Opens a new connection to the system bus.
+ * @throws If the bus cannot be reached.
+ */
+export function openSystemBus(): BusPtr {
+  const busRef: [BusPtr | null] = [null];
+  if (libsystemd().sd_bus_open_system(busRef) < 0 || busRef[0] === null) {
+    throw new Error('sd_bus_open_system failed');
+  }
+  return busRef[0];
+}
+
+/**
+ * Connects to the UNIX socket at `socketPath`: a bus daemon's socket
+ * (`busClient`, with the Hello handshake) or systemd's private peer-to-peer
+ * socket (`/run/systemd/private`).
+ * @throws If the socket cannot be reached.
+ */
+export function openBusAt(socketPath: string, busClient: boolean): BusPtr {
+  const lib = libsystemd();
+  const busRef: [BusPtr | null] = [null];
+  if (lib.sd_bus_new(busRef) < 0 || busRef[0] === null) {
+    throw new Error('sd_bus_new failed');
+  }
+  const bus = busRef[0];
+  // D-Bus addresses escape everything outside [-0-9A-Za-z_/.\\]
+  const escaped = socketPath.replace(/[^-0-9A-Za-z_/.\\]/g, c => `%${c.charCodeAt(0).toString(16).padStart(2, '0')}`);
+  let r = lib.sd_bus_set_address(bus, `unix:path=${escaped}`);
+  if (r >= 0) r = lib.sd_bus_set_bus_client(bus, busClient ? 1 : 0);
+  if (r >= 0) r = lib.sd_bus_start(bus);
+  if (r < 0) {
+    lib.sd_bus_unref(bus);
+    throw new Error(`cannot connect to ${socketPath} (errno ${-r})`);
+  }
+  return bus;
+}
+
+/** Releases a bus connection. */
+export function closeBus(bus: BusPtr): void {
+  libsystemd().sd_bus_unref(bus);
+}
+
+/** How long the shared connection stays open without calls, in ms. */
+const SHARED_IDLE_MS = 1000;
+
+let _shared: BusPtr | null = null;
+let _sharedLastUse = 0;
+let _sharedTimer: NodeJS.Timeout | null = null;
+
+/**
+ * The system bus connection shared by control calls (transient units,
+ * resource changes), so that a burst of them connects once. Opened on first
+ * use, closed after a second without use. Main thread only: never pass it to
+ * an asynchronous (threadpool) call.
+ *
+ * @throws If the bus cannot be reached.
+ */
+export function sharedSystemBus(): BusPtr {
+  _sharedLastUse = Date.now();
+  if (!_shared) _shared = openSystemBus();
+  if (!_sharedTimer) {
+    const idle = () => {
+      if (Date.now() - _sharedLastUse < SHARED_IDLE_MS) {
+        _sharedTimer = setTimeout(idle, SHARED_IDLE_MS);
+        _sharedTimer.unref();
+        return;
+      }
+      _sharedTimer = null;
+      dropSharedBus();
+    };
+    _sharedTimer = setTimeout(idle, SHARED_IDLE_MS);
+    _sharedTimer.unref();
+  }
+  return _shared;
+}
+
+/**
+ * Closes the shared connection; the next `sharedSystemBus()` reconnects.
+ * Called after transport errors, which may leave it unusable.
+ */
+export function dropSharedBus(): void {
+  if (_shared) closeBus(_shared);
+  _shared = null;
+}
+
+/** Runs `fn` with a fresh system bus connection, released afterwards. */
+export function withSystemBus<T>(fn: (bus: BusPtr) => T): T {
+  const bus = openSystemBus();
+  try {
+    return fn(bus);
+  } finally {
+    closeBus(bus);
+  }
+}
+
+// ─── Method calls ────────────────────────────────────────────────────────────
+
+/**
+ * A D-Bus error returned by the peer, e.g.
+ * `org.freedesktop.systemd1.NoSuchUnit`.
+ */
+export class BusCallError extends Error {
+  constructor(readonly busError: string, message: string) {
+    super(message);
+  }
+}
+
+const SD_BUS_ERROR_SIZE = 24; // { const char *name; const char *message; int _need_free; }
+
+/** Builds a method call message; append arguments through `writer`. */
+export function newMethodCall(
+  bus: BusPtr, path: string, iface: string, member: string, dest = SYSTEMD_DEST
+): BusPtr {
+  const ref: [BusPtr | null] = [null];
+  const r = libsystemd().sd_bus_message_new_method_call(bus, ref, dest, path, iface, member);
+  if (r < 0 || ref[0] === null) {
+    throw new Error(`sd_bus_message_new_method_call(${member}) failed (errno ${-r})`);
+  }
+  return ref[0];
+}
+
+/**
+ * Sends `m` and waits for the reply. The request message is released; the
+ * caller owns the returned reply and must pass it to `freeMessage`.
+ *
+ * @throws {BusCallError} If the peer replied with a D-Bus error.
+ */
+export function call(bus: BusPtr, m: BusPtr, member: string, timeoutUsec = CALL_TIMEOUT_USEC): BusPtr {
+  const lib = libsystemd();
+  const koffi = _koffi;
+  const err = koffi.alloc('uint8_t', SD_BUS_ERROR_SIZE);
+  koffi.encode(err, koffi.array('uint8_t', SD_BUS_ERROR_SIZE), new Array(SD_BUS_ERROR_SIZE).fill(0));
+  const ref: [BusPtr | null] = [null];
+  try {
+    const r = lib.sd_bus_call(bus, m, timeoutUsec, err, ref);
+    if (r < 0 || ref[0] === null) {
+      const name    = koffi.decode(err, 0, 'const char *') as string | null;
+      const message = koffi.decode(err, 8, 'const char *') as string | null;
+      lib.sd_bus_error_free(err);
+      throw new BusCallError(name || `errno ${-r}`, `${member} failed: ${message || name || `errno ${-r}`}`);
+    }
+    return ref[0];
+  } finally {
+    koffi.free(err);
+    lib.sd_bus_message_unref(m);
+  }
+}
+
+/** The D-Bus error carried by a method error reply. */
+function replyError(m: BusPtr, member: string): BusCallError {
+  const e = libsystemd().sd_bus_message_get_error(m);
+  const name    = e ? _koffi.decode(e, 0, 'const char *') as string | null : null;
+  const message = e ? _koffi.decode(e, 8, 'const char *') as string | null : null;
+  return new BusCallError(name || 'unknown', `${member} failed: ${message || name || 'unknown error'}`);
+}
+
+/**
+ * Sends every message before reading any reply, so that `n` calls cost
+ * about one round trip instead of `n`. Returns the replies in order, each a
+ * reply message (to be released with `freeMessage`) or the `BusCallError`
+ * it failed with; calls unanswered within `timeoutUsec` fail with
+ * `org.freedesktop.DBus.Error.Timeout`. The request messages are released.
+ *
+ * Blocks like `call`, for the time of the slowest reply.
+ */
+export function callPipelined(
+  bus: BusPtr, messages: readonly BusPtr[], member: string, timeoutUsec = CALL_TIMEOUT_USEC
+): Array<BusPtr | BusCallError> {
+  const lib = libsystemd();
+  const results: Array<BusPtr | BusCallError | undefined> = new Array(messages.length);
+  /** Message index by cookie. */
+  const pending = new Map<string, number>();
+  try {
+    messages.forEach((m, i) => {
+      const cookie: [number | bigint] = [0];
+      const r = lib.sd_bus_send(bus, m, cookie);
+      if (r < 0) results[i] = new BusCallError(`errno ${-r}`, `${member} failed: errno ${-r}`);
+      else pending.set(String(cookie[0]), i);
+    });
+  } finally {
+    for (const m of messages) lib.sd_bus_message_unref(m);
+  }
+
+  const deadline = Date.now() + timeoutUsec / 1000;
+  try {
+    while (pending.size > 0) {
+      processBus(bus, m => {
+        const cookie: [number | bigint] = [0];
+        if (lib.sd_bus_message_get_reply_cookie(m, cookie) < 0) return;
+        const i = pending.get(String(cookie[0]));
+        if (i === undefined) return;
+        pending.delete(String(cookie[0]));
+        results[i] = lib.sd_bus_message_is_method_error(m, null) > 0
+          ? replyError(m, member)
+          : lib.sd_bus_message_ref(m);
+      });
+      const left = deadline - Date.now();
+      if (pending.size === 0 || left <= 0) break;
+      check(lib.sd_bus_wait(bus, Math.ceil(left * 1000)), 'sd_bus_wait');
+    }
+  } catch (e) {
+    for (const r of results) if (r && !(r instanceof BusCallError)) lib.sd_bus_message_unref(r);
+    throw e;
+  }
+  for (const i of pending.values()) {
+    results[i] = new BusCallError('org.freedesktop.DBus.Error.Timeout', `${member} failed: no reply`);
+  }
+  return results as Array<BusPtr | BusCallError>;
+}
+
+/**
+ * Like `call`, without blocking the event loop: `m` is sent, then the reply
+ * is awaited with `waitBus` on a threadpool thread. Rejects with
+ * `org.freedesktop.DBus.Error.Timeout` if no reply came within `timeoutUsec`.
+ *
+ * `bus` must not be used by anything else until the promise settles; open a
+ * connection of its own for the call.
+ */
+export async function callAsync(
+  bus: BusPtr, m: BusPtr, member: string, timeoutUsec = CALL_TIMEOUT_USEC
+): Promise<BusPtr> {
+  const lib = libsystemd();
+  const cookie: [number | bigint] = [0];
+  let r: number;
+  try {
+    r = lib.sd_bus_send(bus, m, cookie);
+  } finally {
+    lib.sd_bus_message_unref(m);
+  }
+  if (r < 0) throw new BusCallError(`errno ${-r}`, `${member} failed: errno ${-r}`);
+
+  const deadline = Date.now() + timeoutUsec / 1000;
+  const result: { reply?: BusPtr | BusCallError } = {};
+  while (!result.reply) {
+    const left = deadline - Date.now();
+    if (left <= 0) throw new BusCallError('org.freedesktop.DBus.Error.Timeout', `${member} failed: no reply`);
+    await waitBus(bus, left);
+    processBus(bus, msg => {
+      const replyCookie: [number | bigint] = [0];
+      if (result.reply || lib.sd_bus_message_get_reply_cookie(msg, replyCookie) < 0) return;
+      if (String(replyCookie[0]) !== String(cookie[0])) return;
+      result.reply = lib.sd_bus_message_is_method_error(msg, null) > 0
+        ? replyError(msg, member)
+        : lib.sd_bus_message_ref(msg);
+    });
+  }
+  if (result.reply instanceof BusCallError) throw result.reply;
+  return result.reply;
+}
+
+/**
+ * Convenience wrapper: builds, sends and returns the reply of a systemd
+ * method call. `writer` appends the arguments, if any.
+ */
+export function callMethod(
+  bus: BusPtr, path: string, iface: string, member: string,
+  writer?: (w: BusMessageWriter) => void
+): BusPtr {
+  const m = newMethodCall(bus, path, iface, member);
+  try {
+    if (writer) writer(new BusMessageWriter(m));
+  } catch (e) {
+    libsystemd().sd_bus_message_unref(m);
+    throw e;
+  }
+  return call(bus, m, member);
+}
+
+/** Releases a message returned by `call`/`callMethod`. */
+export function freeMessage(m: BusPtr): void {
+  libsystemd().sd_bus_message_unref(m);
+}
+
+// ─── Signals ─────────────────────────────────────────────────────────────────
+
+export const DBUS_DEST  = 'org.freedesktop.DBus';
+export const DBUS_PATH  = '/org/freedesktop/DBus';
+export const DBUS_IFACE = 'org.freedesktop.DBus';
+
+/**
+ * Asks the bus daemon to route messages matching `rule` (D-Bus match rule
+ * syntax) to this connection. They are then received by `processBus`.
+ */
+export function addMatch(bus: BusPtr, rule: string): void {
+  const m = newMethodCall(bus, DBUS_PATH, DBUS_IFACE, 'AddMatch', DBUS_DEST);
+  try {
+    new BusMessageWriter(m).string(rule);
+  } catch (e) {
+    libsystemd().sd_bus_message_unref(m);
+    throw e;
+  }
+  freeMessage(call(bus, m, 'AddMatch'));
+}
+
+/**
+ * Processes everything pending on `bus` without blocking, passing each
+ * received message no call was waiting for (signals, mostly) to `onMessage`.
+ * Messages are released after `onMessage` returns.
+ */
+export function processBus(bus: BusPtr, onMessage: (m: BusPtr) => void): void {
+  const lib = libsystemd();
+  for (;;) {
+    const ref: [BusPtr | null] = [null];
+    const r = check(lib.sd_bus_process(bus, ref), 'sd_bus_process');
+    if (ref[0] !== null) {
+      try {
+        onMessage(ref[0]);
+      } finally {
+        lib.sd_bus_message_unref(ref[0]);
+      }
+    }
+    if (r === 0) return;
+  }
+}
+
+/**
+ * Waits up to `timeoutMs` for `bus` to become readable, on a threadpool
+ * thread. Resolves to `false` on timeout.
+ */
+export function waitBus(bus: BusPtr, timeoutMs: number): Promise<boolean> {
+  return new Promise((resolve, reject) => {
+    libsystemd().sd_bus_wait.async(bus, Math.floor(timeoutMs * 1000), (err, r) => {
+      if (err) reject(err);
+      else if (r < 0) reject(new Error(`sd_bus_wait failed (errno ${-r})`));
+      else resolve(r > 0);
+    });
+  });
+}
+
+/** Whether `m` is the signal `iface.member`. */
+export function isSignal(m: BusPtr, iface: string, member: string): boolean {
+  return libsystemd().sd_bus_message_is_signal(m, iface, member) > 0;
+}
+
+/** The object path `m` was sent from or to, if any. */
+export function messagePath(m: BusPtr): string | null {
+  return libsystemd().sd_bus_message_get_path(m);
+}
+
+// ─── Signature helpers ───────────────────────────────────────────────────────
+
+const code = (type: string) => type.charCodeAt(0);
+
+function check(r: number, what: string): number {
+  if (r < 0) throw new Error(`${what} failed (errno ${-r})`);
+  return r;
+}
+
+/** Appends arguments to an outgoing message. */
+export class BusMessageWriter {
+  constructor(readonly m: BusPtr) {}
+
+  string(value: string, type: 's' | 'o' | 'g' = 's'): this {
+    check(libsystemd().sd_bus_message_append_string(this.m, code(type), value), 'append_basic');
+    return this;
+  }
+
+  boolean(value: boolean): this {
+    check(libsystemd().sd_bus_message_append_int32(this.m, code('b'), [value ? 1 : 0]), 'append_basic');
+    return this;
+  }
+
+  int32(value: number): this {
+    check(libsystemd().sd_bus_message_append_int32(this.m, code('i'), [value]), 'append_basic');
+    return this;
+  }
+
+  uint32(value: number): this {
+    check(libsystemd().sd_bus_message_append_uint32(this.m, code('u'), [value]), 'append_basic');
+    return this;
+  }
+
+  int64(value: number | bigint): this {
+    check(libsystemd().sd_bus_message_append_int64(this.m, code('x'), [value]), 'append_basic');
+    return this;
+  }
+
+  uint64(value: number | bigint): this {
+    check(libsystemd().sd_bus_message_append_uint64(this.m, code('t'), [value]), 'append_basic');
+    return this;
+  }
+
+  double(value: number): this {
+    check(libsystemd().sd_bus_message_append_double(this.m, code('d'), [value]), 'append_basic');
+    return this;
+  }
+
+  open(type: 'a' | 'r' | 'v' | 'e', contents: string): this {
+    check(libsystemd().sd_bus_message_open_container(this.m, code(type), contents), 'open_container');
+    return this;
+  }
+
+  close(): this {
+    check(libsystemd().sd_bus_message_close_container(this.m), 'close_container');
+    return this;
+  }
+
+  /** Appends an `as` array. */
+  strings(values: readonly string[]): this {
+    this.open('a', 's');
+    for (const v of values) this.string(v);
+    return this.close();
+  }
+
+  /**
+   * Appends `value` as the single complete type `signature`. Arrays take JS
+   * arrays (`a{..}` dictionaries also take plain objects), structs take
+   * tuples, and variants take a `[signature, value]` pair.
+   */
+  append(signature: string, value: unknown): this {
+    const type = signature[0];
+    switch (type) {
+      case 's': case 'o': case 'g':
+        return this.string(String(value), type);
+      case 'b': return this.boolean(Boolean(value));
+      case 'i': return this.int32(Number(value));
+      case 'u': return this.uint32(Number(value));
+      case 'x': return this.int64(value as number | bigint);
+      case 't': return this.uint64(value as number | bigint);
+      case 'd': return this.double(Number(value));
+      case 'v': {
+        if (!Array.isArray(value) || value.length !== 2 || typeof value[0] !== 'string') {
+          throw new TypeError('variant values must be [signature, value] pairs');
+        }
+        return this.open('v', value[0]).append(value[0], value[1]).close();
+      }
+      case '(': {
+        const fields = splitSignature(signature.slice(1, -1));
+        if (!Array.isArray(value) || value.length !== fields.length) {
+          throw new TypeError(`struct ${signature} needs ${fields.length} fields`);
+        }
+        this.open('r', signature.slice(1, -1));
+        fields.forEach((field, i) => this.append(field, value[i]));
+        return this.close();
+      }
+      case 'a': {
+        const element = signature.slice(1);
+        this.open('a', element);
+        if (element[0] === '{') {
+          const [key, val] = splitSignature(element.slice(1, -1));
+          const entries = Array.isArray(value) ? value : Object.entries(value as object);
+          for (const [k, v] of entries) this.open('e', element.slice(1, -1)).append(key, k).append(val, v).close();
+        } else {
+          if (!Array.isArray(value)) throw new TypeError(`${signature} values must be arrays`);
+          for (const item of value) this.append(element, item);
+        }
+        return this.close();
+      }
+      default:
+        throw new TypeError(`unsupported D-Bus type "${signature}"`);
+    }
+  }
+}
+
+/** Splits a signature into its complete types (`a{sv}(sb)s` → `a{sv}`, `(sb)`, `s`). */
+export function splitSignature(signature: string): string[] {
+  const types: string[] = [];
+  let i = 0;
+  while (i < signature.length) {
+    const start = i;
+    while (signature[i] === 'a') i++;
+    if (signature[i] === '(' || signature[i] === '{') {
+      let depth = 0;
+      do {
+        const c = signature[i++];
+        if (c === '(' || c === '{') depth++;
+        else if (c === ')' || c === '}') depth--;
+      } while (depth > 0 && i < signature.length);
+      if (depth > 0) throw new TypeError(`unbalanced signature "${signature}"`);
+    } else {
+      if (i >= signature.length) throw new TypeError(`incomplete signature "${signature}"`);
+      i++;
+    }
+    types.push(signature.slice(start, i));
+  }
+  return types;
+}
+
+// ─── Message reader ──────────────────────────────────────────────────────────
+
+/**
+ * Sequential decoder over a received message. Every method advances the
+ * read cursor; `peek()` returns `null` at the end of the current container.
+ */
+export class BusMessageReader {
+  constructor(readonly m: BusPtr) {}
+
+  /** Enters a container; returns `false` when the enclosing one is exhausted. */
+  enter(type: 'a' | 'r' | 'v' | 'e', contents: string | null): boolean {
+    return check(libsystemd().sd_bus_message_enter_container(this.m, code(type), contents), 'enter_container') > 0;
+  }
+
+  exit(): void {
+    check(libsystemd().sd_bus_message_exit_container(this.m), 'exit_container');
+  }
+
+  /** Type and contents signature of the next element, or `null` at the end. */
+  peek(): { type: string; contents: string | null } | null {
+    const type: [number] = [0];
+    const contents: [string | null] = [null];
+    if (check(libsystemd().sd_bus_message_peek_type(this.m, type, contents), 'peek_type') === 0) return null;
+    return { type: String.fromCharCode(type[0]), contents: contents[0] };
+  }
+
+  /** Skips the next complete type (or the given signature). */
+  skip(types: string | null = null): void {
+    check(libsystemd().sd_bus_message_skip(this.m, types), 'skip');
+  }
+
+  string(type: 's' | 'o' | 'g' = 's'): string {
+    const ref: [string | null] = [null];
+    check(libsystemd().sd_bus_message_read_string(this.m, code(type), ref), 'read_basic');
+    return ref[0] ? String(ref[0]) : '';
+  }
+
+  uint32(): number {
+    return this.readNumber('u');
+  }
+
+  int32(): number {
+    return this.readNumber('i');
+  }
+
+  uint64(): number {
+    return this.readNumber('t');
+  }
+
+  boolean(): boolean {
+    return this.readNumber('b') !== 0;
+  }
+
+  /**
+   * Reads the next complete value of any type: basic types map to strings,
+   * numbers and booleans; arrays to JS arrays; `a{..}` dictionaries to plain
+   * objects; structs to tuples; variants to their payload.
+   */
+  value(): unknown {
+    const next = this.peek();
+    if (!next) throw new Error('read past end of container');
+    const { type, contents } = next;
+    switch (type) {
+      case 's': case 'o': case 'g':
+        return this.string(type);
+      case 'b':
+        return this.boolean();
+      case 'y': case 'n': case 'q': case 'i': case 'u': case 'x': case 't': case 'd': case 'h':
+        return this.readNumber(type);
+      case 'v': {
+        this.enter('v', contents);
+        const v = this.value();
+        this.exit();
+        return v;
+      }
+      case 'r': {
+        this.enter('r', contents);
+        const fields: unknown[] = [];
+        while (this.peek()) fields.push(this.value());
+        this.exit();
+        return fields;
+      }
+      case 'a': {
+        this.enter('a', contents);
+        if (contents && contents.startsWith('{')) {
+          const dict: Record<string, unknown> = {};
+          while (this.enter('e', contents.slice(1, -1))) {
+            const key = String(this.value());
+            dict[key] = this.value();
+            this.exit();
+          }
+          this.exit();
+          return dict;
+        }
+        const items: unknown[] = [];
+        while (this.peek()) items.push(this.value());
+        this.exit();
+        return items;
+      }
+      default:
+        this.skip();
+        return undefined;
+    }
+  }
+
+  /**
+   * Reads an `a{sv}` property dictionary (e.g. a Properties.GetAll reply).
+   * With `wanted`, only those entries are decoded; the rest are skipped.
+   */
+  properties(wanted?: ReadonlySet<string>): Record<string, unknown> {
+    if (!wanted) return this.value() as Record<string, unknown>;
+    const props: Record<string, unknown> = {};
+    this.enter('a', '{sv}');
+    while (this.enter('e', 'sv')) {
+      const key = this.string();
+      if (wanted.has(key)) props[key] = this.value();
+      else this.skip('v');
+      this.exit();
+    }
+    this.exit();
+    return props;
+  }
+
+  private readNumber(type: string): number {
+    const lib = libsystemd();
+    const ref: [number | bigint] = [0];
+    const t = code(type);
+    let r: number;
+    switch (type) {
+      case 'y':           r = lib.sd_bus_message_read_uint8(this.m, t, ref as [number]); break;
+      case 'n':           r = lib.sd_bus_message_read_int16(this.m, t, ref as [number]); break;
+      case 'q':           r = lib.sd_bus_message_read_uint16(this.m, t, ref as [number]); break;
+      case 'b': case 'i': case 'h':
+                          r = lib.sd_bus_message_read_int32(this.m, t, ref as [number]); break;
+      case 'u':           r = lib.sd_bus_message_read_uint32(this.m, t, ref as [number]); break;
+      case 'x':           r = lib.sd_bus_message_read_int64(this.m, t, ref); break;
+      case 't':           r = lib.sd_bus_message_read_uint64(this.m, t, ref); break;
+      default:            r = lib.sd_bus_message_read_double(this.m, t, ref as [number]); break;
+    }
+    check(r, 'read_basic');
+    return Number(ref[0]);
+  }
+}
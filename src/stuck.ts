@@ -0,0 +1,411 @@
+'use strict';
+
+/**
+ * Detection of services wedged in a transition: `START_PENDING` or
+ * `STOP_PENDING` (systemd `activating`/`deactivating`, OpenRC
+ * `starting`/`stopping`) for longer than they are allowed.
+ *
+ * Nothing is scanned. A one-shot timer is armed when a service is seen
+ * entering a pending state and disarmed when it leaves it; only when a timer
+ * expires is the service queried again, to confirm it is still in the same
+ * transition before it is reported.
+ *
+ * Transitions are seen through events: on systemd, the manager's `JobNew`/
+ * `JobRemoved` signals and each watched unit's `PropertiesChanged`; elsewhere
+ * process events (root) or pidfile events, plus OpenRC's `starting`/
+ * `stopping` state directories. Each event re-queries its service. The
+ * adaptive poller is only used when asked for (`source: 'poll'`).
+ *
+ * The budget of a transition is, in order: the per-service budget given in
+ * the options, the unit's `TimeoutStartUSec`/`TimeoutStopUSec` (systemd,
+ * when finite, or the `unitTimeout` option), else the default budget. With systemd's monotonic
+ * timestamps the transition's start is known exactly, even when it was
+ * observed late.
+ */
+
+import fs from 'fs';
+import {
+  ServiceStatus, ServiceChange, ServiceWatcher
+} from './types';
+import {
+  getServiceStatus, getUnitProperties, detectInitSystem, timespanToMs, unitName, unitObjectPath
+} from './linux';
+import { pollServices, PollOptions } from './poller';
+import { watchPidFiles } from './pidwatch';
+import { watchProcEvents } from './procevents';
+import {
+  tryLoadLibsystemd, openSystemBus, closeBus, addMatch, callMethod, freeMessage, processBus, waitBus,
+  isSignal, messagePath, BusMessageReader, BusPtr, SYSTEMD_DEST, SYSTEMD_PATH, MANAGER_IFACE, PROPERTIES_IFACE
+} from './sdbus';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+export type PendingState = 'START_PENDING' | 'STOP_PENDING';
+
+/** A service found past its budget in a transition. */
+export interface StuckTransition {
+  name: string;
+  state: PendingState;
+  /** When the transition began, in ms since the Unix epoch. */
+  since: number;
+  /** Time spent in the transition so far, in ms. */
+  elapsed: number;
+  /** The budget it exceeded, in ms. */
+  budget: number;
+  /** Where the budget came from. */
+  budgetSource: 'service' | 'unit' | 'default';
+}
+
+export type StuckListener = (stuck: StuckTransition) => void;
+
+export interface StuckDetectorOptions {
+  /** Budget when the unit gives none (non-systemd, or infinite timeout), in ms. Default 90000. */
+  budget?: number;
+  /** Budgets per service name, in ms; these take precedence over unit timeouts. */
+  budgets?: Record<string, number>;
+  /** Extra time allowed past the budget before reporting, in ms. Default 1000. */
+  grace?: number;
+  /** Called when confirming a transition fails. */
+  onError?: (err: Error) => void;
+  /** Status query used to confirm an expired transition. Defaults to `getServiceStatus`. */
+  query?: (name: string) => Promise<ServiceStatus>;
+  /**
+   * Timeout of a service's unit for a transition, in ms, or `null` for none.
+   * Defaults to `systemdUnitTimeout` on systemd, unless a custom `query` is
+   * given: statuses from elsewhere are not timed by this host's units.
+   */
+  unitTimeout?: (name: string, state: PendingState) => number | null;
+}
+
+export interface WatchStuckOptions extends StuckDetectorOptions {
+  /**
+   * How transitions are observed. `'events'` (default): systemd's job and
+   * property signals; elsewhere, or with a custom `query`, process events
+   * when permitted, else pidfile events, plus OpenRC's state directories.
+   * `'poll'`: the adaptive poller, for hosts where none of those is usable.
+   */
+  source?: 'events' | 'poll';
+  /** Options of the poller, with `source: 'poll'`. */
+  poll?: PollOptions;
+  /** Pidfile directories watched outside systemd. Default `['/run', '/var/run']`. */
+  dirs?: readonly string[];
+  /** OpenRC state directory, whose `starting`/`stopping` entries mark transitions. Default `/run/openrc`. */
+  openrcDir?: string;
+}
+
+interface Armed {
+  state: PendingState;
+  /** Transition start, ms since the epoch. */
+  since: number;
+  /** systemd transition timestamp (µs monotonic) identifying it, or 0. */
+  marker: number;
+  timer: NodeJS.Timeout | null;
+  /** Already reported; kept so the same transition is not timed again. */
+  reported: boolean;
+}
+
+const isPending = (state: string): state is PendingState => state === 'START_PENDING' || state === 'STOP_PENDING';
+
+/** CLOCK_MONOTONIC in µs — the clock of systemd's `*TimestampMonotonic`. */
+const monotonicUs = () => Number(process.hrtime.bigint() / 1000n);
+
+/** The systemd timestamp at which the current pending state began, or 0. */
+function transitionMarker(status: ServiceStatus, state: PendingState): number {
+  const ts = status.timestamps;
+  if (!ts) return 0;
+  return state === 'START_PENDING' ? ts.inactiveExit : ts.activeExit;
+}
+
+/** The unit's `TimeoutStartUSec` or `TimeoutStopUSec`, in ms, or `null` if infinite. systemd only. */
+export function systemdUnitTimeout(name: string, state: PendingState): number | null {
+  const property = state === 'START_PENDING' ? 'TimeoutStartUSec' : 'TimeoutStopUSec';
+  // A D-Bus number, or systemctl's `1min 30s`
+  return timespanToMs(getUnitProperties([name], [property])[0][property]);
+}
+
+// ─── Detector ─────────────────────────────────────────────────────────────────
+
+export class StuckDetector {
+  private readonly armed = new Map<string, Armed>();
+  private readonly defaultBudget: number;
+  private readonly grace: number;
+  private readonly unitTimeout: StuckDetectorOptions['unitTimeout'] | null;
+  private closed = false;
+
+  constructor(private readonly listener: StuckListener, private readonly options: StuckDetectorOptions = {}) {
+    this.defaultBudget = Math.max(0, options.budget ?? 90_000);
+    this.grace = Math.max(0, options.grace ?? 1000);
+    this.unitTimeout = options.unitTimeout
+      ?? (!options.query && detectInitSystem() === 'systemd' ? systemdUnitTimeout : null);
+  }
+
+  /** Arms or disarms the timer of a service from one observation. */
+  observe(change: ServiceChange): void {
+    if (this.closed) return;
+    const { name, current } = change;
+    const armed = this.armed.get(name);
+    if (!isPending(current.state)) {
+      if (armed) this.disarm(name);
+      return;
+    }
+    const marker = transitionMarker(current, current.state);
+    if (armed && armed.state === current.state && armed.marker === marker) return;
+    if (armed) this.disarm(name);
+
+    const since = marker > 0 ? Date.now() - (monotonicUs() - marker) / 1000 : change.timestamp;
+    const { budget, budgetSource } = this.budgetOf(name, current.state);
+    const delay = Math.max(0, since + budget + this.grace - Date.now());
+    const timer = setTimeout(() => { void this.expire(name, budget, budgetSource); }, delay);
+    this.armed.set(name, { state: current.state, since, marker, timer, reported: false });
+  }
+
+  /** Number of transitions currently being timed. */
+  get pending(): number {
+    let n = 0;
+    for (const armed of this.armed.values()) if (!armed.reported) n++;
+    return n;
+  }
+
+  close(): void {
+    this.closed = true;
+    for (const name of [...this.armed.keys()]) this.disarm(name);
+  }
+
+  private disarm(name: string): void {
+    const armed = this.armed.get(name);
+    if (armed?.timer) clearTimeout(armed.timer);
+    this.armed.delete(name);
+  }
+
+  private budgetOf(name: string, state: PendingState): Pick<StuckTransition, 'budget' | 'budgetSource'> {
+    const configured = this.options.budgets?.[name];
+    if (configured !== undefined) return { budget: configured, budgetSource: 'service' };
+    if (this.unitTimeout) {
+      try {
+        const timeout = this.unitTimeout(name, state);
+        if (timeout !== null && timeout > 0 && Number.isFinite(timeout)) return { budget: timeout, budgetSource: 'unit' };
+      } catch (err) {
+        this.options.onError?.(err as Error);
+      }
+    }
+    return { budget: this.defaultBudget, budgetSource: 'default' };
+  }
+
+  private async expire(name: string, budget: number, budgetSource: StuckTransition['budgetSource']): Promise<void> {
+    const armed = this.armed.get(name);
+    if (!armed || this.closed) return;
+    armed.timer = null;
+    let status: ServiceStatus;
+    try {
+      status = await (this.options.query ?? getServiceStatus)(name);
+    } catch (err) {
+      this.options.onError?.(err as Error);
+      return;
+    }
+    // Re-check: the transition may have ended (or restarted) unobserved.
+    if (this.closed || this.armed.get(name) !== armed) return;
+    if (status.state !== armed.state || transitionMarker(status, armed.state) !== armed.marker) {
+      this.armed.delete(name);
+      this.observe({ name, previous: null, current: status, timestamp: Date.now() });
+      return;
+    }
+    armed.reported = true;
+    this.listener({
+      name,
+      state: armed.state,
+      since: Math.round(armed.since),
+      elapsed: Math.round(Date.now() - armed.since),
+      budget,
+      budgetSource
+    });
+  }
+}
+
+// ─── Event sources ────────────────────────────────────────────────────────────
+
+/** Delay (ms) coalescing the burst of events one transition produces. */
+const REQUERY_DELAY = 20;
+
+/**
+ * systemd: calls `onUnit(name)` for each `JobNew`/`JobRemoved` of one of
+ * `names`' units and each `PropertiesChanged` on its object path. The
+ * signals arrive on a subscribed connection of its own, read with bounded
+ * waits on the threadpool.
+ */
+function watchUnitSignals(
+  names: readonly string[], onUnit: (name: string) => void, onError: (err: Error) => void
+): ServiceWatcher {
+  const byUnit = new Map<string, string>();
+  const byPath = new Map<string, string>();
+  for (const name of names) {
+    byUnit.set(unitName(name), name);
+    byPath.set(unitObjectPath(name), name);
+  }
+  const bus = openSystemBus();
+  try {
+    for (const member of ['JobNew', 'JobRemoved']) {
+      addMatch(bus, `type='signal',sender='${SYSTEMD_DEST}',path='${SYSTEMD_PATH}',` +
+        `interface='${MANAGER_IFACE}',member='${member}'`);
+    }
+    for (const path of byPath.keys()) {
+      addMatch(bus, `type='signal',sender='${SYSTEMD_DEST}',path='${path}',` +
+        `interface='${PROPERTIES_IFACE}',member='PropertiesChanged'`);
+    }
+    // Without a subscriber the manager may not emit job signals at all.
+    freeMessage(callMethod(bus, SYSTEMD_PATH, MANAGER_IFACE, 'Subscribe'));
+  } catch (e) {
+    closeBus(bus);
+    throw e;
+  }
+
+  const dispatch = (m: BusPtr) => {
+    let name: string | undefined;
+    if (isSignal(m, MANAGER_IFACE, 'JobNew') || isSignal(m, MANAGER_IFACE, 'JobRemoved')) {
+      // JobNew(u id, o job, s unit), JobRemoved(u id, o job, s unit, s result)
+      const reader = new BusMessageReader(m);
+      reader.uint32();
+      reader.string('o');
+      name = byUnit.get(reader.string());
+    } else if (isSignal(m, PROPERTIES_IFACE, 'PropertiesChanged')) {
+      name = byPath.get(messagePath(m) ?? '');
+    }
+    if (name !== undefined) onUnit(name);
+  };
+
+  let closed = false;
+  void (async () => {
+    try {
+      while (!closed) {
+        processBus(bus, dispatch);
+        // Bounded waits, so closing is noticed promptly.
+        await waitBus(bus, 250);
+      }
+    } catch (e) {
+      if (!closed) onError(e as Error);
+    } finally {
+      // Only once no wait is pending on the connection.
+      closeBus(bus);
+    }
+  })();
+
+  return {
+    close() {
+      closed = true;
+    }
+  };
+}
+
+/**
+ * OpenRC/SysV: process events when the proc connector can be opened (root),
+ * else pidfile events, plus OpenRC's `starting`/`stopping` directories —
+ * the only trace a transition in progress leaves there.
+ */
+async function watchHostEvents(
+  names: readonly string[],
+  query: (name: string) => Promise<ServiceStatus>,
+  onChange: (change: ServiceChange) => void,
+  onUnit: (name: string) => void,
+  options: WatchStuckOptions,
+  onError: (err: Error) => void
+): Promise<ServiceWatcher[]> {
+  const watchers: ServiceWatcher[] = [];
+  try {
+    watchers.push(await watchProcEvents(onChange, { services: names, query, onError }));
+  } catch {
+    try {
+      watchers.push(await watchPidFiles(onChange, { services: names, query, dirs: options.dirs, onError }));
+    } catch (e) {
+      onError(e as Error);
+    }
+  }
+
+  const watched = new Set(names);
+  const openrcDir = options.openrcDir ?? '/run/openrc';
+  for (const dir of ['starting', 'stopping']) {
+    try {
+      const watcher = fs.watch(`${openrcDir}/${dir}`, (_event, file) => {
+        if (file && watched.has(file.toString())) onUnit(file.toString());
+      });
+      watcher.on('error', onError);
+      watchers.push(watcher);
+    } catch {
+      // not OpenRC, or no service has been started yet
+    }
+  }
+  if (watchers.length === 0) onError(new Error("watchStuckTransitions: no event source is usable; pass source: 'poll'"));
+  return watchers;
+}
+
+// ─── Watcher ──────────────────────────────────────────────────────────────────
+
+/**
+ * Reports services of `serviceNames` that stay in a transition past their
+ * budget. Transitions are observed through events (see the module header),
+ * or by the adaptive poller with `source: 'poll'`; each reported transition
+ * is reported once.
+ *
+ * @throws If on systemd without a custom `query` and libsystemd or the
+ *         system bus is unavailable.
+ */
+export function watchStuckTransitions(
+  serviceNames: readonly string[],
+  listener: StuckListener,
+  options: WatchStuckOptions = {}
+): ServiceWatcher {
+  if (!Array.isArray(serviceNames)) {
+    throw new TypeError('serviceNames must be an array');
+  }
+  if (typeof listener !== 'function') {
+    throw new TypeError('listener must be a function');
+  }
+  const detector = new StuckDetector(listener, options);
+  const query = options.query ?? getServiceStatus;
+  const onError = options.onError ?? (() => {});
+  const names = [...new Set(serviceNames)];
+  let closed = false;
+
+  const timers = new Map<string, NodeJS.Timeout>();
+  const observe = (name: string) => {
+    query(name)
+      .then(current => {
+        if (!closed) detector.observe({ name, previous: null, current, timestamp: Date.now() });
+      })
+      .catch(err => {
+        if (!closed) onError(err as Error);
+      });
+  };
+  const requery = (name: string) => {
+    if (closed || timers.has(name)) return;
+    timers.set(name, setTimeout(() => {
+      timers.delete(name);
+      observe(name);
+    }, REQUERY_DELAY));
+  };
+
+  // No source reports its baseline; observe it separately so that services
+  // already wedged when watching starts are timed too.
+  for (const name of names) observe(name);
+
+  let sources: ServiceWatcher[] = [];
+  if (options.source === 'poll') {
+    sources = [pollServices(names, query, change => detector.observe(change), { onError, ...options.poll })];
+  } else if (!options.query && detectInitSystem() === 'systemd') {
+    if (!tryLoadLibsystemd()) throw new Error("watchStuckTransitions requires libsystemd on systemd; pass source: 'poll'");
+    sources = [watchUnitSignals(names, requery, onError)];
+  } else {
+    watchHostEvents(names, query, change => detector.observe(change), requery, options, onError).then(watchers => {
+      if (closed) watchers.forEach(w => w.close());
+      else sources = watchers;
+    });
+  }
+
+  return {
+    close() {
+      closed = true;
+      for (const source of sources) source.close();
+      for (const timer of timers.values()) clearTimeout(timer);
+      timers.clear();
+      detector.close();
+    }
+  };
+}
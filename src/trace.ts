@@ -0,0 +1,207 @@
+'use strict';
+
+/**
+ * Record and replay of backend interactions.
+ *
+ * The Linux backends route their I/O — D-Bus unit queries, `systemctl`
+ * output, filesystem probes and init system detection — through
+ * `traceSync`/`traceAsync`. Normally these just run the live operation.
+ *
+ * - While **recording**, every operation is run live and written to an NDJSON
+ *   trace file with its arguments, result (or error) and duration.
+ * - While **replaying**, operations are answered from a trace instead: each
+ *   `(op, args)` pair returns its recorded results in order (the last one
+ *   repeats once they are used up) after the recorded duration, multiplied by
+ *   `timeScale`. Synchronous operations block, as the live ones do, so a slow
+ *   PID 1 stalls the event loop exactly as it did in production.
+ *
+ * Trace file: a header line `{"trace":"service_api","version":1,"start":…}`
+ * followed by one event per line:
+ * `{"t":<ms since start>,"op":"…","args":[…],"ms":<duration>,"result":…}`
+ * (or `"error":"<message>"`).
+ */
+
+import fs from 'fs';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+interface TraceEvent {
+  t: number;
+  op: string;
+  args: unknown[];
+  ms: number;
+  result?: unknown;
+  error?: string;
+}
+
+export interface ReplayOptions {
+  /**
+   * Multiplier applied to recorded durations: `1` replays in real time, `0`
+   * answers immediately, `10` exaggerates latency tenfold. Default 1.
+   */
+  timeScale?: number;
+}
+
+/** Handle of an active recording or replay. */
+export interface TraceSession {
+  /** Ends the session (flushing the trace file when recording). */
+  stop(): Promise<void>;
+}
+
+interface Recorder {
+  kind: 'record';
+  start: number;
+  out: fs.WriteStream;
+}
+
+interface Replayer {
+  kind: 'replay';
+  timeScale: number;
+  events: Map<string, TraceEvent[]>;
+}
+
+let active: Recorder | Replayer | null = null;
+
+const TRACE_VERSION = 1;
+
+// ─── Interception ─────────────────────────────────────────────────────────────
+
+/** `true` while a recording or replay is active. */
+export function tracing(): boolean {
+  return active !== null;
+}
+
+const key = (op: string, args: readonly unknown[]) => `${op}\0${JSON.stringify(args)}`;
+
+function nextEvent(replay: Replayer, op: string, args: readonly unknown[]): TraceEvent {
+  const queue = replay.events.get(key(op, args));
+  if (!queue || queue.length === 0) {
+    throw new Error(`replay: no recorded ${op} for ${JSON.stringify(args)}`);
+  }
+  return queue.length > 1 ? queue.shift()! : queue[0];
+}
+
+function settle<T>(ev: TraceEvent): T {
+  if (ev.error !== undefined) throw new Error(ev.error);
+  return ev.result as T;
+}
+
+function record(rec: Recorder, op: string, args: readonly unknown[], started: number, outcome: { result?: unknown; error?: string }): void {
+  const ev: TraceEvent = {
+    t:    Math.round((started - rec.start) * 1000) / 1000,
+    op,
+    args: [...args],
+    ms:   Math.round((performance.now() - started) * 1000) / 1000,
+    ...outcome
+  };
+  rec.out.write(JSON.stringify(ev) + '\n');
+}
+
+const sleepCell = new Int32Array(new SharedArrayBuffer(4));
+
+/** Runs a synchronous backend operation through the active session, if any. */
+export function traceSync<T>(op: string, args: readonly unknown[], live: () => T): T {
+  const session = active;
+  if (!session) return live();
+
+  if (session.kind === 'replay') {
+    const ev = nextEvent(session, op, args);
+    const delay = ev.ms * session.timeScale;
+    if (delay > 0) Atomics.wait(sleepCell, 0, 0, delay);
+    return settle<T>(ev);
+  }
+
+  const started = performance.now();
+  try {
+    const result = live();
+    record(session, op, args, started, { result });
+    return result;
+  } catch (err) {
+    record(session, op, args, started, { error: (err as Error).message });
+    throw err;
+  }
+}
+
+/** Runs an asynchronous backend operation through the active session, if any. */
+export async function traceAsync<T>(op: string, args: readonly unknown[], live: () => Promise<T>): Promise<T> {
+  const session = active;
+  if (!session) return live();
+
+  if (session.kind === 'replay') {
+    const ev = nextEvent(session, op, args);
+    const delay = ev.ms * session.timeScale;
+    if (delay > 0) await new Promise(resolve => setTimeout(resolve, delay));
+    return settle<T>(ev);
+  }
+
+  const started = performance.now();
+  try {
+    const result = await live();
+    record(session, op, args, started, { result });
+    return result;
+  } catch (err) {
+    record(session, op, args, started, { error: (err as Error).message });
+    throw err;
+  }
+}
+
+// ─── Sessions ─────────────────────────────────────────────────────────────────
+
+function assertIdle(): void {
+  if (active) throw new Error(`a trace ${active.kind} is already active`);
+}
+
+/**
+ * Starts recording backend interactions to `file` (overwritten).
+ * @throws If a recording or replay is already active.
+ */
+export function recordTrace(file: string): TraceSession {
+  assertIdle();
+  const out = fs.createWriteStream(file);
+  out.write(JSON.stringify({ trace: 'service_api', version: TRACE_VERSION, start: Date.now() }) + '\n');
+  const session: Recorder = { kind: 'record', start: performance.now(), out };
+  active = session;
+  return {
+    stop() {
+      if (active === session) active = null;
+      return new Promise((resolve, reject) => {
+        out.once('error', reject);
+        out.end(() => resolve());
+      });
+    }
+  };
+}
+
+/**
+ * Loads `file` and answers backend operations from it until stopped.
+ * @throws If the file is not a trace, or a recording or replay is already active.
+ */
+export function replayTrace(file: string, options: ReplayOptions = {}): TraceSession {
+  assertIdle();
+  const timeScale = Math.max(0, options.timeScale ?? 1);
+  const lines = fs.readFileSync(file, 'utf8').split('\n').filter(line => line.trim() !== '');
+  const header = lines.length > 0 ? JSON.parse(lines[0]) : null;
+  if (!header || header.trace !== 'service_api') {
+    throw new Error(`${file} is not a service_api trace`);
+  }
+  if (header.version !== TRACE_VERSION) {
+    throw new Error(`unsupported trace version ${header.version}`);
+  }
+
+  const events = new Map<string, TraceEvent[]>();
+  for (const line of lines.slice(1)) {
+    const ev = JSON.parse(line) as TraceEvent;
+    const k = key(ev.op, ev.args);
+    let queue = events.get(k);
+    if (!queue) events.set(k, queue = []);
+    queue.push(ev);
+  }
+
+  const session: Replayer = { kind: 'replay', timeScale, events };
+  active = session;
+  return {
+    async stop() {
+      if (active === session) active = null;
+    }
+  };
+}
@@ -0,0 +1,327 @@
+'use strict';
+
+/**
+ * Transient units: commands run as systemd services without a unit file,
+ * as `systemd-run` does, but over a D-Bus connection kept open between runs
+ * instead of a fork, an exec and a bus connect per command.
+ *
+ * `Manager.StartTransientUnit` is called on the library's shared connection
+ * and queues a start job; its completion is reported by the manager's
+ * `JobRemoved` signal. Signals are received on a second connection,
+ * subscribed once and waited on from a threadpool thread, so any number of
+ * runs can be in flight at a time. Both connections are closed after a
+ * second without runs.
+ */
+
+import fs from 'fs';
+import path from 'path';
+import crypto from 'crypto';
+import {
+  tryLoadLibsystemd, openSystemBus, closeBus, sharedSystemBus, dropSharedBus, callMethod, freeMessage, addMatch, processBus, waitBus, isSignal,
+  BusPtr, BusCallError, BusMessageReader, SYSTEMD_DEST, SYSTEMD_PATH, MANAGER_IFACE
+} from './sdbus';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** How the job's start ended, as systemd's `JobRemoved` reports it. */
+export type JobResult = 'done' | 'canceled' | 'timeout' | 'failed' | 'dependency' | 'skipped';
+
+export interface TransientUnitOptions {
+  /** Unit name; `.service` is appended if it has no suffix. Default `run-r<random>.service`. */
+  name?: string;
+  /** argv; `command[0]` is looked up in `PATH` unless it contains a `/`. */
+  command: readonly string[];
+  /**
+   * Unit properties by D-Bus name (`Slice`, `MemoryMax`, `Environment`, …).
+   * Properties listed in `TRANSIENT_PROPERTY_TYPES` take plain values;
+   * others a `[signature, value]` pair. `Environment` also takes an object.
+   */
+  properties?: Record<string, unknown>;
+  /** Job mode. Default `'fail'`. */
+  mode?: 'replace' | 'fail' | 'isolate' | 'ignore-dependencies' | 'ignore-requirements';
+  /** Wait for the start job to finish. Default `true`. */
+  wait?: boolean;
+  /** Give up waiting after this many ms (the unit keeps running). Default: no limit. */
+  timeout?: number;
+}
+
+export interface TransientUnit {
+  unit: string;
+  /** Object path of the start job. */
+  job: string;
+  /** `null` when not waited for. */
+  result: JobResult | null;
+}
+
+/** D-Bus signatures of the properties that take plain values. */
+export const TRANSIENT_PROPERTY_TYPES: Readonly<Record<string, string>> = {
+  Description:        's',
+  Slice:              's',
+  Type:               's',
+  User:               's',
+  Group:              's',
+  WorkingDirectory:   's',
+  Environment:        'as',
+  RemainAfterExit:    'b',
+  CollectMode:        's',
+  KillMode:           's',
+  KillSignal:         'i',
+  Nice:               'i',
+  StandardOutput:     's',
+  StandardError:      's',
+  MemoryMax:          't',
+  MemoryHigh:         't',
+  MemoryLow:          't',
+  MemorySwapMax:      't',
+  TasksMax:           't',
+  CPUWeight:          't',
+  IOWeight:           't',
+  CPUQuotaPerSecUSec: 't',
+  RuntimeMaxUSec:     't',
+  TimeoutStopUSec:    't'
+};
+
+const UINT64_MAX = 2n ** 64n - 1n;
+
+/** How long the connections stay open without runs, in ms. */
+const IDLE_MS = 1000;
+
+/** JobRemoved signals kept for jobs whose start call has not returned yet. */
+const EARLY_RESULTS_MAX = 256;
+
+// ─── Properties ───────────────────────────────────────────────────────────────
+
+const resolvedCommands = new Map<string, string>();
+
+/** Absolute path of `command`, searched in `PATH` like `systemd-run` does. */
+export function resolveCommand(command: string, searchPath = process.env.PATH ?? ''): string {
+  if (command.includes('/')) return path.resolve(command);
+  const key = `${searchPath}\0${command}`;
+  const cached = resolvedCommands.get(key);
+  if (cached) return cached;
+  for (const dir of searchPath.split(':')) {
+    if (!dir) continue;
+    const candidate = path.join(dir, command);
+    try {
+      fs.accessSync(candidate, fs.constants.X_OK);
+      resolvedCommands.set(key, candidate);
+      return candidate;
+    } catch {
+      // next directory
+    }
+  }
+  throw new Error(`command not found in PATH: ${command}`);
+}
+
+/**
+ * The `a(sv)` property array for a transient service running `argv`:
+ * `[name, [signature, value]]` entries, `ExecStart` last.
+ */
+export function transientProperties(
+  argv: readonly string[], properties: Record<string, unknown> = {}
+): Array<[string, [string, unknown]]> {
+  if (!Array.isArray(argv) || argv.length === 0 || !argv.every(a => typeof a === 'string')) {
+    throw new TypeError('command must be a non-empty array of strings');
+  }
+  const list: Array<[string, [string, unknown]]> = [];
+  let described = false;
+  for (const [name, raw] of Object.entries(properties)) {
+    if (raw === undefined) continue;
+    if (name === 'ExecStart') throw new TypeError('ExecStart is set from command');
+    described ||= name === 'Description';
+    const signature = TRANSIENT_PROPERTY_TYPES[name];
+    if (!signature) {
+      if (!Array.isArray(raw) || raw.length !== 2 || typeof raw[0] !== 'string') {
+        throw new TypeError(`property ${name} needs a [signature, value] pair`);
+      }
+      list.push([name, [raw[0], raw[1]]]);
+      continue;
+    }
+    let value = raw;
+    if (name === 'Environment' && !Array.isArray(raw)) {
+      value = Object.entries(raw as Record<string, unknown>).map(([k, v]) => `${k}=${v}`);
+    } else if (signature === 't' && raw === 'infinity') {
+      value = UINT64_MAX;
+    }
+    list.push([name, [signature, value]]);
+  }
+  if (!described) list.push(['Description', ['s', argv.join(' ')]]);
+  // a(sbas): executable, ignore failure, argv (argv[0] included)
+  list.push(['ExecStart', ['a(sbas)', [[argv[0], false, [...argv]]]]]);
+  return list;
+}
+
+function transientUnitName(name: string | undefined): string {
+  if (name === undefined) return `run-r${crypto.randomBytes(8).toString('hex')}.service`;
+  if (typeof name !== 'string' || !name) throw new TypeError('name must be a non-empty string');
+  return name.includes('.') ? name : `${name}.service`;
+}
+
+// ─── Connections ──────────────────────────────────────────────────────────────
+
+interface Waiter {
+  resolve: (result: JobResult) => void;
+  reject: (err: Error) => void;
+  timer: NodeJS.Timeout | null;
+}
+
+/**
+ * The `JobRemoved` connection shared by every run. It is only ever used by
+ * one thread at a time.
+ */
+class TransientRunner {
+  private signals: BusPtr | null = null;
+  private readonly waiters = new Map<string, Waiter>();
+  /** Results of jobs removed before their start call returned, by job path. */
+  private readonly early = new Map<string, JobResult>();
+  private looping = false;
+  private lastUse = 0;
+  private idleTimer: NodeJS.Timeout | null = null;
+
+  async run(options: TransientUnitOptions): Promise<TransientUnit> {
+    if (!options || typeof options !== 'object') throw new TypeError('options must be an object');
+    const unit = transientUnitName(options.name);
+    const command = options.command;
+    if (!Array.isArray(command) || command.length === 0) throw new TypeError('command must be a non-empty array of strings');
+    const argv = [resolveCommand(String(command[0])), ...command.slice(1)];
+    const properties = transientProperties(argv, options.properties);
+    const wait = options.wait ?? true;
+    if (!tryLoadLibsystemd()) throw new Error('runTransient requires libsystemd');
+
+    this.lastUse = Date.now();
+    if (wait) this.subscribe();
+    const job = this.start(unit, options.mode ?? 'fail', properties);
+    if (!wait) return { unit, job, result: null };
+
+    const result = await new Promise<JobResult>((resolve, reject) => {
+      const early = this.early.get(job);
+      if (early) {
+        this.early.delete(job);
+        resolve(early);
+        return;
+      }
+      const timeout = options.timeout;
+      const timer = timeout === undefined ? null : setTimeout(() => {
+        this.waiters.delete(job);
+        reject(new Error(`timed out waiting for ${unit} to start (job ${job})`));
+      }, Math.max(0, timeout));
+      this.waiters.set(job, { resolve, reject, timer });
+      if (!this.looping) void this.loop();
+    });
+    return { unit, job, result };
+  }
+
+  private start(unit: string, mode: string, properties: Array<[string, [string, unknown]]>): string {
+    let reply: BusPtr;
+    try {
+      reply = callMethod(sharedSystemBus(), SYSTEMD_PATH, MANAGER_IFACE, 'StartTransientUnit', w => w
+        .string(unit)
+        .string(mode)
+        .append('a(sv)', properties)
+        .append('a(sa(sv))', []));
+    } catch (e) {
+      // A D-Bus error leaves the connection usable; anything else may not.
+      if (!(e instanceof BusCallError)) dropSharedBus();
+      throw e;
+    }
+    try {
+      return new BusMessageReader(reply).string('o');
+    } finally {
+      freeMessage(reply);
+    }
+  }
+
+  /** Opens the signal connection, before the first start call it must not miss. */
+  private subscribe(): void {
+    if (this.signals) return;
+    const bus = openSystemBus();
+    try {
+      addMatch(bus, `type='signal',sender='${SYSTEMD_DEST}',path='${SYSTEMD_PATH}',` +
+        `interface='${MANAGER_IFACE}',member='JobRemoved'`);
+      // Without a subscriber the manager may not emit job signals at all.
+      freeMessage(callMethod(bus, SYSTEMD_PATH, MANAGER_IFACE, 'Subscribe'));
+    } catch (e) {
+      closeBus(bus);
+      throw e;
+    }
+    this.signals = bus;
+    this.scheduleIdle();
+  }
+
+  private async loop(): Promise<void> {
+    this.looping = true;
+    try {
+      while (this.signals && this.waiters.size > 0) {
+        processBus(this.signals, m => this.dispatch(m));
+        if (this.waiters.size === 0) break;
+        // Bounded waits, so timeouts and closing are noticed promptly.
+        await waitBus(this.signals, 250);
+      }
+    } catch (e) {
+      for (const waiter of this.waiters.values()) {
+        if (waiter.timer) clearTimeout(waiter.timer);
+        waiter.reject(e as Error);
+      }
+      this.waiters.clear();
+      this.dropSignals();
+    } finally {
+      this.looping = false;
+      this.lastUse = Date.now();
+    }
+  }
+
+  private dispatch(m: BusPtr): void {
+    if (!isSignal(m, MANAGER_IFACE, 'JobRemoved')) return;
+    // JobRemoved(u id, o job, s unit, s result)
+    const reader = new BusMessageReader(m);
+    reader.uint32();
+    const job = reader.string('o');
+    reader.string();
+    const result = reader.string() as JobResult;
+    const waiter = this.waiters.get(job);
+    if (waiter) {
+      this.waiters.delete(job);
+      if (waiter.timer) clearTimeout(waiter.timer);
+      waiter.resolve(result);
+      return;
+    }
+    // Possibly one of ours whose start call has not returned yet; most are
+    // other clients' jobs, so only the latest few are kept.
+    this.early.set(job, result);
+    if (this.early.size > EARLY_RESULTS_MAX) this.early.delete(this.early.keys().next().value!);
+  }
+
+  private scheduleIdle(): void {
+    if (this.idleTimer) return;
+    this.idleTimer = setTimeout(() => {
+      this.idleTimer = null;
+      if (this.looping || this.waiters.size > 0 || Date.now() - this.lastUse < IDLE_MS) {
+        this.scheduleIdle();
+        return;
+      }
+      this.dropSignals();
+    }, IDLE_MS);
+    this.idleTimer.unref();
+  }
+
+  private dropSignals(): void {
+    if (this.signals) closeBus(this.signals);
+    this.signals = null;
+    this.early.clear();
+  }
+}
+
+const runner = new TransientRunner();
+
+/**
+ * Starts `command` as a transient service and, unless `wait` is `false`,
+ * resolves once its start job has finished — for `Type=oneshot` units, when
+ * the command has exited. A `result` other than `'done'` means the start
+ * failed; it is not thrown.
+ *
+ * @throws {BusCallError} If systemd refuses the unit (name in use, bad property).
+ * @throws If libsystemd is unavailable or the system bus cannot be reached.
+ */
+export function runTransient(options: TransientUnitOptions): Promise<TransientUnit> {
+  return runner.run(options);
+}
@@ -0,0 +1,181 @@
+'use strict';
+
+/**
+ * Transition-duration analytics: per-service histograms of
+ *
+ * - **start** latency: `START_PENDING → RUNNING`;
+ * - **stop** latency: `STOP_PENDING → STOPPED`;
+ * - **restart-to-ready**: leaving `RUNNING` → `RUNNING` again, when that
+ *   happens within `restartWindow`.
+ *
+ * When a status carries systemd's monotonic transition timestamps
+ * (`ServiceStatus.timestamps`), durations are taken from them, with PID 1's
+ * µs precision and even when the intermediate states were never observed.
+ * Otherwise they are measured between the change events themselves.
+ *
+ * The library's watchers feed the shared `transitions` tracker; any other
+ * source of {@link ServiceChange}s can call `observe()` directly.
+ */
+
+import { ServiceChange, UnitTimestamps } from './types';
+import { Histogram, HistogramSnapshot } from './histogram';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** Duration histograms of one service (or of all), in milliseconds. */
+export interface TransitionStats {
+  start: HistogramSnapshot;
+  stop: HistogramSnapshot;
+  restart: HistogramSnapshot;
+}
+
+/** As returned by `getTransitionStats()`. */
+export interface TransitionStatsReport {
+  /** All services together. */
+  all: TransitionStats;
+  /** Per service name. */
+  services: Record<string, TransitionStats>;
+}
+
+export interface TransitionTrackerOptions {
+  /**
+   * Longest gap (ms) between leaving `RUNNING` and reaching it again that
+   * still counts as a restart. Default 60000.
+   */
+  restartWindow?: number;
+}
+
+interface Histograms {
+  start: Histogram;
+  stop: Histogram;
+  restart: Histogram;
+}
+
+interface Timeline extends Histograms {
+  startPendingAt: number | null;
+  stopPendingAt: number | null;
+  leftRunningAt: number | null;
+  /** systemd timestamps already accounted for. */
+  seenActiveEnter: number;
+  seenInactiveEnter: number;
+}
+
+const newHistograms = (): Histograms => ({ start: new Histogram(), stop: new Histogram(), restart: new Histogram() });
+
+/** Histograms record µs; reports are in ms. */
+function toMs(h: Histogram): HistogramSnapshot {
+  const s = h.snapshot();
+  return {
+    count: s.count,
+    min:   s.min / 1000,
+    max:   s.max / 1000,
+    mean:  s.mean / 1000,
+    p50:   s.p50 / 1000,
+    p90:   s.p90 / 1000,
+    p99:   s.p99 / 1000,
+    p999:  s.p999 / 1000
+  };
+}
+
+function report(h: Histograms): TransitionStats {
+  return { start: toMs(h.start), stop: toMs(h.stop), restart: toMs(h.restart) };
+}
+
+// ─── Tracker ──────────────────────────────────────────────────────────────────
+
+export class TransitionTracker {
+  private readonly restartWindowUs: number;
+  private readonly timelines = new Map<string, Timeline>();
+  private all = newHistograms();
+
+  constructor(options: TransitionTrackerOptions = {}) {
+    this.restartWindowUs = (options.restartWindow ?? 60_000) * 1000;
+  }
+
+  /**
+   * Accounts for one observation of a service. Observations that repeat
+   * already-counted transitions (unchanged polls, duplicate events) are
+   * ignored.
+   */
+  observe(change: ServiceChange): void {
+    let tl = this.timelines.get(change.name);
+    if (!tl) {
+      tl = {
+        ...newHistograms(),
+        startPendingAt: null, stopPendingAt: null, leftRunningAt: null,
+        seenActiveEnter: 0, seenInactiveEnter: 0
+      };
+      this.timelines.set(change.name, tl);
+    }
+    if (change.current.timestamps) this.fromTimestamps(tl, change.current.timestamps);
+    else this.fromEvents(tl, change);
+  }
+
+  /** Histograms per service and for all services, in ms. */
+  stats(): TransitionStatsReport {
+    const services: Record<string, TransitionStats> = {};
+    for (const [name, tl] of this.timelines) services[name] = report(tl);
+    return { all: report(this.all), services };
+  }
+
+  reset(): void {
+    this.timelines.clear();
+    this.all = newHistograms();
+  }
+
+  private record(tl: Timeline, kind: keyof Histograms, us: number): void {
+    tl[kind].record(us);
+    this.all[kind].record(us);
+  }
+
+  private fromTimestamps(tl: Timeline, ts: UnitTimestamps): void {
+    if (ts.activeEnter > tl.seenActiveEnter) {
+      tl.seenActiveEnter = ts.activeEnter;
+      if (ts.inactiveExit > 0 && ts.inactiveExit <= ts.activeEnter) {
+        this.record(tl, 'start', ts.activeEnter - ts.inactiveExit);
+      }
+      // A restart left `active` before this activation began.
+      if (ts.activeExit > 0 && ts.activeExit <= ts.inactiveExit &&
+          ts.activeEnter - ts.activeExit <= this.restartWindowUs) {
+        this.record(tl, 'restart', ts.activeEnter - ts.activeExit);
+      }
+    }
+    if (ts.inactiveEnter > tl.seenInactiveEnter) {
+      tl.seenInactiveEnter = ts.inactiveEnter;
+      if (ts.activeExit > 0 && ts.activeExit <= ts.inactiveEnter) {
+        this.record(tl, 'stop', ts.inactiveEnter - ts.activeExit);
+      }
+    }
+  }
+
+  private fromEvents(tl: Timeline, change: ServiceChange): void {
+    const prev = change.previous ? change.previous.state : null;
+    const cur = change.current.state;
+    const now = change.timestamp;
+    if (prev === cur) return;
+
+    if (prev === 'RUNNING' && tl.leftRunningAt === null) tl.leftRunningAt = now;
+    switch (cur) {
+      case 'START_PENDING':
+        if (tl.startPendingAt === null) tl.startPendingAt = now;
+        break;
+      case 'RUNNING':
+        if (tl.startPendingAt !== null) this.record(tl, 'start', (now - tl.startPendingAt) * 1000);
+        if (tl.leftRunningAt !== null && (now - tl.leftRunningAt) * 1000 <= this.restartWindowUs) {
+          this.record(tl, 'restart', (now - tl.leftRunningAt) * 1000);
+        }
+        tl.startPendingAt = tl.stopPendingAt = tl.leftRunningAt = null;
+        break;
+      case 'STOP_PENDING':
+        if (tl.stopPendingAt === null) tl.stopPendingAt = now;
+        break;
+      case 'STOPPED':
+        if (tl.stopPendingAt !== null) this.record(tl, 'stop', (now - tl.stopPendingAt) * 1000);
+        tl.stopPendingAt = tl.startPendingAt = null;
+        break;
+    }
+  }
+}
+
+/** The tracker fed by the library's watchers. */
+export const transitions = new TransitionTracker();
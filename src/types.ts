@@ -16,6 +16,82 @@ export interface ServiceStatus {
   pid: number;
   /** The raw state value from the OS. */
   rawCode: string | number;
+  /**
+   * systemd unit type (`service`, `socket`, `timer`, `mount`, `path`, …).
+   * Only set by the systemd backend.
+   */
+  type?: string;
+  /** Timer details, for `.timer` units. */
+  timer?: TimerDetails;
+  /** Socket details, for `.socket` units. */
+  socket?: SocketDetails;
+  /** Mount details, for `.mount` units. */
+  mount?: MountDetails;
+  /** Path details, for `.path` units. */
+  path?: PathDetails;
+  /** Last transition times reported by systemd. Only set by the systemd backend. */
+  timestamps?: UnitTimestamps;
+}
+
+/**
+ * Transition times of a systemd unit, in µs of CLOCK_MONOTONIC (`0` when the
+ * transition has not happened since boot).
+ */
+export interface UnitTimestamps {
+  /** Left `inactive` (start requested). */
+  inactiveExit: number;
+  /** Entered `active` (ready). */
+  activeEnter: number;
+  /** Left `active` (stop or restart requested). */
+  activeExit: number;
+  /** Entered `inactive` (stopped). */
+  inactiveEnter: number;
+}
+
+/** `org.freedesktop.systemd1.Timer` properties. */
+export interface TimerDetails {
+  /** Next wall-clock elapse (ms since the epoch), `null` when not scheduled. */
+  nextElapse: number | null;
+  /** Last time the timer triggered (ms since the epoch), `null` if never. */
+  lastTrigger: number | null;
+  /** The unit the timer activates. */
+  unit: string;
+}
+
+/** `org.freedesktop.systemd1.Socket` properties. */
+export interface SocketDetails {
+  /** Connections currently open. */
+  connections: number;
+  /** Connections accepted since the socket was started. */
+  accepted: number;
+}
+
+/** `org.freedesktop.systemd1.Mount` properties. */
+export interface MountDetails {
+  /** Mount point. */
+  where: string;
+  /** Mounted device or source. */
+  what: string;
+  /** Filesystem type. */
+  fsType: string;
+}
+
+/** `org.freedesktop.systemd1.Path` properties. */
+export interface PathDetails {
+  /** The unit the path unit activates. */
+  unit: string;
+}
+
+/**
+ * A failed entry of a batch status query.
+ */
+export interface ServiceStatusError {
+  /** The service name as provided. */
+  name: string;
+  /** Always `false`. */
+  exists: false;
+  /** Why the status could not be obtained. */
+  error: string;
 }
 
 /**
@@ -25,3 +101,47 @@ export interface ServiceModule {
   serviceExists(serviceName: string): Promise<boolean>;
   getServiceStatus(serviceName: string): Promise<ServiceStatus>;
 }
+
+/**
+ * Options for `iterateServices` (Linux).
+ */
+export interface IterateServicesOptions {
+  /**
+   * Shell-style globs (`*`, `?`) on the service name, e.g. `"php*"`.
+   * On systemd a pattern without a dot is scoped to the requested `types`.
+   * Defaults to every service.
+   */
+  patterns?: string[];
+  /** Only yield services in one of these normalized states, e.g. `['RUNNING']`. */
+  states?: string[];
+  /**
+   * systemd unit types to list, e.g. `['timer', 'socket']`. Defaults to
+   * `['service']`. On OpenRC/SysV every entry is a service.
+   */
+  types?: string[];
+}
+
+/**
+ * A service state transition, as emitted by the watchers.
+ */
+export interface ServiceChange {
+  /** The service name. */
+  name: string;
+  /** Status before the change (`null` when the service was first seen). */
+  previous: ServiceStatus | null;
+  /** Status after the change, as `getServiceStatus` reports it. */
+  current: ServiceStatus;
+  /** When the change was detected (ms since the epoch). */
+  timestamp: number;
+}
+
+/** Callback shared by every watcher. */
+export type ServiceChangeListener = (change: ServiceChange) => void;
+
+/**
+ * Handle returned by the watchers.
+ */
+export interface ServiceWatcher {
+  /** Stops watching and releases the underlying OS resources. */
+  close(): void;
+}
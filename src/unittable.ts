@@ -0,0 +1,281 @@
+'use strict';
+
+/**
+ * In-memory table of units with secondary indexes, for predicate queries
+ * such as "failed units in `app.slice`", "enabled but stopped" or "restarted
+ * more than 3 times".
+ *
+ * Each indexed field (normalized state, raw active state, slice,
+ * UnitFileState, type) maps a value to the set of unit names holding it;
+ * restart counts are indexed by count. Indexes are updated incrementally on
+ * every row change — only the entries of the fields that changed move — so a
+ * query starts from the smallest matching index set and never scans the
+ * table, unless it has no indexed constraint at all.
+ *
+ * The table is loaded in one pass: a listing, then on systemd the extra
+ * properties of every unit with `getUnitProperties` — one `GetAll` per unit,
+ * pipelined so that they cost about one round trip, but read synchronously:
+ * the event loop is blocked until the last reply (one `systemctl show`
+ * process without libsystemd). It is then kept current by the changes the
+ * library's watchers observe; the properties a change can affect (restart
+ * count, unit file state) are re-read in batches for the changed units only.
+ */
+
+import { ServiceStatus, ServiceChange } from './types';
+
+// ─── Types ────────────────────────────────────────────────────────────────────
+
+/** One row of the table. */
+export interface UnitRecord {
+  /** Name as listed (`nginx`, `backup.timer`). */
+  readonly name: string;
+  /** Unit type (`service`, `timer`, …). */
+  readonly type: string;
+  /** Normalized state, as `getServiceStatus` reports it. */
+  readonly state: string;
+  /** Raw backend state (systemd `ActiveState`: `active`, `failed`, …). */
+  readonly activeState: string;
+  /** Slice the unit runs in (`app.slice`), `null` if unknown. */
+  readonly slice: string | null;
+  /** `UnitFileState` (`enabled`, `disabled`, `static`, …), `null` if unknown. */
+  readonly unitFileState: string | null;
+  /** `NRestarts`: automatic restarts since the unit was last started manually. */
+  readonly restarts: number;
+  readonly pid: number;
+}
+
+type OneOrMany = string | readonly string[];
+
+/** Every given constraint must hold; list values match any of their entries. */
+export interface UnitQuery {
+  state?: OneOrMany;
+  activeState?: OneOrMany;
+  slice?: OneOrMany;
+  unitFileState?: OneOrMany;
+  type?: OneOrMany;
+  /** `restarts >= minRestarts`. */
+  minRestarts?: number;
+  /** Residual predicate, applied to the rows the indexed constraints select. */
+  where?: (unit: UnitRecord) => boolean;
+}
+
+export interface LoadUnitsOptions {
+  /** systemd unit types to load. Default `['service']`. */
+  types?: string[];
+}
+
+type IndexedField = 'state' | 'activeState' | 'slice' | 'unitFileState' | 'type';
+
+const INDEXED_FIELDS: readonly IndexedField[] = ['state', 'activeState', 'slice', 'unitFileState', 'type'];
+
+/** systemd properties not carried by a listing or a status. */
+const EXTRA_PROPERTIES = ['Slice', 'UnitFileState', 'NRestarts'];
+
+// ─── Table ────────────────────────────────────────────────────────────────────
+
+export class UnitTable {
+  private readonly rows = new Map<string, UnitRecord>();
+  private readonly indexes = new Map<IndexedField, Map<string | null, Set<string>>>(
+    INDEXED_FIELDS.map(field => [field, new Map()])
+  );
+  private readonly byRestarts = new Map<number, Set<string>>();
+  private loadedAt = 0;
+  /** Units whose extra properties are to be re-read. */
+  private readonly stale = new Set<string>();
+  private staleTimer: NodeJS.Timeout | null = null;
+
+  /** Number of rows. */
+  get size(): number {
+    return this.rows.size;
+  }
+
+  /** Time of the last `load()`, ms since the epoch; `0` before the first. */
+  get loaded(): number {
+    return this.loadedAt;
+  }
+
+  get(name: string): UnitRecord | undefined {
+    return this.rows.get(name);
+  }
+
+  /** Inserts or replaces a row, moving only the index entries that changed. */
+  upsert(record: UnitRecord): void {
+    const old = this.rows.get(record.name);
+    for (const field of INDEXED_FIELDS) {
+      if (old && old[field] === record[field]) continue;
+      const index = this.indexes.get(field)!;
+      if (old) removeFrom(index, old[field], record.name);
+      addTo(index, record[field], record.name);
+    }
+    if (!old || old.restarts !== record.restarts) {
+      if (old) removeFrom(this.byRestarts, old.restarts, record.name);
+      addTo(this.byRestarts, record.restarts, record.name);
+    }
+    this.rows.set(record.name, record);
+  }
+
+  delete(name: string): boolean {
+    const old = this.rows.get(name);
+    if (!old) return false;
+    for (const field of INDEXED_FIELDS) removeFrom(this.indexes.get(field)!, old[field], name);
+    removeFrom(this.byRestarts, old.restarts, name);
+    this.rows.delete(name);
+    return true;
+  }
+
+  /** Rows matching every constraint of `q`, by name. */
+  query(q: UnitQuery = {}): UnitRecord[] {
+    // One candidate group per indexed constraint: the union of its sets.
+    const groups: Array<Set<string>[]> = [];
+    for (const field of INDEXED_FIELDS) {
+      const wanted = q[field];
+      if (wanted === undefined) continue;
+      const index = this.indexes.get(field)!;
+      groups.push(values(wanted).map(v => index.get(v)).filter((s): s is Set<string> => !!s));
+    }
+    if (q.minRestarts !== undefined) {
+      const sets: Set<string>[] = [];
+      for (const [count, names] of this.byRestarts) if (count >= q.minRestarts) sets.push(names);
+      groups.push(sets);
+    }
+
+    let candidates: Iterable<string>;
+    if (groups.length === 0) {
+      candidates = this.rows.keys();
+    } else {
+      const sizeOf = (g: Set<string>[]) => g.reduce((n, s) => n + s.size, 0);
+      const smallest = groups.reduce((a, b) => (sizeOf(b) < sizeOf(a) ? b : a));
+      candidates = smallest.flatMap(s => [...s]);
+    }
+
+    const result: UnitRecord[] = [];
+    for (const name of candidates) {
+      const row = this.rows.get(name)!;
+      if (matches(row, q)) result.push(row);
+    }
+    return result.sort((a, b) => (a.name < b.name ? -1 : a.name > b.name ? 1 : 0));
+  }
+
+  /**
+   * (Re)loads the table from the service manager: one listing, then one
+   * pipelined read of the extra properties on systemd. Units no longer
+   * listed are dropped.
+   */
+  async load(options: LoadUnitsOptions = {}): Promise<void> {
+    const linux: typeof import('./linux') = require('./linux');
+    const listed: ServiceStatus[] = [];
+    for await (const status of linux.iterateServices({ types: options.types })) listed.push(status);
+    let extras: Array<Record<string, unknown>> = [];
+    if (linux.detectInitSystem() === 'systemd') {
+      try {
+        extras = linux.getUnitProperties(listed.map(s => s.name), EXTRA_PROPERTIES);
+      } catch {
+        // Listed without the extra properties; they are filled in on change.
+      }
+    }
+
+    const seen = new Set<string>();
+    listed.forEach((status, i) => {
+      seen.add(status.name);
+      this.upsert(fromStatus(status, this.rows.get(status.name), extras[i]));
+    });
+    for (const name of [...this.rows.keys()]) if (!seen.has(name)) this.delete(name);
+    this.loadedAt = Date.now();
+  }
+
+  /**
+   * Applies a change observed by a watcher. Ignored until the table has been
+   * loaded; the unit's extra properties are re-read shortly after, batched
+   * with those of other changed units. Names are normalized as listings
+   * report them, so `nginx.service` updates the `nginx` row.
+   */
+  observe(change: ServiceChange): void {
+    if (!this.loadedAt || !change.current.exists) return;
+    const linux: typeof import('./linux') = require('./linux');
+    const name = linux.listedName(change.name);
+    const old = this.rows.get(name);
+    if (old && old.state === change.current.state && old.pid === change.current.pid) return;
+    this.upsert(fromStatus({ ...change.current, name }, old));
+    this.stale.add(name);
+    if (!this.staleTimer) this.staleTimer = setTimeout(() => this.refreshStale(), 100);
+  }
+
+  /** Empties the table. */
+  clear(): void {
+    for (const name of [...this.rows.keys()]) this.delete(name);
+    if (this.staleTimer) clearTimeout(this.staleTimer);
+    this.staleTimer = null;
+    this.stale.clear();
+    this.loadedAt = 0;
+  }
+
+  private refreshStale(): void {
+    this.staleTimer = null;
+    const names = [...this.stale].filter(name => this.rows.has(name));
+    this.stale.clear();
+    try {
+      const linux: typeof import('./linux') = require('./linux');
+      if (names.length === 0 || linux.detectInitSystem() !== 'systemd') return;
+      const extras = linux.getUnitProperties(names, EXTRA_PROPERTIES);
+      names.forEach((name, i) => {
+        const row = this.rows.get(name);
+        if (row) this.upsert(withExtras(row, extras[i]));
+      });
+    } catch {
+      // The rows keep their previous extras until the next change or load.
+    }
+  }
+}
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+function addTo<K>(index: Map<K, Set<string>>, key: K, name: string): void {
+  let set = index.get(key);
+  if (!set) index.set(key, set = new Set());
+  set.add(name);
+}
+
+function removeFrom<K>(index: Map<K, Set<string>>, key: K, name: string): void {
+  const set = index.get(key);
+  if (!set) return;
+  set.delete(name);
+  if (set.size === 0) index.delete(key);
+}
+
+const values = (v: OneOrMany): readonly string[] => (typeof v === 'string' ? [v] : v);
+
+function matches(row: UnitRecord, q: UnitQuery): boolean {
+  for (const field of INDEXED_FIELDS) {
+    const wanted = q[field];
+    if (wanted !== undefined && !values(wanted).includes(row[field] as string)) return false;
+  }
+  if (q.minRestarts !== undefined && row.restarts < q.minRestarts) return false;
+  return !q.where || q.where(row);
+}
+
+function fromStatus(status: ServiceStatus, old?: UnitRecord, extras?: Record<string, unknown>): UnitRecord {
+  const base: UnitRecord = {
+    name:          status.name,
+    type:          status.type ?? old?.type ?? 'service',
+    state:         status.state,
+    activeState:   status.rawCode,
+    slice:         old?.slice ?? null,
+    unitFileState: old?.unitFileState ?? null,
+    restarts:      old?.restarts ?? 0,
+    pid:           status.pid || (old && old.state === status.state ? old.pid : 0)
+  };
+  return extras ? withExtras(base, extras) : base;
+}
+
+function withExtras(row: UnitRecord, extras: Record<string, unknown>): UnitRecord {
+  const str = (key: string) => (extras[key] === undefined || extras[key] === '' ? null : String(extras[key]));
+  return {
+    ...row,
+    slice:         str('Slice') ?? row.slice,
+    unitFileState: str('UnitFileState') ?? row.unitFileState,
+    restarts:      extras['NRestarts'] === undefined ? row.restarts : Number(extras['NRestarts']) || 0
+  };
+}
+
+/** The table fed by the library's watchers. */
+export const unitTable = new UnitTable();
@@ -0,0 +1,102 @@
+'use strict';
+
+/**
+ * Tests for cross-container scanning (src/containers.ts).
+ * The live test creates PID and mount namespaces with `unshare` and needs
+ * root; it is skipped elsewhere.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { spawn, spawnSync } from 'child_process';
+import { parseNSpid, findContainers, scanContainers } from '../src/containers';
+import { rootSkipReason } from './live';
+
+function liveSkipReason(): string | false {
+  const reason = rootSkipReason();
+  if (reason) return reason;
+  if (!fs.existsSync('/etc/init.d')) return 'requires /etc/init.d';
+  const probe = spawnSync('unshare', ['--pid', '--fork', '--kill-child', '--mount', '--mount-proc', 'true']);
+  if (probe.error || probe.status !== 0) return 'unshare --pid --mount not permitted';
+  return false;
+}
+
+function readPPid(pid: number): number {
+  try {
+    return Number(/^PPid:\s*(\d+)/m.exec(fs.readFileSync(`/proc/${pid}/status`, 'utf8'))?.[1] ?? 0);
+  } catch {
+    return 0;
+  }
+}
+
+function readComm(pid: number): string {
+  try {
+    return fs.readFileSync(`/proc/${pid}/comm`, 'utf8').trim();
+  } catch {
+    return '';
+  }
+}
+
+// ─── parseNSpid ───────────────────────────────────────────────────────────────
+
+describe('containers — parseNSpid', () => {
+  it('reads the PID in each namespace, outermost first', () => {
+    const status = 'Name:\tsleep\nTgid:\t6164\nPid:\t6164\nNSpid:\t6164\t1\nNSpgid:\t6164\t1\n';
+    assert.deepEqual(parseNSpid(status), [6164, 1]);
+  });
+
+  it('returns an empty list without an NSpid line (kernel < 4.1)', () => {
+    assert.deepEqual(parseNSpid('Name:\tinit\nPid:\t1\n'), []);
+  });
+});
+
+// ─── Live (unshare) ───────────────────────────────────────────────────────────
+
+describe('containers — scanContainers (live, unshare)', () => {
+  const skip = liveSkipReason();
+
+  it('reports a container service with the host PID of its pidfile process', { skip }, async () => {
+    // The namespace gets its own /run and /etc/init.d: a SysV system with one
+    // service whose pidfile holds the in-namespace PID of a `sleep`.
+    const name = `svcmgr-test-${process.pid}`;
+    const initd = fs.mkdtempSync(path.join(os.tmpdir(), 'svcmgr-initd-'));
+    fs.writeFileSync(path.join(initd, name), '#!/bin/sh\n', { mode: 0o755 });
+    const script = [
+      'mount -t tmpfs tmpfs /run',
+      'mount --bind "$0" /etc/init.d',
+      'sleep 60 &',
+      `echo $! > /run/${name}.pid`,
+      'wait'
+    ].join('\n');
+    // --kill-child: when unshare is killed, so is the namespace's init, and
+    // with it every process of the namespace.
+    const child = spawn('unshare', ['--pid', '--fork', '--kill-child', '--mount', '--mount-proc', 'sh', '-c', script, initd],
+      { stdio: 'ignore' });
+    try {
+      let container;
+      let scan;
+      for (let attempt = 0; attempt < 50 && !scan; attempt++) {
+        await new Promise(resolve => setTimeout(resolve, 20));
+        container = (await findContainers()).find(c => readPPid(c.pid) === child.pid);
+        if (!container) continue;
+        scan = (await scanContainers({ patterns: [name] })).find(r =>
+          r.container.pid === container!.pid && r.services.some(s => s.state === 'RUNNING'));
+      }
+      assert.ok(container, 'container found');
+      assert.equal(container.root, `/proc/${container.pid}/root`);
+      assert.equal(container.init, 'sysv');
+      assert.ok(scan, 'container scanned');
+
+      const sleeper = fs.readFileSync(`/proc/${container.pid}/task/${container.pid}/children`, 'utf8')
+        .trim().split(/\s+/).map(Number).find(pid => readComm(pid) === 'sleep');
+      assert.ok(sleeper, 'sleep found');
+      assert.deepEqual(scan.services.map(s => ({ name: s.name, pid: s.pid })), [{ name, pid: sleeper }]);
+    } finally {
+      child.kill();
+      fs.rmSync(initd, { recursive: true, force: true });
+    }
+  });
+});
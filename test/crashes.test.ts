@@ -0,0 +1,81 @@
+'use strict';
+
+/**
+ * Tests for crash detection (src/crashes.ts). The watcher test uses a
+ * temporary directory in place of /var/lib/systemd/coredump.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { parseCoredumpFilename, crashFromJournal, watchCrashes, CrashEvent } from '../src/crashes';
+
+const skip = process.platform !== 'linux' ? 'Linux only' : false;
+const BOOT_ID = '0123456789abcdef0123456789abcdef';
+
+describe('crashes — parseCoredumpFilename', () => {
+  it('reads comm, uid, pid and time, with or without compression', () => {
+    const expected = { comm: 'nginx', uid: 33, pid: 4242, timestamp: 1700000000123 };
+    assert.deepEqual(parseCoredumpFilename(`core.nginx.33.${BOOT_ID}.4242.1700000000123456.zst`), expected);
+    assert.deepEqual(parseCoredumpFilename(`core.nginx.33.${BOOT_ID}.4242.1700000000123456`), expected);
+  });
+
+  it('unescapes comm', () => {
+    assert.equal(parseCoredumpFilename(`core.php\\x2dfpm\\x20w.0.${BOOT_ID}.7.1.xz`)?.comm, 'php-fpm w');
+  });
+
+  it('ignores temporary and unrelated files', () => {
+    assert.equal(parseCoredumpFilename(`.#core.nginx.33.${BOOT_ID}.4242.1700000000123456.zst1a2b`), null);
+    assert.equal(parseCoredumpFilename('README'), null);
+  });
+});
+
+describe('crashes — crashFromJournal', () => {
+  it('maps systemd-coredump fields', () => {
+    const crash = crashFromJournal({
+      COREDUMP_UNIT: 'nginx.service', COREDUMP_PID: '4242', COREDUMP_SIGNAL: '11',
+      COREDUMP_EXE: '/usr/sbin/nginx', COREDUMP_COMM: 'nginx', COREDUMP_TIMESTAMP: '1700000000123456'
+    });
+    assert.deepEqual(crash, {
+      unit: 'nginx.service', pid: 4242, signal: 11, signalName: 'SIGSEGV', exe: '/usr/sbin/nginx',
+      comm: 'nginx', timestamp: 1700000000123, coredump: null
+    });
+  });
+
+  it('falls back to the user unit and rejects entries without a PID', () => {
+    assert.equal(crashFromJournal({ COREDUMP_USER_UNIT: 'app.service', COREDUMP_PID: '9' })?.unit, 'app.service');
+    assert.equal(crashFromJournal({ COREDUMP_UNIT: 'x.service' }), null);
+  });
+});
+
+describe('crashes — watchCrashes (coredump directory)', () => {
+  it('reports a new core file once', { skip }, async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'coredump-'));
+    const crashes: CrashEvent[] = [];
+    const watcher = watchCrashes(c => crashes.push(c), { coredumpDir: dir, journal: false });
+    try {
+      // systemd-coredump writes a temporary file, then renames it into place
+      const tmp = path.join(dir, `.#core.sleep.0.${BOOT_ID}.31337.1700000000000000.zst`);
+      fs.writeFileSync(tmp, 'core');
+      fs.renameSync(tmp, path.join(dir, `core.sleep.0.${BOOT_ID}.31337.1700000000000000.zst`));
+      for (let i = 0; i < 50 && crashes.length === 0; i++) await new Promise(r => setTimeout(r, 20));
+      await new Promise(r => setTimeout(r, 50));
+
+      assert.equal(crashes.length, 1);
+      assert.equal(crashes[0].pid, 31337);
+      assert.equal(crashes[0].comm, 'sleep');
+      assert.equal(crashes[0].unit, null);
+      assert.equal(crashes[0].timestamp, 1700000000000);
+      assert.ok(crashes[0].coredump?.endsWith('.zst'));
+    } finally {
+      watcher.close();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('throws when neither source is available', () => {
+    assert.throws(() => watchCrashes(() => {}, { coredumpDir: '/nonexistent/coredump', journal: false }));
+  });
+});
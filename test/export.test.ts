@@ -0,0 +1,152 @@
+'use strict';
+
+/**
+ * Tests for the delta-encoded snapshot stream (src/export.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import net from 'net';
+import path from 'path';
+import { ServiceStatus } from '../src/types';
+import { SnapshotEncoder, SnapshotDecoder, SnapshotExporter, decodeSnapshots } from '../src/export';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+function status(name: string, state: string, pid = 0, rawCode: string | number = state.toLowerCase()): ServiceStatus {
+  return { name, exists: true, state, pid, rawCode };
+}
+
+function fleet(n: number): ServiceStatus[] {
+  return Array.from({ length: n }, (_, i) =>
+    status(`service-${i}`, i % 3 ? 'RUNNING' : 'STOPPED', i % 3 ? 10_000 + i : 0));
+}
+
+// ─── Encoder / decoder ────────────────────────────────────────────────────────
+
+describe('export — SnapshotEncoder / SnapshotDecoder', () => {
+  it('round-trips keyframes and deltas', () => {
+    const enc = new SnapshotEncoder({ keyframeInterval: 3 });
+    const dec = new SnapshotDecoder();
+    const t0 = 1_792_281_600_000;
+    const snapshots = [
+      [status('cron', 'RUNNING', 412), status('sshd', 'STOPPED'), status('Spooler', 'RUNNING', 0, 4)],
+      [status('cron', 'RUNNING', 412), status('sshd', 'RUNNING', 977), status('Spooler', 'RUNNING', 0, 4)],
+      [status('cron', 'RUNNING', 412), status('Spooler', 'STOPPED', 0, 1)],
+      [status('cron', 'STOPPED'), status('nginx', 'RUNNING', 88)]
+    ];
+    const frames = snapshots.flatMap((s, i) => dec.push(enc.encode(s, t0 + i * 1000)));
+
+    assert.deepEqual(frames.map(f => f.keyframe), [true, false, false, true]);
+    assert.deepEqual(frames.map(f => f.timestamp), [t0, t0 + 1000, t0 + 2000, t0 + 3000]);
+    frames.forEach((f, i) => assert.deepEqual(f.statuses, snapshots[i]));
+    assert.deepEqual(frames[1].changed, ['sshd']);
+    assert.deepEqual(frames[2].removed, ['sshd']);
+    assert.deepEqual(frames[2].changed, ['Spooler']);
+  });
+
+  it('decodes a stream split at arbitrary byte boundaries', () => {
+    const enc = new SnapshotEncoder();
+    const services = fleet(50);
+    const bytes = Buffer.concat([
+      enc.encode(services, 1000),
+      enc.encode(services.map((s, i) => (i === 7 ? status(s.name, 'STOPPED') : s)), 2000)
+    ]);
+    const dec = new SnapshotDecoder();
+    const frames = [];
+    for (let i = 0; i < bytes.length; i++) frames.push(...dec.push(bytes.subarray(i, i + 1)));
+    assert.equal(frames.length, 2);
+    assert.equal(frames[1].statuses[7].state, 'STOPPED');
+    assert.deepEqual(frames[1].changed, ['service-7']);
+  });
+
+  it('rejects streams without the header', () => {
+    assert.throws(() => new SnapshotDecoder().push(Buffer.from('[{"name":"cron"}]')), /not a service snapshot stream/);
+  });
+
+  it('is at least 50x smaller than periodic JSON snapshots', () => {
+    const enc = new SnapshotEncoder();
+    let services = fleet(300);
+    let binary = 0, json = 0;
+    for (let tick = 0; tick < 120; tick++) {
+      // a couple of transitions per interval
+      services = services.map((s, i) =>
+        (i === (tick * 7) % 300 ? status(s.name, s.state === 'RUNNING' ? 'STOPPED' : 'RUNNING', tick) : s));
+      binary += enc.encode(services, 1_792_281_600_000 + tick * 10_000).length;
+      json += Buffer.byteLength(JSON.stringify(services));
+    }
+    assert.ok(json / binary >= 50, `ratio ${(json / binary).toFixed(1)}`);
+  });
+});
+
+// ─── Exporter ─────────────────────────────────────────────────────────────────
+
+describe('export — SnapshotExporter', () => {
+  it('appends to a file across exporter instances', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-export-'));
+    const file = path.join(dir, 'snapshots.bin');
+    try {
+      for (const state of ['RUNNING', 'STOPPED']) {
+        const exporter = new SnapshotExporter({ path: file });
+        exporter.write([status('cron', state)]);
+        await exporter.close();
+      }
+      const states = [];
+      for await (const frame of decodeSnapshots(fs.createReadStream(file))) {
+        states.push(frame.statuses[0].state);
+      }
+      assert.deepEqual(states, ['RUNNING', 'STOPPED']);
+    } finally {
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+
+  it('reports an unwritable file through onError and write()', async () => {
+    const errors: Error[] = [];
+    const exporter = new SnapshotExporter({ path: '/nonexistent/dir/snapshots.bin', onError: e => errors.push(e) });
+    while (errors.length === 0) await new Promise(resolve => setTimeout(resolve, 5));
+    assert.throws(() => exporter.write([status('cron', 'RUNNING')]), /ENOENT/);
+    await assert.rejects(exporter.drained(), /ENOENT/);
+    await assert.rejects(exporter.close(), /ENOENT/);
+    assert.equal(errors.length, 1);
+  });
+
+  it('survives a socket nobody listens on, then reconnects with a fresh stream', async () => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-export-'));
+    const sock = path.join(dir, 'collector.sock');
+    const errors: Error[] = [];
+    const exporter = new SnapshotExporter({ socket: sock, onError: e => errors.push(e), reconnectDelay: 5, maxReconnectDelay: 20 });
+    let server: net.Server | null = null;
+    try {
+      exporter.write([status('cron', 'RUNNING')]);
+      while (errors.length < 2) await new Promise(resolve => setTimeout(resolve, 5));
+      assert.ok(errors.every(e => /ENOENT|ECONNREFUSED/.test((e as NodeJS.ErrnoException).code ?? '')));
+
+      const frames = new Promise<string[]>(resolve => {
+        server = net.createServer(conn => {
+          void (async () => {
+            for await (const frame of decodeSnapshots(conn)) {
+              resolve([String(frame.keyframe), frame.statuses[0].state]);
+              conn.destroy();
+              break;
+            }
+          })();
+        });
+        server.listen(sock);
+      });
+      // Writes are dropped until a connection is up.
+      const timer = setInterval(() => exporter.write([status('cron', 'STOPPED')]), 5);
+      try {
+        assert.deepEqual(await frames, ['true', 'STOPPED']);
+      } finally {
+        clearInterval(timer);
+      }
+    } finally {
+      await exporter.close();
+      await new Promise(resolve => (server ? server.close(resolve) : resolve(undefined)));
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+});
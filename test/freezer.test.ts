@@ -0,0 +1,121 @@
+'use strict';
+
+/**
+ * Tests for the `PAUSED` states surfaced for the freezer (src/freezer.ts),
+ * with systemd answers replayed from a trace.
+ */
+
+import { describe, it, before, after } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { getServiceStatus, parseFrozen, frozenCgroups } from '../src/linux';
+import { replayTrace } from '../src/trace';
+import { setCgroupFrozen } from '../src/freezer';
+
+describe('freezer — parseFrozen', () => {
+  it('reads the frozen flag of cgroup.events', () => {
+    assert.equal(parseFrozen('populated 1\nfrozen 1\n'), true);
+    assert.equal(parseFrozen('populated 1\nfrozen 0\n'), false);
+    assert.equal(parseFrozen('populated 1\n'), null);
+    assert.equal(parseFrozen(null), null);
+  });
+});
+
+describe('freezer — systemd FreezerState', () => {
+  let dir = '';
+
+  before(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-freezer-'));
+  });
+
+  after(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('maps frozen, freezing and thawing units to PAUSED, PAUSE_PENDING and CONTINUE_PENDING', async () => {
+    const unit = (freezerState: string) => ({
+      loadState: 'loaded', activeState: 'active', subState: 'running', mainPid: 42, type: 'service',
+      props: { ActiveState: 'active', FreezerState: freezerState }
+    });
+    const file = path.join(dir, 'freezer.ndjson');
+    fs.writeFileSync(file, [
+      { trace: 'service_api', version: 1, start: 0 },
+      { t: 0, op: 'init', args: [], ms: 0, result: 'systemd' },
+      { t: 0, op: 'libsystemd', args: [], ms: 0, result: true },
+      ...['freezing', 'frozen', 'thawing', 'running'].map(state =>
+        ({ t: 0, op: 'dbus.unit', args: ['batch'], ms: 0, result: unit(state) }))
+    ].map(e => JSON.stringify(e)).join('\n') + '\n');
+
+    const replay = replayTrace(file, { timeScale: 0 });
+    try {
+      const states: string[] = [];
+      for (let i = 0; i < 4; i++) {
+        const status = await getServiceStatus('batch');
+        assert.equal(status.rawCode, 'active');
+        states.push(status.state);
+      }
+      assert.deepEqual(states, ['PAUSE_PENDING', 'PAUSED', 'CONTINUE_PENDING', 'RUNNING']);
+    } finally {
+      await replay.stop();
+    }
+  });
+});
+
+describe('freezer — cgroup.freeze (OpenRC/SysV)', () => {
+  let dir = '';
+
+  before(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-cgroup-'));
+  });
+
+  after(() => {
+    frozenCgroups.delete('batch');
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  /** Plays the kernel: mirrors `cgroup.freeze` into `cgroup.events`, once. */
+  function reportFrozen(): NodeJS.Timeout {
+    const timer = setInterval(() => {
+      const freeze = fs.readFileSync(path.join(dir, 'cgroup.freeze'), 'utf8').trim();
+      const events = fs.readFileSync(path.join(dir, 'cgroup.events'), 'utf8');
+      if (parseFrozen(events) === (freeze === '1')) return;
+      fs.writeFileSync(path.join(dir, 'cgroup.events'), `populated 1\nfrozen ${freeze}\n`);
+      clearInterval(timer);
+    }, 5);
+    return timer;
+  }
+
+  it('writes cgroup.freeze and waits for cgroup.events to report the state', async () => {
+    fs.writeFileSync(path.join(dir, 'cgroup.freeze'), '0\n');
+    fs.writeFileSync(path.join(dir, 'cgroup.events'), 'populated 1\nfrozen 0\n');
+    frozenCgroups.set('batch', dir);
+
+    let timer = reportFrozen();
+    try {
+      await setCgroupFrozen('batch', true, 2000);
+    } finally {
+      clearInterval(timer);
+    }
+    assert.equal(fs.readFileSync(path.join(dir, 'cgroup.freeze'), 'utf8'), '1');
+    assert.equal(parseFrozen(fs.readFileSync(path.join(dir, 'cgroup.events'), 'utf8')), true);
+    assert.equal(frozenCgroups.get('batch'), dir);
+
+    timer = reportFrozen();
+    try {
+      await setCgroupFrozen('batch', false, 2000);
+    } finally {
+      clearInterval(timer);
+    }
+    assert.equal(fs.readFileSync(path.join(dir, 'cgroup.freeze'), 'utf8'), '0');
+    assert.equal(frozenCgroups.has('batch'), false);
+  });
+
+  it('rejects once the timeout passes without the state being reported', async () => {
+    fs.writeFileSync(path.join(dir, 'cgroup.freeze'), '0\n');
+    fs.writeFileSync(path.join(dir, 'cgroup.events'), 'populated 1\nfrozen 0\n');
+    frozenCgroups.set('batch', dir);
+    await assert.rejects(setCgroupFrozen('batch', true, 50), /not frozen/);
+  });
+});
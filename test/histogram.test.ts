@@ -0,0 +1,43 @@
+'use strict';
+
+/**
+ * Tests for the HDR-style histogram (src/histogram.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { Histogram } from '../src/histogram';
+
+describe('histogram — Histogram', () => {
+  it('is exact for small values', () => {
+    const h = new Histogram();
+    for (let v = 1; v <= 100; v++) h.record(v);
+    assert.deepEqual(h.snapshot(), { count: 100, min: 1, max: 100, mean: 50.5, p50: 50, p90: 90, p99: 99, p999: 100 });
+  });
+
+  it('stays within 1/64 of the true value across magnitudes', () => {
+    for (const v of [129, 1000, 4096, 65_535, 1_234_567, 2 ** 40 + 12345]) {
+      const h = new Histogram();
+      h.record(v);
+      h.record(v * 3);                         // p50 reports the bucket bound, not the max
+      const p50 = h.percentile(50);
+      assert.ok(Math.abs(p50 - v) / v <= 1 / 64, `${v} → ${p50}`);
+    }
+  });
+
+  it('reports empty histograms as zeros and resets', () => {
+    const h = new Histogram();
+    assert.equal(h.percentile(99), 0);
+    h.record(12);
+    h.reset();
+    assert.deepEqual(h.snapshot(), { count: 0, min: 0, max: 0, mean: 0, p50: 0, p90: 0, p99: 0, p999: 0 });
+  });
+
+  it('records again after a reset', () => {
+    const h = new Histogram();
+    h.record(5000);
+    h.reset();
+    h.record(7);
+    assert.deepEqual([h.count, h.percentile(50), h.snapshot().max], [1, 7, 7]);
+  });
+});
@@ -0,0 +1,102 @@
+'use strict';
+
+/**
+ * Tests for the SQLite history store (src/history.ts). Skipped where
+ * node:sqlite is unavailable (Node < 22.5).
+ */
+
+import { describe, it, beforeEach, afterEach } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { ServiceStatus } from '../src/types';
+import { HistoryStore } from '../src/history';
+
+function sqliteSkipReason(): string | false {
+  try {
+    require('node:sqlite');
+    return false;
+  } catch {
+    return 'node:sqlite unavailable';
+  }
+}
+
+const skip = sqliteSkipReason();
+const MINUTE = 60_000;
+const HOUR = 60 * MINUTE;
+const T0 = Date.UTC(2026, 0, 1, 10, 0, 0);
+
+const status = (state: string, pid = 0): ServiceStatus => ({ name: 'api', exists: true, state, pid, rawCode: state });
+
+describe('history — HistoryStore', { skip }, () => {
+  let dir: string;
+  let store: HistoryStore;
+
+  beforeEach(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'history-'));
+    store = new HistoryStore(path.join(dir, 'history.db'), { compactInterval: 0, flushInterval: 10_000 });
+  });
+
+  afterEach(() => {
+    store.close();
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('records transitions once, skipping repeated observations', () => {
+    store.observe({ name: 'api', previous: null, current: status('RUNNING', 10), timestamp: T0 });
+    store.observe({ name: 'api', previous: status('RUNNING'), current: status('RUNNING', 10), timestamp: T0 + 1 });
+    store.observe({ name: 'api', previous: status('RUNNING'), current: status('STOPPED'), timestamp: T0 + 2 });
+    store.observe({ name: 'db', previous: null, current: status('RUNNING'), timestamp: T0 + 3 });
+
+    const { transitions } = store.query('api', { from: T0, to: T0 + HOUR, resolution: 'raw' });
+    assert.deepEqual(transitions, [
+      { timestamp: T0, from: null, to: 'RUNNING', pid: 10 },
+      { timestamp: T0 + 2, from: 'RUNNING', to: 'STOPPED', pid: 0 }
+    ]);
+  });
+
+  it('returns raw samples in range, optionally per metric', () => {
+    store.recordSample('api', { fds: 10, memory: 1000, tasks: null }, T0);
+    store.recordSample('api', { fds: 20, memory: 2000 }, T0 + 1000);
+    store.recordSample('api', { fds: 30 }, T0 + HOUR);
+
+    const all = store.query('api', { from: T0, to: T0 + MINUTE, resolution: 'raw' });
+    assert.equal(all.samples.length, 4);
+    const fds = store.query('api', { from: T0, to: T0 + MINUTE, resolution: 'raw', metrics: ['fds'] });
+    assert.deepEqual(fds.samples.map(s => s.mean), [10, 20]);
+  });
+
+  it('rolls samples up into minutes and hours, each exactly once', () => {
+    // Two hours of one sample every 10 s, value = minute index within the run
+    for (let t = 0; t < 2 * HOUR; t += 10_000) {
+      store.recordSample('api', { fds: Math.floor(t / MINUTE) }, T0 + t);
+    }
+    store.compact(T0 + 2 * HOUR + 2 * MINUTE);
+    store.compact(T0 + 2 * HOUR + 2 * MINUTE);      // idempotent
+
+    const minutes = store.query('api', { from: T0, to: T0 + 2 * HOUR, resolution: 'minute' }).samples;
+    assert.equal(minutes.length, 120);
+    assert.deepEqual(minutes[5], { timestamp: T0 + 5 * MINUTE, metric: 'fds', count: 6, min: 5, max: 5, mean: 5 });
+
+    const hours = store.query('api', { from: T0, to: T0 + 2 * HOUR, resolution: 'hour' }).samples;
+    assert.equal(hours.length, 2);
+    assert.deepEqual(hours[1], { timestamp: T0 + HOUR, metric: 'fds', count: 360, min: 60, max: 119, mean: 89.5 });
+  });
+
+  it('drops samples past their retention after rolling them up', () => {
+    store.close();
+    store = new HistoryStore(path.join(dir, 'history.db'), { compactInterval: 0, retention: { raw: HOUR } });
+    store.recordSample('api', { fds: 1 }, T0);
+    store.compact(T0 + 3 * HOUR);
+    assert.equal(store.query('api', { from: T0, to: T0 + HOUR, resolution: 'raw' }).samples.length, 0);
+    assert.equal(store.query('api', { from: T0, to: T0 + HOUR, resolution: 'minute' }).samples.length, 1);
+  });
+
+  it('persists across reopening', () => {
+    store.observe({ name: 'api', previous: null, current: status('RUNNING'), timestamp: T0 });
+    store.close();
+    store = new HistoryStore(path.join(dir, 'history.db'), { compactInterval: 0 });
+    assert.equal(store.query('api', { from: T0, to: T0 + 1 }).transitions.length, 1);
+  });
+});
@@ -0,0 +1,75 @@
+'use strict';
+
+/**
+ * Tests for the resource-limit sampler (src/limits.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import { parseLimit, parseNofileLimit, countFds, LimitAlarm, LimitReport } from '../src/limits';
+
+const skip = process.platform !== 'linux' ? 'Linux only' : false;
+
+function report(used: Partial<LimitReport['used']>, limits: Partial<LimitReport['limits']>): LimitReport {
+  return {
+    name: 'nginx', pid: 100, fdPid: 100,
+    used:   { fds: null, tasks: null, memory: null, ...used },
+    limits: { fds: null, tasks: null, memory: null, ...limits }
+  };
+}
+
+describe('limits — parsing', () => {
+  it('maps every spelling of "unlimited" to null', () => {
+    assert.equal(parseLimit(1024), 1024);
+    assert.equal(parseLimit('4915'), 4915);
+    assert.equal(parseLimit(2 ** 64 - 1), null);     // UINT64_MAX over D-Bus
+    assert.equal(parseLimit('infinity'), null);      // systemctl show
+    assert.equal(parseLimit('max\n'), null);         // cgroupfs
+  });
+
+  it('reads the soft open-files limit', () => {
+    const limits = [
+      'Limit                     Soft Limit           Hard Limit           Units',
+      'Max processes             63432                63432                processes',
+      'Max open files            1024                 524288               files',
+      ''
+    ].join('\n');
+    assert.equal(parseNofileLimit(limits), 1024);
+  });
+});
+
+describe('limits — LimitAlarm', () => {
+  it('warns once per threshold crossed upwards and re-arms below it', () => {
+    const alarm = new LimitAlarm([0.8, 0.95]);
+    assert.deepEqual(alarm.check(report({ fds: 500 }, { fds: 1024 })), []);
+
+    const [first] = alarm.check(report({ fds: 850 }, { fds: 1000 }), 1);
+    assert.deepEqual(first, {
+      name: 'nginx', resource: 'fds', used: 850, limit: 1000, utilization: 0.85, threshold: 0.8, timestamp: 1
+    });
+    assert.deepEqual(alarm.check(report({ fds: 900 }, { fds: 1000 })), [], 'no repeat at the same level');
+    assert.equal(alarm.check(report({ fds: 990 }, { fds: 1000 }))[0].threshold, 0.95);
+
+    alarm.check(report({ fds: 100 }, { fds: 1000 }));
+    assert.equal(alarm.check(report({ fds: 960 }, { fds: 1000 }))[0].threshold, 0.95, 're-armed');
+  });
+
+  it('ignores unlimited resources', () => {
+    const alarm = new LimitAlarm();
+    assert.deepEqual(alarm.check(report({ memory: 2 ** 40, tasks: 10 }, {})), []);
+  });
+});
+
+describe('limits — countFds', () => {
+  it('counts the open descriptors of this process', { skip }, async () => {
+    const before = await countFds(process.pid);
+    assert.ok(before !== null && before > 0);
+    const fd = fs.openSync('/proc/self/stat', 'r');
+    try {
+      assert.equal(await countFds(process.pid), before + 1);
+    } finally {
+      fs.closeSync(fd);
+    }
+  });
+});
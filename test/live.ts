@@ -0,0 +1,25 @@
+'use strict';
+
+/**
+ * Skip reasons shared by the live tests: `it(…, { skip: reason() })` runs a
+ * test only on a host that can actually exercise it.
+ */
+
+import fs from 'fs';
+import { tryLoadLibsystemd } from '../src/sdbus';
+
+/** Why a test that needs root on Linux cannot run here, or `false`. */
+export function rootSkipReason(): string | false {
+  if (process.platform !== 'linux') return 'Linux only';
+  if (typeof process.getuid === 'function' && process.getuid() !== 0) return 'requires root';
+  return false;
+}
+
+/** Why a test that drives systemd over libsystemd, as root, cannot run here, or `false`. */
+export function systemdSkipReason(): string | false {
+  const reason = rootSkipReason();
+  if (reason) return reason;
+  if (!fs.existsSync('/run/systemd/system')) return 'requires systemd';
+  if (!tryLoadLibsystemd()) return 'requires libsystemd';
+  return false;
+}
@@ -0,0 +1,72 @@
+'use strict';
+
+/**
+ * Tests for the sliding-window log rate counters (src/logrates.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { LogRateCounter } from '../src/logrates';
+
+const T0 = 1_700_000_000_000;
+
+describe('logrates — LogRateCounter', () => {
+  it('sums entries and bytes per unit over the window, largest first', () => {
+    const counter = new LogRateCounter(10_000);
+    for (let i = 0; i < 10; i++) counter.add('chatty.service', 1000, T0 + i * 500);
+    counter.add('quiet.service', 20, T0 + 1000);
+    counter.add('(kernel)', 80, T0 + 2000);
+
+    const rates = counter.snapshot(T0 + 5000);
+    assert.deepEqual(rates.units.map(u => u.unit), ['chatty.service', '(kernel)', 'quiet.service']);
+    const chatty = rates.units[0];
+    assert.equal(chatty.entries, 10);
+    assert.equal(chatty.bytes, 10_000);
+    assert.equal(chatty.bytesPerSec, 1000);
+    assert.equal(chatty.entriesPerSec, 1);
+    assert.equal(rates.total.entries, 12);
+    assert.equal(rates.total.bytes, 10_100);
+    assert.equal(rates.to, T0 + 5000);
+    assert.equal(rates.to - rates.from, 10_000);
+  });
+
+  it('divides by the span covered, partial current second included', () => {
+    const counter = new LogRateCounter(10_000);
+    counter.add('a.service', 100, T0 - 10_000);    // oldest whole second
+    counter.add('a.service', 100, T0 + 400);       // current second
+    const rates = counter.snapshot(T0 + 500);
+    assert.equal(rates.from, T0 - 10_000);
+    assert.equal(rates.to - rates.from, 10_500);
+    assert.equal(rates.total.entries, 2);
+    assert.equal(rates.total.bytesPerSec, 200 / 10.5);
+    assert.equal(counter.windowStart(T0 + 500), rates.from);
+  });
+
+  it('expires seconds that leave the window and drops silent units', () => {
+    const counter = new LogRateCounter(3000);
+    counter.add('a.service', 10, T0);
+    counter.add('a.service', 10, T0 + 1000);
+    counter.add('b.service', 5, T0 + 1000);
+    assert.equal(counter.snapshot(T0 + 2000).total.entries, 3);
+
+    // At T0+4000 the window starts at T0+1000: T0 has left it.
+    let rates = counter.snapshot(T0 + 4000);
+    assert.equal(rates.units.find(u => u.unit === 'a.service')!.entries, 1);
+
+    // Slot reuse: a new second overwrites the expired one in the ring.
+    counter.add('a.service', 7, T0 + 4000);
+    rates = counter.snapshot(T0 + 4500);
+    assert.equal(rates.units.find(u => u.unit === 'a.service')!.bytes, 17);
+
+    rates = counter.snapshot(T0 + 10_000);
+    assert.deepEqual(rates.units, []);
+    assert.equal(rates.total.entries, 0);
+  });
+
+  it('ignores entries older than the window', () => {
+    const counter = new LogRateCounter(2000);
+    counter.add('a.service', 1, T0 + 5000);
+    counter.add('a.service', 1, T0);
+    assert.equal(counter.snapshot(T0 + 5000).total.entries, 1);
+  });
+});
@@ -0,0 +1,54 @@
+'use strict';
+
+/**
+ * Tests for per-service memory accounting (src/memory.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { parseSmapsRollup, sampleMemory } from '../src/memory';
+
+const skip = process.platform !== 'linux' ? 'Linux only' : false;
+
+const ROLLUP = [
+  '55c559500000-7ffe3fdae000 ---p 00000000 00:00 0                          [rollup]',
+  'Rss:                1304 kB',
+  'Pss:                 453 kB',
+  'Pss_Dirty:           104 kB',
+  'Shared_Clean:       1160 kB',
+  'Shared_Dirty:          0 kB',
+  'Private_Clean:        40 kB',
+  'Private_Dirty:       104 kB',
+  'Swap:                 12 kB',
+  'SwapPss:               6 kB',
+  'Locked:                0 kB',
+  ''
+].join('\n');
+
+describe('memory — parseSmapsRollup', () => {
+  it('converts the rollup to bytes, with USS as the private pages', () => {
+    assert.deepEqual(parseSmapsRollup(ROLLUP), {
+      rss:     1304 * 1024,
+      pss:     453 * 1024,
+      uss:     144 * 1024,
+      shared:  1160 * 1024,
+      swap:    12 * 1024,
+      swapPss: 6 * 1024
+    });
+  });
+
+  it('returns null for an empty rollup (kernel thread)', () => {
+    assert.equal(parseSmapsRollup(''), null);
+  });
+});
+
+describe('memory — sampleMemory', () => {
+  it('reads this process and leaves out missing ones', { skip }, async () => {
+    const [self, ...rest] = await sampleMemory([process.pid, 0x7ffffffe]);
+    assert.equal(rest.length, 0);
+    assert.equal(self.pid, process.pid);
+    assert.ok(self.rss > 0);
+    assert.ok(self.pss > 0 && self.pss <= self.rss);
+    assert.ok(self.uss <= self.pss);
+  });
+});
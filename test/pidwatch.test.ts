@@ -0,0 +1,113 @@
+'use strict';
+
+/**
+ * Tests for the pidfile watcher (src/pidwatch.ts), on a temporary directory
+ * with a status query that reads it the way the SysV backend does.
+ */
+
+import { describe, it, before, after } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { spawn } from 'child_process';
+import { ServiceChange, ServiceStatus } from '../src/types';
+import { watchPidFiles } from '../src/pidwatch';
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+function pidfdSkipReason(): string | false {
+  if (process.platform !== 'linux') return 'Linux only';
+  try {
+    require.resolve('koffi');
+  } catch {
+    return 'requires koffi';
+  }
+  return false;
+}
+
+describe('pidwatch — watchPidFiles', () => {
+  let dir = '';
+
+  before(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-pidwatch-'));
+  });
+
+  after(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  const query = async (name: string): Promise<ServiceStatus> => {
+    let pid = 0;
+    try {
+      pid = parseInt(fs.readFileSync(path.join(dir, `${name}.pid`), 'utf8'), 10) || 0;
+    } catch {
+      // no pidfile
+    }
+    const running = pid > 0 && fs.existsSync(`/proc/${pid}`);
+    return { name, exists: true, state: running ? 'RUNNING' : 'STOPPED', pid: running ? pid : 0, rawCode: running ? 'active' : 'inactive' };
+  };
+
+  it('reports starts and stops from pidfile creation and removal', async () => {
+    const changes: ServiceChange[] = [];
+    const watcher = await watchPidFiles(c => changes.push(c), { services: ['ntpd', 'cron'], dirs: [dir], query });
+    try {
+      fs.writeFileSync(path.join(dir, 'ntpd.pid'), `${process.pid}\n`);
+      await sleep(100);
+      assert.equal(changes.length, 1);
+      assert.equal(changes[0].name, 'ntpd');
+      assert.equal(changes[0].previous?.state, 'STOPPED');
+      assert.equal(changes[0].current.state, 'RUNNING');
+      assert.equal(changes[0].current.pid, process.pid);
+
+      fs.unlinkSync(path.join(dir, 'ntpd.pid'));
+      await sleep(100);
+      assert.equal(changes.length, 2);
+      assert.equal(changes[1].current.state, 'STOPPED');
+    } finally {
+      watcher.close();
+    }
+  });
+
+  it('ignores files of unwatched services and stale pids', async () => {
+    const changes: ServiceChange[] = [];
+    const watcher = await watchPidFiles(c => changes.push(c), { services: ['cron'], dirs: [dir], query });
+    try {
+      fs.writeFileSync(path.join(dir, 'other.pid'), `${process.pid}\n`);
+      fs.writeFileSync(path.join(dir, 'cron.pid'), '999999999\n');
+      await sleep(350);
+      assert.deepEqual(changes, []);
+    } finally {
+      watcher.close();
+    }
+  });
+
+  it('reports a daemon that dies leaving its pidfile', { skip: pidfdSkipReason() }, async () => {
+    const daemon = spawn('sleep', ['30'], { stdio: 'ignore' });
+    const exited = new Promise(resolve => daemon.on('exit', resolve));
+    fs.writeFileSync(path.join(dir, 'crashd.pid'), `${daemon.pid}\n`);
+    const changes: ServiceChange[] = [];
+    const watcher = await watchPidFiles(c => changes.push(c), { services: ['crashd'], dirs: [dir], query });
+    try {
+      await sleep(100);
+      assert.deepEqual(changes, []);
+      daemon.kill('SIGKILL');
+      await exited;
+      await sleep(100);
+      assert.equal(fs.existsSync(path.join(dir, 'crashd.pid')), true);
+      assert.equal(changes.length, 1);
+      assert.equal(changes[0].previous?.state, 'RUNNING');
+      assert.equal(changes[0].current.state, 'STOPPED');
+    } finally {
+      watcher.close();
+      daemon.kill('SIGKILL');
+    }
+  });
+
+  it('throws when no directory can be watched', async () => {
+    await assert.rejects(
+      watchPidFiles(() => {}, { services: [], dirs: [path.join(dir, 'missing')], query }),
+      /cannot watch/
+    );
+  });
+});
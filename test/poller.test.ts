@@ -0,0 +1,100 @@
+'use strict';
+
+/**
+ * Tests for the adaptive poller (src/poller.ts), with a fake status query.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { ServiceStatus, ServiceChange } from '../src/types';
+import { PollBudget, pollServices } from '../src/poller';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+const sleep = (ms: number) => new Promise<void>(resolve => setTimeout(resolve, ms));
+
+function status(name: string, state: string): ServiceStatus {
+  return { name, exists: true, state, pid: 0, rawCode: state.toLowerCase() };
+}
+
+// ─── PollBudget ───────────────────────────────────────────────────────────────
+
+describe('poller — PollBudget', () => {
+  it('grants a burst, then one token per 1/rate seconds', () => {
+    const budget = new PollBudget(10, 2);
+    const t0 = Date.now();
+    assert.equal(budget.take(t0), 0);
+    assert.equal(budget.take(t0), 0);
+    assert.equal(budget.take(t0), 100);
+    assert.equal(budget.take(t0 + 100), 0);
+  });
+
+  it('rejects a non-positive rate', () => {
+    assert.throws(() => new PollBudget(1).setRate(0), RangeError);
+  });
+});
+
+// ─── pollServices ─────────────────────────────────────────────────────────────
+
+describe('poller — pollServices', () => {
+  it('reports transitions after the baseline poll', async () => {
+    let state = 'STOPPED';
+    const changes: ServiceChange[] = [];
+    const watcher = pollServices(['cron'], async name => status(name, state), c => changes.push(c), {
+      minInterval: 10, jitter: 0, budget: new PollBudget(1000)
+    });
+    try {
+      await sleep(30);
+      assert.equal(changes.length, 0);
+      state = 'RUNNING';
+      await sleep(100);
+      assert.equal(changes.length, 1);
+      assert.equal(changes[0].name, 'cron');
+      assert.equal(changes[0].previous!.state, 'STOPPED');
+      assert.equal(changes[0].current.state, 'RUNNING');
+    } finally {
+      watcher.close();
+    }
+  });
+
+  it('backs off while the service is stable', async () => {
+    const polls: number[] = [];
+    const watcher = pollServices(['cron'], async name => {
+      polls.push(Date.now());
+      return status(name, 'RUNNING');
+    }, () => {}, { minInterval: 10, maxInterval: 80, jitter: 0, budget: new PollBudget(1000) });
+    await sleep(250);
+    watcher.close();
+    // baseline, then 10, 20, 40, 80, 80… ms apart
+    assert.ok(polls.length >= 4 && polls.length <= 7, `${polls.length} polls`);
+    const gaps = polls.slice(1).map((t, i) => t - polls[i]);
+    assert.ok(gaps[gaps.length - 1] > gaps[0], `gaps ${gaps}`);
+  });
+
+  it('defers polls beyond the budget', async () => {
+    let queries = 0;
+    const names = Array.from({ length: 20 }, (_, i) => `svc${i}`);
+    const watcher = pollServices(names, async name => {
+      queries++;
+      return status(name, 'RUNNING');
+    }, () => {}, { minInterval: 5, jitter: 0, budget: new PollBudget(50, 5) });
+    await sleep(200);
+    watcher.close();
+    // 5 at once plus 50/s over 0.2 s
+    assert.ok(queries <= 16, `${queries} queries`);
+    assert.ok(queries >= 5);
+  });
+
+  it('keeps polling after a failed query', async () => {
+    let calls = 0;
+    const errors: Error[] = [];
+    const watcher = pollServices(['flaky'], async name => {
+      if (++calls === 1) throw new Error('boom');
+      return status(name, 'RUNNING');
+    }, () => {}, { minInterval: 5, jitter: 0, budget: new PollBudget(1000), onError: e => errors.push(e) });
+    await sleep(60);
+    watcher.close();
+    assert.equal(errors.length, 1);
+    assert.ok(calls >= 2);
+  });
+});
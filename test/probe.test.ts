@@ -0,0 +1,51 @@
+'use strict';
+
+/**
+ * Tests for the batched probe engine (src/probe.ts), on a temporary tree.
+ */
+
+import { describe, it, before, after } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { ProbeEngine } from '../src/probe';
+
+describe('probe — ProbeEngine', () => {
+  let root = '';
+
+  before(() => {
+    root = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-probe-'));
+    fs.writeFileSync(path.join(root, 'nginx.pid'), '4321\n');
+  });
+
+  after(() => {
+    fs.rmSync(root, { recursive: true, force: true });
+  });
+
+  it('checks existence and reads files', async () => {
+    const engine = new ProbeEngine();
+    assert.equal(await engine.exists(path.join(root, 'nginx.pid')), true);
+    assert.equal(await engine.exists(path.join(root, 'ghost.pid')), false);
+    assert.equal(await engine.read(path.join(root, 'nginx.pid')), '4321\n');
+    assert.equal(await engine.read(path.join(root, 'ghost.pid')), null);
+  });
+
+  it('submits one tick of probes as one de-duplicated batch', async () => {
+    const engine = new ProbeEngine();
+    const p = path.join(root, 'nginx.pid');
+    const results = await Promise.all([engine.exists(p), engine.exists(p), engine.read(p), engine.read(p)]);
+    assert.deepEqual(results, [true, true, '4321\n', '4321\n']);
+    assert.deepEqual(engine.stats(), { requested: 4, issued: 2, batches: 1, inFlight: 0 });
+  });
+
+  it('bounds outstanding operations', async () => {
+    const engine = new ProbeEngine({ maxInFlight: 2 });
+    const probes = Array.from({ length: 10 }, (_, i) => engine.exists(path.join(root, `f${i}`)));
+    assert.equal(engine.stats().inFlight, 0);            // nothing issued before the tick ends
+    await new Promise(resolve => process.nextTick(resolve));
+    assert.equal(engine.stats().inFlight, 2);
+    assert.deepEqual(await Promise.all(probes), new Array(10).fill(false));
+    assert.equal(engine.stats().issued, 10);
+  });
+});
@@ -0,0 +1,154 @@
+'use strict';
+
+/**
+ * Tests for the proc connector event stream (src/procevents.ts).
+ * The live subscription tests need root (CAP_NET_ADMIN) and koffi; they are
+ * skipped elsewhere.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { spawn } from 'child_process';
+import { ServiceStatus, ServiceChange } from '../src/types';
+import { parseProcEvents, openProcConnector, watchProcEvents, ProcEvent } from '../src/procevents';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+/** Builds one connector datagram carrying a proc_event of type `what`. */
+function datagram(what: number, data: number[]): Buffer {
+  const buf = Buffer.alloc(16 + 20 + 16 + data.length * 4);
+  buf.writeUInt32LE(buf.length, 0);
+  buf.writeUInt32LE(1, 16);                   // CN_IDX_PROC
+  buf.writeUInt32LE(1, 20);                   // CN_VAL_PROC
+  buf.writeUInt32LE(what, 36);
+  data.forEach((v, i) => buf.writeUInt32LE(v, 52 + i * 4));
+  return buf;
+}
+
+function liveSkipReason(): string | false {
+  if (process.platform !== 'linux') return 'Linux only';
+  if (typeof process.getuid === 'function' && process.getuid() !== 0) return 'requires root (CAP_NET_ADMIN)';
+  try {
+    require.resolve('koffi');
+  } catch {
+    return 'koffi not installed';
+  }
+  return false;
+}
+
+// ─── parseProcEvents ──────────────────────────────────────────────────────────
+
+describe('procevents — parseProcEvents', () => {
+  it('decodes exec, exit and fork events', () => {
+    const exec = datagram(0x2, [1234, 1234]);
+    const exit = datagram(0x80000000, [1234, 1234, 256, 17]);
+    const fork = datagram(0x1, [1, 1, 99, 99]);
+    const buf = Buffer.concat([exec, exit, fork]);
+    assert.deepEqual(parseProcEvents(buf, buf.length), [
+      { type: 'exec', pid: 1234, tgid: 1234 },
+      { type: 'exit', pid: 1234, tgid: 1234, exitCode: 256, exitSignal: 17 },
+      { type: 'fork', parentPid: 1, parentTgid: 1, pid: 99, tgid: 99 }
+    ]);
+  });
+
+  it('ignores other connector ids and truncated messages', () => {
+    const other = datagram(0x2, [1, 1]);
+    other.writeUInt32LE(7, 16);
+    assert.deepEqual(parseProcEvents(other, other.length), []);
+    const exec = datagram(0x2, [5, 5]);
+    assert.deepEqual(parseProcEvents(exec, 20), []);
+  });
+});
+
+// ─── openProcConnector (live) ─────────────────────────────────────────────────
+
+describe('procevents — openProcConnector (live, root)', () => {
+  const skip = liveSkipReason();
+
+  it('reports exec and exit of a spawned process', { skip }, async t => {
+    const seen: ProcEvent[] = [];
+    let conn: { close(): void };
+    try {
+      conn = openProcConnector(ev => seen.push(ev));
+    } catch (err: any) {
+      // e.g. an unprivileged container
+      if (err.code === 'EPERM') return t.skip('needs CAP_NET_ADMIN');
+      throw err;
+    }
+    try {
+      const child = spawn('/bin/sh', ['-c', 'exec sleep 0.1']);
+      await new Promise(resolve => child.on('close', resolve));
+      await new Promise(resolve => setTimeout(resolve, 300));
+      const pid = child.pid!;
+      assert.ok(seen.some(e => e.type === 'exec' && e.tgid === pid), 'exec event');
+      assert.ok(seen.some(e => e.type === 'exit' && e.tgid === pid), 'exit event');
+    } finally {
+      conn.close();
+    }
+  });
+});
+
+// ─── watchProcEvents (live) ───────────────────────────────────────────────────
+
+describe('procevents — watchProcEvents (live, root)', () => {
+  const skip = liveSkipReason();
+
+  it('attributes a spawned daemon to its init script and sees the daemon exit', { skip }, async t => {
+    const dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-procevents-'));
+    const daemon = path.join(dir, 'svcapi-daemon');
+    const pidfile = path.join(dir, 'svcapi-test.pid');
+    fs.copyFileSync(fs.realpathSync('/bin/sleep'), daemon);
+    fs.chmodSync(daemon, 0o755);
+    fs.mkdirSync(path.join(dir, 'init.d'));
+    fs.writeFileSync(path.join(dir, 'init.d', 'svcapi-test'), `#!/bin/sh\nDAEMON=${daemon}\n`);
+
+    // Stand-in for the SysV status: pidfile plus /proc/<pid> liveness.
+    const query = async (name: string): Promise<ServiceStatus> => {
+      let pid = 0;
+      try {
+        pid = parseInt(fs.readFileSync(pidfile, 'utf8'), 10) || 0;
+      } catch {
+        // no pidfile
+      }
+      const running = pid > 0 && fs.existsSync(`/proc/${pid}`) &&
+        !/^\d+ \(.*\) Z/.test(fs.readFileSync(`/proc/${pid}/stat`, 'utf8'));
+      return { name, exists: true, state: running ? 'RUNNING' : 'STOPPED', pid: running ? pid : 0, rawCode: running ? 'active' : 'inactive' };
+    };
+
+    const changes: ServiceChange[] = [];
+    let watcher: { close(): void };
+    try {
+      watcher = await watchProcEvents(c => changes.push(c), {
+        services: ['svcapi-test'], query, initDir: path.join(dir, 'init.d')
+      });
+    } catch (err: any) {
+      fs.rmSync(dir, { recursive: true, force: true });
+      if (err.code === 'EPERM') return t.skip('needs CAP_NET_ADMIN');
+      throw err;
+    }
+    const waitFor = async (state: string) => {
+      for (let i = 0; i < 100 && !changes.some(c => c.current.state === state); i++) {
+        await new Promise(resolve => setTimeout(resolve, 20));
+      }
+      return changes.find(c => c.current.state === state);
+    };
+    try {
+      const child = spawn(daemon, ['30'], { stdio: 'ignore' });
+      fs.writeFileSync(pidfile, `${child.pid}\n`);
+      const started = await waitFor('RUNNING');
+      assert.ok(started, 'exec of the init script DAEMON= binary is attributed to the service');
+      assert.equal(started.name, 'svcapi-test');
+      assert.equal(started.current.pid, child.pid);
+
+      child.kill('SIGKILL');
+      const stopped = await waitFor('STOPPED');
+      assert.ok(stopped, 'exit of the tracked pid re-queries the service');
+    } finally {
+      watcher.close();
+      fs.rmSync(dir, { recursive: true, force: true });
+    }
+  });
+});
@@ -0,0 +1,108 @@
+'use strict';
+
+/**
+ * Tests for the resource-control marshalling (src/resources.ts). The live
+ * test throttles a transient unit through systemd and needs root; it is
+ * skipped elsewhere.
+ */
+
+import { describe, it, after } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { execFileSync } from 'child_process';
+import {
+  resourceProperties, resourceAssignments, setServiceResourcesBatch, setServiceResources
+} from '../src/resources';
+import {
+  withSystemBus, newMethodCall, callPipelined, freeMessage, BusMessageWriter, BusCallError,
+  SYSTEMD_PATH, MANAGER_IFACE
+} from '../src/sdbus';
+import { runTransient } from '../src/transient';
+import { getUnitProperties } from '../src/linux';
+import { systemdSkipReason } from './live';
+
+const INFINITY = 2n ** 64n - 1n;
+
+describe('resources — resourceProperties', () => {
+  it('maps settings to SetUnitProperties values', () => {
+    assert.deepEqual(resourceProperties({ cpuQuota: 0.5, memoryHigh: 1 << 30, ioWeight: 20 }), [
+      ['CPUQuotaPerSecUSec', ['t', 500_000]],
+      ['MemoryHigh', ['t', 1 << 30]],
+      ['IOWeight', ['t', 20]]
+    ]);
+  });
+
+  it('maps null to UINT64_MAX, skips undefined', () => {
+    assert.deepEqual(resourceProperties({ cpuQuota: null, memoryMax: null, tasksMax: undefined }), [
+      ['CPUQuotaPerSecUSec', ['t', INFINITY]],
+      ['MemoryMax', ['t', INFINITY]]
+    ]);
+  });
+
+  it('rejects invalid settings', () => {
+    assert.throws(() => resourceProperties({}), TypeError);
+    assert.throws(() => resourceProperties({ cpuQuota: 0 }), TypeError);
+    assert.throws(() => resourceProperties({ ioWeight: NaN }), TypeError);
+    assert.throws(() => resourceProperties({ cpuWeight: 50.5 }), /integer/);
+    assert.throws(() => resourceProperties({ memoryMax: 1024.5 }), /integer/);
+    assert.deepEqual(resourceProperties({ cpuQuota: 0.125 }), [['CPUQuotaPerSecUSec', ['t', 125_000]]]);
+    assert.throws(() => resourceProperties({ cpuShares: 10 } as never), /unknown/);
+  });
+
+  it('rejects an invalid batch', async () => {
+    await assert.rejects(setServiceResourcesBatch([{ name: '', resources: { cpuWeight: 10 } }]), TypeError);
+  });
+});
+
+describe('resources — resourceAssignments', () => {
+  it('formats systemctl set-property assignments', () => {
+    assert.deepEqual(resourceAssignments({ cpuQuota: 0.25, memoryHigh: 512, cpuWeight: 50 }), [
+      'CPUQuota=25%', 'MemoryHigh=512', 'CPUWeight=50'
+    ]);
+    assert.deepEqual(resourceAssignments({ cpuQuota: null, ioWeight: null, memoryHigh: null, tasksMax: null }), [
+      'CPUQuota=', 'IOWeight=', 'MemoryHigh=infinity', 'TasksMax=infinity'
+    ]);
+  });
+});
+
+// ─── Live (systemd) ───────────────────────────────────────────────────────────
+
+describe('resources — setServiceResources (live, systemd)', () => {
+  const skip = systemdSkipReason();
+  const unit = `service-api-resources-${process.pid}.service`;
+  const missing = `service-api-missing-${process.pid}.service`;
+
+  after(() => {
+    if (!skip) execFileSync('systemctl', ['stop', unit], { stdio: 'ignore' });
+  });
+
+  it('pipelines SetUnitProperties over a throwaway unit', { skip }, async () => {
+    const run = await runTransient({ name: unit, command: ['/bin/sleep', '60'] });
+    assert.equal(run.result, 'done');
+
+    // Replies come back in request order, errors in place.
+    const replies = withSystemBus(bus => callPipelined(bus, [unit, missing].map(name => {
+      const m = newMethodCall(bus, SYSTEMD_PATH, MANAGER_IFACE, 'GetUnit');
+      new BusMessageWriter(m).string(name);
+      return m;
+    }), 'GetUnit'));
+    assert.equal(replies.length, 2);
+    assert.ok(!(replies[0] instanceof BusCallError));
+    freeMessage(replies[0]);
+    assert.ok(replies[1] instanceof BusCallError);
+    assert.equal(replies[1].busError, 'org.freedesktop.systemd1.NoSuchUnit');
+
+    const results = await setServiceResourcesBatch([
+      { name: unit, resources: { cpuWeight: 20, tasksMax: 16 } },
+      { name: missing, resources: { cpuWeight: 20 } }
+    ]);
+    assert.equal(results[0].error, null);
+    assert.equal(results[1].name, missing);
+    assert.notEqual(results[1].error, null);
+
+    await setServiceResources(unit, { memoryHigh: 64 * 1024 * 1024 });
+    const [props] = getUnitProperties([unit], ['CPUWeight', 'TasksMax', 'MemoryHigh']);
+    assert.equal(Number(props.CPUWeight), 20);
+    assert.equal(Number(props.TasksMax), 16);
+    assert.equal(Number(props.MemoryHigh), 64 * 1024 * 1024);
+  });
+});
@@ -0,0 +1,161 @@
+'use strict';
+
+/**
+ * Tests for the rule engine (src/rules.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { RuleEngine, compileRule } from '../src/rules';
+import { ServiceStatus } from '../src/types';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+function status(name: string, state: string, rawCode: string, pid = 0): ServiceStatus {
+  return { name, exists: true, state, pid, rawCode };
+}
+
+const running = (name: string, pid = 100) => status(name, 'RUNNING', 'active', pid);
+const stopped = (name: string) => status(name, 'STOPPED', 'inactive');
+const failed  = (name: string) => status(name, 'STOPPED', 'failed');
+
+// ─── compileRule ──────────────────────────────────────────────────────────────
+
+describe('rules — compileRule', () => {
+  it('collects named service dependencies', () => {
+    const rule = compileRule("state(nginx)=='RUNNING' && state(php-fpm)=='RUNNING'");
+    assert.deepEqual([...rule.services].sort(), ['nginx', 'php-fpm']);
+    assert.deepEqual(rule.aggregates, []);
+  });
+
+  it('collects count() aggregates', () => {
+    const rule = compileRule("count(state=='failed') > 0");
+    assert.deepEqual(rule.services, []);
+    assert.deepEqual(rule.aggregates, ["state=='failed'"]);
+  });
+
+  it('rejects malformed expressions', () => {
+    assert.throws(() => compileRule("state(nginx)=="), SyntaxError);
+    assert.throws(() => compileRule("state(nginx"), SyntaxError);
+    assert.throws(() => compileRule("bogus(nginx)"), SyntaxError);
+    assert.throws(() => compileRule("count(state(nginx)=='RUNNING')"), SyntaxError);
+  });
+
+  it('rejects non-string expressions', () => {
+    assert.throws(() => compileRule('' as any), TypeError);
+  });
+});
+
+// ─── RuleEngine ───────────────────────────────────────────────────────────────
+
+describe('rules — RuleEngine', () => {
+  it('fires when a conjunction becomes true and false again', () => {
+    const engine = new RuleEngine();
+    const seen: boolean[] = [];
+    engine.addRule("state(nginx)=='RUNNING' && state(php-fpm)=='RUNNING'", v => seen.push(v));
+
+    engine.update(running('nginx'));
+    assert.deepEqual(seen, []);
+    engine.update(running('php-fpm'));
+    assert.deepEqual(seen, [true]);
+    engine.update(stopped('php-fpm'));
+    assert.deepEqual(seen, [true, false]);
+  });
+
+  it('matches raw codes and normalized states case-insensitively', () => {
+    const engine = new RuleEngine();
+    const rule = engine.addRule("state(db)=='failed'", () => {});
+    engine.update(failed('db'));
+    assert.equal(rule.value, true);
+
+    const rule2 = engine.addRule("state(db)=='stopped'", () => {});
+    assert.equal(rule2.value, true);
+  });
+
+  it('only re-evaluates rules that mention the updated service', () => {
+    const engine = new RuleEngine();
+    let calls = 0;
+    const rule = engine.addRule("state(nginx)=='RUNNING'", () => calls++);
+    engine.update(running('sshd'));
+    engine.update(stopped('sshd'));
+    assert.equal(calls, 0);
+    assert.equal(rule.value, false);
+  });
+
+  it('maintains count() incrementally', () => {
+    const engine = new RuleEngine();
+    const seen: boolean[] = [];
+    engine.addRule("count(state=='failed') > 1", v => seen.push(v));
+
+    engine.update(failed('a'));
+    engine.update(failed('b'));
+    assert.deepEqual(seen, [true]);
+    engine.update(running('a'));
+    assert.deepEqual(seen, [true, false]);
+    engine.update(failed('c'));
+    assert.deepEqual(seen, [true, false, true]);
+    engine.delete('c');
+    assert.deepEqual(seen, [true, false, true, false]);
+  });
+
+  it('keeps count() predicates apart that differ inside a string', () => {
+    const engine = new RuleEngine();
+    const spaced = engine.addRule("count(name == 'a b') == 1", () => {});
+    const joined = engine.addRule("count( name=='ab' ) == 1", () => {});
+    assert.deepEqual(compileRule("count( name == 'a b' ) > 0").aggregates, ["name=='a b'"]);
+    engine.update(running('a b'));
+    assert.equal(spaced.value, true);
+    assert.equal(joined.value, false);
+  });
+
+  it('fires a listener once for a batch touching several of its services', () => {
+    const engine = new RuleEngine();
+    const seen: boolean[] = [];
+    engine.addRule("count(state=='RUNNING') == 1 && exists(php-fpm)", v => seen.push(v));
+    engine.updateAll([running('nginx'), stopped('php-fpm')]);
+    assert.deepEqual(seen, [true]);
+    // Looping update() would pass through zero running services.
+    engine.updateAll([stopped('nginx'), running('php-fpm')]);
+    assert.deepEqual(seen, [true]);
+    engine.updateAll([failed('php-fpm')]);
+    assert.deepEqual(seen, [true, false]);
+  });
+
+  it('notifies every listener before rethrowing the first error', () => {
+    const engine = new RuleEngine();
+    const seen: string[] = [];
+    engine.addRule('exists(a)', () => { seen.push('first'); throw new Error('first'); });
+    engine.addRule('exists(a)', () => { seen.push('second'); throw new Error('second'); });
+    engine.addRule('exists(a)', () => { seen.push('third'); });
+    assert.throws(() => engine.update(running('a')), /^Error: first$/);
+    assert.deepEqual(seen, ['first', 'second', 'third']);
+    assert.equal(engine.get('a')?.state, 'RUNNING');
+  });
+
+  it('evaluates new rules against the existing table', () => {
+    const engine = new RuleEngine();
+    engine.updateAll([failed('a'), running('b', 42)]);
+    assert.equal(engine.addRule("count(state=='failed') == 1", () => {}).value, true);
+    assert.equal(engine.addRule('pid(b) == 42 && !exists(c)', () => {}).value, true);
+  });
+
+  it('ignores identical repeated statuses', () => {
+    const engine = new RuleEngine();
+    let calls = 0;
+    engine.addRule("state(nginx)=='RUNNING'", () => calls++);
+    engine.update(running('nginx'));
+    engine.update(running('nginx'));
+    assert.equal(calls, 1);
+  });
+
+  it('stops notifying removed rules', () => {
+    const engine = new RuleEngine();
+    let calls = 0;
+    const rule = engine.addRule("count(state=='RUNNING') > 0", () => calls++);
+    assert.equal(engine.removeRule(rule), true);
+    assert.equal(engine.removeRule(rule), false);
+    engine.update(running('nginx'));
+    assert.equal(calls, 0);
+    assert.equal(engine.size, 0);
+  });
+});
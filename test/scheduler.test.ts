@@ -0,0 +1,93 @@
+'use strict';
+
+/**
+ * Tests for the concurrency limiter (src/scheduler.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { Scheduler } from '../src/scheduler';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+/** A task that stays in flight until `release()` is called. */
+function deferred<T = void>() {
+  let release!: (v: T) => void;
+  const promise = new Promise<T>(resolve => { release = resolve; });
+  return { promise, release };
+}
+
+const tick = () => new Promise<void>(resolve => setImmediate(resolve));
+
+// ─── Scheduler ────────────────────────────────────────────────────────────────
+
+describe('scheduler — Scheduler', () => {
+  it('caps in-flight work per lane and reports queue depth', async () => {
+    const s = new Scheduler({ fs: 2 });
+    const gates = [deferred(), deferred(), deferred()];
+    let running = 0, peak = 0;
+    const all = gates.map(g => s.run('fs', async () => {
+      running++;
+      peak = Math.max(peak, running);
+      await g.promise;
+      running--;
+    }));
+
+    assert.equal(s.queueDepth, 1);
+    assert.deepEqual(s.stats().lanes.fs, { limit: 2, inFlight: 2, queued: 1, groups: 1 });
+
+    gates.forEach(g => g.release());
+    await Promise.all(all);
+    assert.equal(peak, 2);
+    assert.equal(s.queueDepth, 0);
+    assert.equal(s.stats().inFlight, 0);
+  });
+
+  it('lanes are independent', async () => {
+    const s = new Scheduler({ a: 1, b: 1 });
+    const gate = deferred();
+    const blocked = s.run('a', () => gate.promise);
+    assert.equal(await s.run('b', () => 42), 42);
+    gate.release();
+    await blocked;
+  });
+
+  it('serves groups round-robin so a large batch does not starve a single call', async () => {
+    const s = new Scheduler({ sysv: 1 });
+    const order: string[] = [];
+    const gate = deferred();
+    const first = s.run('sysv', () => gate.promise);
+
+    const batch = s.createGroup();
+    const big = s.withGroup(batch, () =>
+      Promise.all(Array.from({ length: 50 }, (_, i) => s.run('sysv', () => { order.push(`batch${i}`); })))
+    );
+    const single = s.run('sysv', () => { order.push('single'); });
+
+    gate.release();
+    await Promise.all([first, big, single]);
+    assert.ok(order.indexOf('single') <= 1, `single ran at position ${order.indexOf('single')}`);
+  });
+
+  it('propagates task errors and frees the slot', async () => {
+    const s = new Scheduler({ x: 1 });
+    await assert.rejects(() => s.run('x', () => { throw new Error('boom'); }), /boom/);
+    await assert.rejects(() => s.run('x', () => Promise.reject(new Error('later'))), /later/);
+    assert.equal(await s.run('x', () => 'ok'), 'ok');
+  });
+
+  it('setLimit drains waiting work', async () => {
+    const s = new Scheduler({ x: 1 });
+    const gate = deferred();
+    const first = s.run('x', () => gate.promise);
+    let started = false;
+    const second = s.run('x', () => { started = true; });
+    await tick();
+    assert.equal(started, false);
+    s.setLimit('x', 2);
+    assert.equal(started, true);
+    gate.release();
+    await Promise.all([first, second]);
+    assert.throws(() => s.setLimit('x', 0), RangeError);
+  });
+});
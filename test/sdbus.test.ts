@@ -0,0 +1,23 @@
+'use strict';
+
+/**
+ * Tests for the D-Bus marshalling helpers (src/sdbus.ts) that need no bus.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { splitSignature } from '../src/sdbus';
+
+describe('sdbus — splitSignature', () => {
+  it('splits a signature into complete types', () => {
+    assert.deepEqual(splitSignature('ssa(sv)a(sa(sv))'), ['s', 's', 'a(sv)', 'a(sa(sv))']);
+    assert.deepEqual(splitSignature('a{sv}(sb)u'), ['a{sv}', '(sb)', 'u']);
+    assert.deepEqual(splitSignature('sbas'), ['s', 'b', 'as']);
+    assert.deepEqual(splitSignature(''), []);
+  });
+
+  it('rejects incomplete signatures', () => {
+    assert.throws(() => splitSignature('a'), TypeError);
+    assert.throws(() => splitSignature('(sb'), TypeError);
+  });
+});
@@ -2,53 +2,90 @@
 
 /**
  * Tests for the Linux implementation (src/linux.ts).
- * Mocks fs.accessSync and fs.readFileSync to avoid requiring a real init system.
+ * Mocks fs.accessSync / fs.readFileSync and their callback counterparts
+ * fs.access / fs.stat / fs.readFile to avoid requiring a real init system.
  */
 
 import { describe, it } from 'node:test';
 import * as assert from 'node:assert/strict';
 import fs from 'fs';
+import os from 'os';
+import path from 'path';
 
 // Use require to get the mutable child_process module (not a frozen __importStar wrapper)
 const child_process = require('child_process');
 
 // ─── Helpers ──────────────────────────────────────────────────────────────────
 
+function enoent(p: unknown): NodeJS.ErrnoException {
+  const err: NodeJS.ErrnoException = new Error(`ENOENT: ${p}`);
+  err.code = 'ENOENT';
+  return err;
+}
+
 /**
- * Runs `fn` with fs.accessSync and fs.readFileSync patched.
- * `existsSet` is the set of paths that "exist" (accessSync succeeds for them).
- * `pidMap` maps pid-file paths to their string contents.
- *
- * NOTE: requireLinux() must be called BEFORE withFsMock so that Node.js's
- * module loader uses the real fs to read the .js file.
+ * Patches the sync and callback fs calls used by the Linux backend.
+ * Returns a function restoring the originals.
  */
-async function withFsMock(
-  existsSet: Set<string>,
-  pidMap: Record<string, string>,
-  fn: () => unknown
-): Promise<void> {
-  const origAccess   = fs.accessSync;
-  const origReadFile = fs.readFileSync;
+function installFsMock(existsSet: Set<string>, pidMap: Record<string, string>): () => void {
+  const origAccess       = fs.accessSync;
+  const origReadFile     = fs.readFileSync;
+  const origAccessCb     = fs.access;
+  const origStatCb       = fs.stat;
+  const origReadFileCb   = fs.readFile;
 
   fs.accessSync = (p: any) => {
     if (existsSet.has(String(p))) return;
-    const err: any = new Error(`ENOENT: ${p}`);
-    err.code = 'ENOENT';
-    throw err;
+    throw enoent(p);
   };
   (fs as any).readFileSync = (p: any, enc?: any) => {
     const key = String(p);
     if (key in pidMap) return pidMap[key];
-    const err: any = new Error(`ENOENT: ${p}`);
-    err.code = 'ENOENT';
-    throw err;
+    throw enoent(p);
+  };
+  (fs as any).access = (p: any, ...rest: any[]) => {
+    const cb = rest[rest.length - 1];
+    const err = existsSet.has(String(p)) ? null : enoent(p);
+    process.nextTick(() => cb(err));
+  };
+  (fs as any).stat = (p: any, ...rest: any[]) => {
+    const cb = rest[rest.length - 1];
+    const err = existsSet.has(String(p)) ? null : enoent(p);
+    process.nextTick(() => (err ? cb(err) : cb(null, {})));
   };
+  (fs as any).readFile = (p: any, ...rest: any[]) => {
+    const cb = rest[rest.length - 1];
+    const key = String(p);
+    process.nextTick(() => (key in pidMap ? cb(null, pidMap[key]) : cb(enoent(p))));
+  };
+
+  return () => {
+    fs.accessSync            = origAccess;
+    (fs as any).readFileSync = origReadFile;
+    (fs as any).access       = origAccessCb;
+    (fs as any).stat         = origStatCb;
+    (fs as any).readFile     = origReadFileCb;
+  };
+}
 
+/**
+ * Runs `fn` with the fs calls patched.
+ * `existsSet` is the set of paths that "exist" (accessSync / access / stat succeed for them).
+ * `pidMap` maps pid-file paths to their string contents.
+ *
+ * NOTE: requireLinux() must be called BEFORE withFsMock so that Node.js's
+ * module loader uses the real fs to read the .js file.
+ */
+async function withFsMock(
+  existsSet: Set<string>,
+  pidMap: Record<string, string>,
+  fn: () => unknown
+): Promise<void> {
+  const restore = installFsMock(existsSet, pidMap);
   try {
     await fn();
   } finally {
-    fs.accessSync        = origAccess;
-    (fs as any).readFileSync = origReadFile;
+    restore();
   }
 }
 
@@ -59,8 +96,8 @@ function requireLinux() {
 }
 
 /**
- * Runs `fn` with fs.accessSync, fs.readFileSync, and child_process.execSync patched.
- * `systemctlOutput` controls what execSync returns (or throws if null).
+ * Runs `fn` with the fs calls and child_process.execFileSync patched.
+ * `systemctlOutput` controls what execFileSync returns (or throws if null).
  */
 async function withFullMock(
   existsSet: Set<string>,
@@ -68,23 +105,9 @@ async function withFullMock(
   systemctlOutput: string | null,
   fn: () => unknown
 ): Promise<void> {
-  const origAccess   = fs.accessSync;
-  const origReadFile = fs.readFileSync;
+  const restore = installFsMock(existsSet, pidMap);
   const origExecFileSync = child_process.execFileSync;
 
-  fs.accessSync = (p: any) => {
-    if (existsSet.has(String(p))) return;
-    const err: any = new Error(`ENOENT: ${p}`);
-    err.code = 'ENOENT';
-    throw err;
-  };
-  (fs as any).readFileSync = (p: any, enc?: any) => {
-    const key = String(p);
-    if (key in pidMap) return pidMap[key];
-    const err: any = new Error(`ENOENT: ${p}`);
-    err.code = 'ENOENT';
-    throw err;
-  };
   (child_process as any).execFileSync = (_file: any, _args?: any, _opts?: any) => {
     if (systemctlOutput === null) {
       throw new Error('execFileSync mock: command not found');
@@ -95,8 +118,7 @@ async function withFullMock(
   try {
     await fn();
   } finally {
-    fs.accessSync = origAccess;
-    (fs as any).readFileSync = origReadFile;
+    restore();
     (child_process as any).execFileSync = origExecFileSync;
   }
 }
@@ -324,6 +346,36 @@ describe('Linux implementation — getServiceStatus (SysV)', () => {
   });
 });
 
+// ─── Record / replay ──────────────────────────────────────────────────────────
+
+describe('Linux implementation — record / replay', () => {
+  it('replays a recorded systemd session without touching the host', async () => {
+    const { recordTrace, replayTrace } = require('../src/trace');
+    const file = path.join(fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-trace-')), 'trace.ndjson');
+    const { getServiceStatus } = requireLinux();
+    let recorded: unknown;
+    const rec = recordTrace(file);
+    try {
+      await withFullMock(
+        new Set(['/run/systemd/private']),
+        {},
+        'LoadState=loaded\nActiveState=active\nSubState=running\nMainPID=1234\n',
+        async () => { recorded = await getServiceStatus('nginx'); }
+      );
+    } finally {
+      await rec.stop();
+    }
+
+    const replay = replayTrace(file, { timeScale: 0 });
+    try {
+      assert.deepEqual(await requireLinux().getServiceStatus('nginx'), recorded);
+    } finally {
+      await replay.stop();
+      fs.rmSync(path.dirname(file), { recursive: true, force: true });
+    }
+  });
+});
+
 // ─── TypeError guards ─────────────────────────────────────────────────────────
 
 describe('Linux implementation — TypeError guards', () => {
@@ -397,6 +449,40 @@ describe('Linux implementation — getServiceStatus (systemctl CLI fallback)', (
     );
   });
 
+  it('reports timer details for .timer units', async () => {
+    const { getServiceStatus } = requireLinux();
+    await withFullMock(
+      new Set(['/run/systemd/private']),
+      {},
+      'LoadState=loaded\nActiveState=active\nSubState=waiting\n' +
+      'NextElapseUSecRealtime=Mon 2026-10-19 00:00:00 UTC\nLastTriggerUSec=n/a\nUnit=logrotate.service\n',
+      async () => {
+        const status = await getServiceStatus('logrotate.timer');
+        assert.equal(status.type, 'timer');
+        assert.equal(status.state, 'RUNNING');
+        assert.deepEqual(status.timer, {
+          nextElapse:  Date.UTC(2026, 9, 19),
+          lastTrigger: null,
+          unit:        'logrotate.service'
+        });
+      }
+    );
+  });
+
+  it('reports socket counters for .socket units', async () => {
+    const { getServiceStatus } = requireLinux();
+    await withFullMock(
+      new Set(['/run/systemd/private']),
+      {},
+      'LoadState=loaded\nActiveState=active\nSubState=listening\nNConnections=2\nNAccepted=41\n',
+      async () => {
+        const status = await getServiceStatus('sshd.socket');
+        assert.equal(status.type, 'socket');
+        assert.deepEqual(status.socket, { connections: 2, accepted: 41 });
+      }
+    );
+  });
+
   it('falls through to SysV when systemctl reports not-found and /etc/init.d exists', async () => {
     const { getServiceStatus } = requireLinux();
     await withFullMock(
@@ -466,6 +552,76 @@ describe('Linux implementation — serviceExists (systemctl CLI fallback)', () =
   });
 });
 
+// ─── iterateServices — OpenRC / SysV ──────────────────────────────────────────
+
+/**
+ * Runs `fn` with fs.promises.opendir patched to list `names` as regular files.
+ */
+async function withInitDMock(names: string[], fn: () => unknown): Promise<void> {
+  const origOpendir = fs.promises.opendir;
+  (fs.promises as any).opendir = async (p: any) => {
+    assert.equal(String(p), '/etc/init.d');
+    return (async function* () {
+      for (const name of names) {
+        yield { name, isFile: () => true, isSymbolicLink: () => false };
+      }
+    })();
+  };
+  try {
+    await fn();
+  } finally {
+    (fs.promises as any).opendir = origOpendir;
+  }
+}
+
+async function collect<T>(source: AsyncIterable<T>): Promise<T[]> {
+  const out: T[] = [];
+  for await (const x of source) out.push(x);
+  return out;
+}
+
+describe('Linux implementation — iterateServices (OpenRC / SysV)', () => {
+  it('yields one status per /etc/init.d script, skipping helpers', async () => {
+    const { iterateServices } = requireLinux();
+    await withInitDMock(['cron', 'README', 'sshd', '.depend.boot'], () =>
+      withFsMock(
+        new Set(['/proc/5678']),
+        { '/var/run/cron.pid': '5678\n' },
+        async () => {
+          const list = await collect(iterateServices());
+          assert.deepEqual(list.map((s: any) => [s.name, s.state, s.pid]), [
+            ['cron', 'RUNNING', 5678],
+            ['sshd', 'STOPPED', 0]
+          ]);
+        }
+      )
+    );
+  });
+
+  it('filters by glob and state on OpenRC', async () => {
+    const { iterateServices } = requireLinux();
+    await withInitDMock(['nginx', 'php-fpm7', 'php-fpm8'], () =>
+      withFsMock(
+        new Set(['/run/openrc/softlevel', '/run/openrc/started/php-fpm8']),
+        {},
+        async () => {
+          const list = await collect(iterateServices({ patterns: ['php*'], states: ['RUNNING'] }));
+          assert.deepEqual(list.map((s: any) => s.name), ['php-fpm8']);
+        }
+      )
+    );
+  });
+
+  it('yields nothing for non-service unit types', async () => {
+    const { iterateServices } = requireLinux();
+    await withInitDMock(['nginx'], () =>
+      withFsMock(new Set(['/run/openrc/softlevel']), {}, async () => {
+        assert.deepEqual(await collect(iterateServices({ types: ['timer'] })), []);
+      })
+    );
+  });
+});
+
 // ─── index.ts — module contract ───────────────────────────────────────────────
 
 describe('index.ts — module contract', () => {
@@ -474,5 +630,27 @@ describe('index.ts — module contract', () => {
     const api = require('../index');
     assert.equal(typeof api.serviceExists, 'function');
     assert.equal(typeof api.getServiceStatus, 'function');
+    assert.equal(typeof api.iterateServices, 'function');
+    assert.equal(typeof api.getServiceStatuses, 'function');
+    assert.equal(typeof api.pollServices, 'function');
+    assert.equal(typeof api.setPollBudget, 'function');
+  });
+
+  it('getServiceStatuses reports failures inline, in order', async () => {
+    delete require.cache[require.resolve('../index')];
+    requireLinux();
+    const api = require('../index');
+    await withFsMock(
+      new Set(['/etc/init.d/cron', '/proc/5678']),
+      { '/var/run/cron.pid': '5678\n' },
+      async () => {
+        const results = await api.getServiceStatuses(['cron', 'ghost']);
+        assert.equal(results[0].state, 'RUNNING');
+        assert.equal(results[1].name, 'ghost');
+        assert.equal(results[1].exists, false);
+        assert.match(results[1].error, /does not exist/);
+        assert.equal(api.getSchedulerStats().queued, 0);
+      }
+    );
   });
 });
@@ -0,0 +1,169 @@
+'use strict';
+
+/**
+ * Tests for the stuck-transition detector (src/stuck.ts), with a scripted
+ * status query and short budgets.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { ServiceStatus } from '../src/types';
+import { StuckDetector, StuckTransition, watchStuckTransitions } from '../src/stuck';
+import { timespanToMs } from '../src/linux';
+
+const status = (state: string, extra: Partial<ServiceStatus> = {}): ServiceStatus =>
+  ({ name: 'api', exists: true, state, pid: 0, rawCode: state, ...extra });
+
+const sleep = (ms: number) => new Promise(resolve => setTimeout(resolve, ms));
+
+describe('stuck — StuckDetector', () => {
+  it('reports a transition that outlives its budget, once', async () => {
+    const stuck: StuckTransition[] = [];
+    const detector = new StuckDetector(s => stuck.push(s), {
+      budgets: { api: 30 }, grace: 0, query: async () => status('START_PENDING')
+    });
+    try {
+      detector.observe({ name: 'api', previous: status('STOPPED'), current: status('START_PENDING'), timestamp: Date.now() });
+      assert.equal(detector.pending, 1);
+      await sleep(80);
+      assert.equal(stuck.length, 1);
+      assert.equal(stuck[0].state, 'START_PENDING');
+      assert.equal(stuck[0].budget, 30);
+      assert.equal(stuck[0].budgetSource, 'service');
+      assert.ok(stuck[0].elapsed >= 30);
+
+      // Still pending at the next poll: the same transition is not timed again.
+      detector.observe({ name: 'api', previous: null, current: status('START_PENDING'), timestamp: Date.now() });
+      assert.equal(detector.pending, 0);
+    } finally {
+      detector.close();
+    }
+  });
+
+  it('disarms when the transition completes in time', async () => {
+    const stuck: StuckTransition[] = [];
+    const detector = new StuckDetector(s => stuck.push(s), { budget: 30, grace: 0, query: async () => status('RUNNING') });
+    try {
+      detector.observe({ name: 'api', previous: null, current: status('STOP_PENDING'), timestamp: Date.now() });
+      detector.observe({ name: 'api', previous: null, current: status('STOPPED'), timestamp: Date.now() });
+      assert.equal(detector.pending, 0);
+      await sleep(60);
+      assert.equal(stuck.length, 0);
+    } finally {
+      detector.close();
+    }
+  });
+
+  it('does not report when the confirming query finds the transition over', async () => {
+    const stuck: StuckTransition[] = [];
+    const detector = new StuckDetector(s => stuck.push(s), { budget: 20, grace: 0, query: async () => status('RUNNING') });
+    try {
+      detector.observe({ name: 'api', previous: null, current: status('START_PENDING'), timestamp: Date.now() });
+      await sleep(60);
+      assert.equal(stuck.length, 0);
+      assert.equal(detector.pending, 0);
+    } finally {
+      detector.close();
+    }
+  });
+
+  it('times a new transition when the systemd timestamp changes', async () => {
+    const stuck: StuckTransition[] = [];
+    const ts = (inactiveExit: number) => ({ timestamps: { inactiveExit, activeEnter: 0, activeExit: 0, inactiveEnter: 0 } });
+    const now = Number(process.hrtime.bigint() / 1000n);
+    const detector = new StuckDetector(s => stuck.push(s), {
+      budget: 10_000, grace: 0, query: async () => status('START_PENDING', ts(now - 20_000_000))
+    });
+    try {
+      // Began 20 s ago according to systemd: already past the 10 s budget.
+      detector.observe({ name: 'api', previous: null, current: status('START_PENDING', ts(now - 20_000_000)), timestamp: Date.now() });
+      await sleep(30);
+      assert.equal(stuck.length, 1);
+      assert.ok(stuck[0].elapsed >= 19_000);
+
+      detector.observe({ name: 'api', previous: null, current: status('START_PENDING', ts(now)), timestamp: Date.now() });
+      assert.equal(detector.pending, 1, 'a restarted activation is timed afresh');
+    } finally {
+      detector.close();
+    }
+  });
+});
+
+describe('stuck — unit timeouts', () => {
+  it('parses systemd time spans from D-Bus and systemctl', () => {
+    assert.equal(timespanToMs(90_000_000), 90_000);
+    assert.equal(timespanToMs('90000000'), 90_000);
+    assert.equal(timespanToMs('1min 30s'), 90_000);
+    assert.equal(timespanToMs('1h 5min 250ms'), 3_900_250);
+    assert.equal(timespanToMs('500us'), 0.5);
+    assert.equal(timespanToMs('infinity'), null);
+    assert.equal(timespanToMs(0), null);
+    assert.equal(timespanToMs(2n ** 64n - 1n), null);
+    assert.equal(timespanToMs('1 fortnight'), null);
+  });
+
+  it('uses an injected unit timeout before the default budget', async () => {
+    const stuck: StuckTransition[] = [];
+    const detector = new StuckDetector(s => stuck.push(s), {
+      budget: 10_000, grace: 0, query: async () => status('START_PENDING'),
+      unitTimeout: (_name, state) => (state === 'START_PENDING' ? 20 : null)
+    });
+    try {
+      detector.observe({ name: 'api', previous: null, current: status('START_PENDING'), timestamp: Date.now() });
+      await sleep(60);
+      assert.equal(stuck.length, 1);
+      assert.equal(stuck[0].budget, 20);
+      assert.equal(stuck[0].budgetSource, 'unit');
+    } finally {
+      detector.close();
+    }
+  });
+});
+
+describe('stuck — watchStuckTransitions', () => {
+  it('times services already pending when watching starts', async () => {
+    const stuck: StuckTransition[] = [];
+    const watcher = watchStuckTransitions(['api'], s => stuck.push(s), {
+      budget: 30, grace: 0, query: async () => status('STOP_PENDING'), source: 'poll', poll: { minInterval: 1000 }
+    });
+    try {
+      await sleep(100);
+      assert.equal(stuck.length, 1);
+      assert.equal(stuck[0].state, 'STOP_PENDING');
+    } finally {
+      watcher.close();
+    }
+  });
+
+  it('re-queries on OpenRC state-directory events, without polling', async () => {
+    const root = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-stuck-'));
+    for (const dir of ['openrc/starting', 'openrc/stopping', 'run']) fs.mkdirSync(path.join(root, dir), { recursive: true });
+    let queries = 0;
+    const query = async () => {
+      queries++;
+      return status(fs.existsSync(path.join(root, 'openrc/starting/api')) ? 'START_PENDING' : 'STOPPED');
+    };
+    const stuck: StuckTransition[] = [];
+    const watcher = watchStuckTransitions(['api'], s => stuck.push(s), {
+      budget: 50, grace: 0, query, dirs: [path.join(root, 'run')], openrcDir: path.join(root, 'openrc')
+    });
+    try {
+      await sleep(100);
+      assert.deepEqual(stuck, []);
+      const idle = queries;
+      await sleep(300);
+      assert.equal(queries, idle);
+
+      fs.writeFileSync(path.join(root, 'openrc/starting/api'), '');
+      await sleep(200);
+      assert.equal(stuck.length, 1);
+      assert.equal(stuck[0].state, 'START_PENDING');
+    } finally {
+      watcher.close();
+      fs.rmSync(root, { recursive: true, force: true });
+    }
+  });
+});
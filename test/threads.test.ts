@@ -0,0 +1,83 @@
+'use strict';
+
+/**
+ * Tests for the per-thread CPU sampler (src/threads.ts), on this process.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { spawn } from 'child_process';
+import { parseTaskStat, ThreadSampler, getServiceThreads, serviceCgroup } from '../src/threads';
+import { ServiceStatus } from '../src/types';
+
+const skip = process.platform !== 'linux' ? 'Linux only' : false;
+
+describe('threads — parseTaskStat', () => {
+  it('counts fields from the last parenthesis', () => {
+    const rest = Array.from({ length: 50 }, (_, i) => String(i));
+    rest[0] = 'R';          // state
+    rest[1] = '1';          // ppid
+    rest[11] = '250';       // utime
+    rest[12] = '50';        // stime
+    rest[36] = '3';         // processor
+    const stat = parseTaskStat(`4321 (my (odd) name) ${rest.join(' ')}`);
+    assert.deepEqual(stat, { name: 'my (odd) name', state: 'R', ppid: 1, ticks: 300, processor: 3 });
+  });
+
+  it('rejects truncated lines', () => {
+    assert.equal(parseTaskStat('4321 (sh) S 1'), null);
+  });
+});
+
+describe('threads — ThreadSampler', () => {
+  it('reports CPU deltas per thread between ticks', { skip }, async () => {
+    const sampler = new ThreadSampler();
+    const first = await sampler.sample([process.pid]);
+    assert.equal(first.interval, 0);
+    assert.ok(first.threads.some(t => t.tid === process.pid));
+    assert.ok(first.threads.every(t => t.cpu === 0));
+
+    const until = Date.now() + 300;
+    while (Date.now() < until) { /* keep the main thread busy */ }
+
+    const second = await sampler.sample([process.pid]);
+    assert.ok(second.interval >= 300);
+    const main = second.threads.find(t => t.tid === process.pid)!;
+    assert.equal(main.pid, process.pid);
+    assert.ok(main.cpu > 0.5, `main thread cpu ${main.cpu}`);
+    assert.ok(main.cpuTime > 0);
+  });
+});
+
+describe('threads — getServiceThreads', () => {
+  const running = (pid: number) => async (name: string): Promise<ServiceStatus> =>
+    ({ name, exists: true, state: 'RUNNING', pid, rawCode: 'active' });
+
+  it('queues concurrent calls for one service behind each other', { skip }, async () => {
+    const options = { primeInterval: 150, query: running(process.pid) };
+    const [first, second] = await Promise.all([
+      getServiceThreads('queued', options),
+      getServiceThreads('queued', options)
+    ]);
+    // Only the first call primes; the second measures from its tick.
+    assert.ok(first.interval >= 150, `first interval ${first.interval}`);
+    assert.ok(second.interval < 150, `second interval ${second.interval}`);
+    assert.ok(second.threads.some(t => t.tid === process.pid));
+  });
+
+  it('starts over when the main PID changes', { skip }, async () => {
+    const child = spawn('sleep', ['30'], { stdio: 'ignore' });
+    try {
+      await getServiceThreads('restarted', { primeInterval: 50, query: running(process.pid) });
+      const restarted = await getServiceThreads('restarted', { primeInterval: 150, query: running(child.pid!) });
+      assert.ok(restarted.interval >= 150, `interval ${restarted.interval}`);
+      const pids = new Set(restarted.threads.map(t => t.pid));
+      assert.ok(pids.has(child.pid!), 'new main PID sampled');
+      // A runner in a `*.service` cgroup shares it with the child, and the
+      // whole cgroup.procs is sampled; otherwise only the child's tree is.
+      if (!(await serviceCgroup(child.pid!))) assert.ok(!pids.has(process.pid), 'old main PID dropped');
+    } finally {
+      child.kill('SIGKILL');
+    }
+  });
+});
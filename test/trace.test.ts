@@ -0,0 +1,89 @@
+'use strict';
+
+/**
+ * Tests for backend record and replay (src/trace.ts).
+ */
+
+import { describe, it, before, after } from 'node:test';
+import * as assert from 'node:assert/strict';
+import fs from 'fs';
+import os from 'os';
+import path from 'path';
+import { recordTrace, replayTrace, traceSync, traceAsync, tracing } from '../src/trace';
+
+describe('trace — record and replay', () => {
+  let dir = '';
+
+  before(() => {
+    dir = fs.mkdtempSync(path.join(os.tmpdir(), 'service_api-trace-'));
+  });
+
+  after(() => {
+    fs.rmSync(dir, { recursive: true, force: true });
+  });
+
+  it('runs live operations when no session is active', async () => {
+    assert.equal(tracing(), false);
+    assert.equal(traceSync('op', [], () => 1), 1);
+    assert.equal(await traceAsync('op', [], async () => 2), 2);
+  });
+
+  it('replays results and errors in recorded order', async () => {
+    const file = path.join(dir, 'order.ndjson');
+    const rec = recordTrace(file);
+    let n = 0;
+    traceSync('dbus.unit', ['nginx'], () => ({ activeState: 'activating' }));
+    traceSync('dbus.unit', ['nginx'], () => ({ activeState: 'active' }));
+    await traceAsync('fs.read', ['/run/nginx.pid'], async () => '88\n');
+    assert.throws(() => traceSync('systemctl.show', ['ghost.service'], () => { throw new Error('exit 4'); }), /exit 4/);
+    await rec.stop();
+
+    const replay = replayTrace(file, { timeScale: 0 });
+    try {
+      const live = () => { n++; return null; };
+      assert.deepEqual(traceSync('dbus.unit', ['nginx'], live), { activeState: 'activating' });
+      assert.deepEqual(traceSync('dbus.unit', ['nginx'], live), { activeState: 'active' });
+      // the last result repeats once the recorded ones are used up
+      assert.deepEqual(traceSync('dbus.unit', ['nginx'], live), { activeState: 'active' });
+      assert.equal(await traceAsync('fs.read', ['/run/nginx.pid'], async () => null), '88\n');
+      assert.throws(() => traceSync('systemctl.show', ['ghost.service'], live), /exit 4/);
+      assert.throws(() => traceSync('dbus.unit', ['sshd'], live), /no recorded dbus\.unit/);
+      assert.equal(n, 0);
+    } finally {
+      await replay.stop();
+    }
+  });
+
+  it('scales recorded latency', async () => {
+    const file = path.join(dir, 'slow.ndjson');
+    fs.writeFileSync(file, [
+      JSON.stringify({ trace: 'service_api', version: 1, start: 0 }),
+      JSON.stringify({ t: 0, op: 'dbus.unit', args: ['nginx'], ms: 20, result: 'slow' }),
+      JSON.stringify({ t: 0, op: 'fs.exists', args: ['/etc/init.d/cron'], ms: 20, result: true })
+    ].join('\n'));
+
+    const replay = replayTrace(file, { timeScale: 2 });
+    try {
+      let t = performance.now();
+      assert.equal(traceSync('dbus.unit', ['nginx'], () => 'live'), 'slow');
+      assert.ok(performance.now() - t >= 39, 'sync replay blocks for the scaled duration');
+      t = performance.now();
+      assert.equal(await traceAsync('fs.exists', ['/etc/init.d/cron'], async () => false), true);
+      assert.ok(performance.now() - t >= 38);
+    } finally {
+      await replay.stop();
+    }
+  });
+
+  it('allows one session at a time and rejects foreign files', async () => {
+    const file = path.join(dir, 'busy.ndjson');
+    const rec = recordTrace(file);
+    try {
+      assert.throws(() => recordTrace(path.join(dir, 'other.ndjson')), /already active/);
+    } finally {
+      await rec.stop();
+    }
+    fs.writeFileSync(path.join(dir, 'foreign.ndjson'), '{"hello":1}\n');
+    assert.throws(() => replayTrace(path.join(dir, 'foreign.ndjson')), /not a service_api trace/);
+  });
+});
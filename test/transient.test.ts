@@ -0,0 +1,76 @@
+'use strict';
+
+/**
+ * Tests for transient unit marshalling (src/transient.ts). The live test
+ * starts a unit through systemd and needs root; it is skipped elsewhere.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { transientProperties, resolveCommand, runTransient } from '../src/transient';
+import { systemdSkipReason } from './live';
+
+describe('transient — transientProperties', () => {
+  it('marshals known properties with their signatures, ExecStart last', () => {
+    const props = transientProperties(['/usr/bin/env', 'true'], {
+      Slice: 'batch.slice',
+      MemoryMax: 256 * 1024 * 1024,
+      TasksMax: 'infinity',
+      Environment: { MODE: 'batch', N: 3 }
+    });
+    assert.deepEqual(props, [
+      ['Slice', ['s', 'batch.slice']],
+      ['MemoryMax', ['t', 268435456]],
+      ['TasksMax', ['t', 2n ** 64n - 1n]],
+      ['Environment', ['as', ['MODE=batch', 'N=3']]],
+      ['Description', ['s', '/usr/bin/env true']],
+      ['ExecStart', ['a(sbas)', [['/usr/bin/env', false, ['/usr/bin/env', 'true']]]]]
+    ]);
+  });
+
+  it('takes [signature, value] pairs for other properties', () => {
+    const props = transientProperties(['/bin/true'], {
+      Description: 'job 42',
+      LimitNOFILE: ['t', 4096],
+      Environment: ['A=1']
+    });
+    assert.deepEqual(props.slice(0, 3), [
+      ['Description', ['s', 'job 42']],
+      ['LimitNOFILE', ['t', 4096]],
+      ['Environment', ['as', ['A=1']]]
+    ]);
+    assert.equal(props.filter(([name]) => name === 'Description').length, 1);
+    assert.throws(() => transientProperties(['/bin/true'], { LimitNOFILE: 4096 }), TypeError);
+    assert.throws(() => transientProperties(['/bin/true'], { ExecStart: ['a(sbas)', []] }), TypeError);
+  });
+
+  it('rejects an empty command', async () => {
+    assert.throws(() => transientProperties([]), TypeError);
+    await assert.rejects(runTransient({ command: [] }), TypeError);
+  });
+});
+
+describe('transient — resolveCommand', () => {
+  it('searches PATH for bare names and resolves paths', () => {
+    assert.equal(resolveCommand('sh', '/nonexistent:/bin'), '/bin/sh');
+    assert.equal(resolveCommand('./x', ''), `${process.cwd()}/x`);
+    assert.throws(() => resolveCommand('no-such-command-here', '/nonexistent'), /not found/);
+  });
+});
+
+// ─── Live (systemd) ───────────────────────────────────────────────────────────
+
+describe('transient — runTransient (live, systemd)', () => {
+  const skip = systemdSkipReason();
+
+  it('runs a oneshot command to completion', { skip }, async () => {
+    const run = await runTransient({
+      name: `service-api-test-${process.pid}`,
+      command: ['/bin/true'],
+      properties: { Type: 'oneshot' }
+    });
+    assert.equal(run.unit, `service-api-test-${process.pid}.service`);
+    assert.match(run.job, /^\/org\/freedesktop\/systemd1\/job\//);
+    assert.equal(run.result, 'done');
+  });
+});
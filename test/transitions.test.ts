@@ -0,0 +1,78 @@
+'use strict';
+
+/**
+ * Tests for transition-duration analytics (src/transitions.ts).
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { ServiceStatus, ServiceChange, UnitTimestamps } from '../src/types';
+import { TransitionTracker } from '../src/transitions';
+
+// ─── Helpers ──────────────────────────────────────────────────────────────────
+
+function status(state: string, timestamps?: UnitTimestamps): ServiceStatus {
+  const s: ServiceStatus = { name: 'nginx', exists: true, state, pid: 0, rawCode: state.toLowerCase() };
+  if (timestamps) s.timestamps = timestamps;
+  return s;
+}
+
+/** Feeds `states` as successive changes of "nginx", at the given ms times. */
+function feed(tracker: TransitionTracker, steps: Array<[number, string]>): void {
+  let previous: ServiceStatus | null = null;
+  for (const [timestamp, state] of steps) {
+    const current = status(state);
+    const change: ServiceChange = { name: 'nginx', previous, current, timestamp };
+    tracker.observe(change);
+    previous = current;
+  }
+}
+
+// ─── From change events ───────────────────────────────────────────────────────
+
+describe('transitions — from change events', () => {
+  it('measures start, stop and restart-to-ready', () => {
+    const tracker = new TransitionTracker();
+    feed(tracker, [
+      [0, 'STOPPED'],
+      [1000, 'START_PENDING'], [1250, 'RUNNING'],              // start 250 ms
+      [5000, 'STOP_PENDING'], [5100, 'STOPPED'],               // stop 100 ms
+      [5200, 'START_PENDING'], [5600, 'RUNNING']               // start 400 ms, restart 600 ms
+    ]);
+    const { services, all } = tracker.stats();
+    assert.equal(services.nginx.start.count, 2);
+    assert.equal(services.nginx.start.min, 250);
+    assert.equal(services.nginx.start.max, 400);
+    assert.equal(services.nginx.stop.count, 1);
+    assert.equal(services.nginx.stop.p50, 100);
+    assert.equal(services.nginx.restart.count, 1);
+    assert.equal(services.nginx.restart.p50, 600);
+    assert.equal(all.start.count, 2);
+  });
+
+  it('does not count a stop followed by a late start as a restart', () => {
+    const tracker = new TransitionTracker({ restartWindow: 1000 });
+    feed(tracker, [[0, 'RUNNING'], [10, 'STOPPED'], [60_000, 'RUNNING']]);
+    assert.equal(tracker.stats().services.nginx.restart.count, 0);
+  });
+});
+
+// ─── From systemd timestamps ──────────────────────────────────────────────────
+
+describe('transitions — from systemd timestamps', () => {
+  it('uses µs transition times once per transition', () => {
+    const tracker = new TransitionTracker();
+    // restart: active exit at 10 s, inactive at 10.05 s, activating at 10.06 s, active at 10.5625 s
+    const ts = { activeExit: 10_000_000, inactiveEnter: 10_050_000, inactiveExit: 10_060_000, activeEnter: 10_562_500 };
+    const current = status('RUNNING', ts);
+    for (let i = 0; i < 3; i++) {
+      tracker.observe({ name: 'nginx', previous: current, current, timestamp: i });  // repeated polls
+    }
+    const { services } = tracker.stats();
+    assert.equal(services.nginx.start.count, 1);
+    assert.equal(services.nginx.start.min, 502.5);
+    assert.equal(services.nginx.stop.min, 50);
+    assert.equal(services.nginx.restart.count, 1);
+    assert.equal(services.nginx.restart.min, 562.5);
+  });
+});
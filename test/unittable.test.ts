@@ -0,0 +1,83 @@
+'use strict';
+
+/**
+ * Tests for the indexed unit table (src/unittable.ts), on rows inserted
+ * directly.
+ */
+
+import { describe, it } from 'node:test';
+import * as assert from 'node:assert/strict';
+import { UnitTable, UnitRecord } from '../src/unittable';
+
+function unit(name: string, fields: Partial<UnitRecord> = {}): UnitRecord {
+  return {
+    name, type: 'service', state: 'RUNNING', activeState: 'active', slice: 'system.slice',
+    unitFileState: 'enabled', restarts: 0, pid: 100, ...fields
+  };
+}
+
+function table(): UnitTable {
+  const t = new UnitTable();
+  t.upsert(unit('api', { slice: 'app.slice', state: 'STOPPED', activeState: 'failed', restarts: 5, pid: 0 }));
+  t.upsert(unit('worker', { slice: 'app.slice' }));
+  t.upsert(unit('cron', { state: 'STOPPED', activeState: 'inactive', pid: 0 }));
+  t.upsert(unit('backup.timer', { type: 'timer', unitFileState: 'enabled', pid: 0 }));
+  t.upsert(unit('sshd', { unitFileState: 'static', restarts: 1 }));
+  return t;
+}
+
+const names = (rows: UnitRecord[]) => rows.map(r => r.name);
+
+describe('unittable — queries', () => {
+  it('combines indexed constraints', () => {
+    const t = table();
+    assert.deepEqual(names(t.query({ slice: 'app.slice', activeState: 'failed' })), ['api']);
+    assert.deepEqual(names(t.query({ unitFileState: 'enabled', state: 'STOPPED', type: 'service' })), ['api', 'cron']);
+    assert.deepEqual(names(t.query({ minRestarts: 3 })), ['api']);
+    assert.deepEqual(names(t.query({ minRestarts: 1, slice: 'system.slice' })), ['sshd']);
+  });
+
+  it('accepts lists of values and residual predicates', () => {
+    const t = table();
+    assert.deepEqual(names(t.query({ unitFileState: ['static', 'disabled'] })), ['sshd']);
+    assert.deepEqual(names(t.query({ type: 'service', where: u => u.name.startsWith('c') })), ['cron']);
+    assert.deepEqual(names(t.query({ slice: 'nope.slice' })), []);
+    assert.equal(t.query().length, 5);
+  });
+
+  it('moves index entries on update and delete', () => {
+    const t = table();
+    t.upsert(unit('api', { slice: 'app.slice', restarts: 6 }));
+    assert.deepEqual(names(t.query({ activeState: 'failed' })), []);
+    assert.deepEqual(names(t.query({ slice: 'app.slice', state: 'RUNNING' })), ['api', 'worker']);
+    assert.deepEqual(names(t.query({ minRestarts: 6 })), ['api']);
+
+    assert.equal(t.delete('worker'), true);
+    assert.deepEqual(names(t.query({ slice: 'app.slice' })), ['api']);
+    assert.equal(t.size, 4);
+  });
+
+  it('applies watcher changes once loaded', () => {
+    const t = table();
+    const current = { name: 'cron', exists: true, state: 'RUNNING', pid: 42, rawCode: 'active' };
+    t.observe({ name: 'cron', previous: null, current, timestamp: Date.now() });
+    assert.equal(t.get('cron')!.state, 'STOPPED', 'ignored before load()');
+
+    (t as any).loadedAt = Date.now();
+    t.observe({ name: 'cron', previous: null, current, timestamp: Date.now() });
+    assert.deepEqual(names(t.query({ state: 'RUNNING', unitFileState: 'enabled', type: 'service' })), ['cron', 'worker']);
+    assert.equal(t.get('cron')!.pid, 42);
+    t.clear();
+  });
+
+  it('applies changes named by unit to the listed row', () => {
+    const t = table();
+    (t as any).loadedAt = Date.now();
+    const current = { name: 'sshd.service', exists: true, state: 'STOPPED', pid: 0, rawCode: 'inactive' };
+    t.observe({ name: 'sshd.service', previous: null, current, timestamp: Date.now() });
+    assert.equal(t.size, 5);
+    assert.equal(t.get('sshd')!.state, 'STOPPED');
+    assert.equal(t.get('sshd')!.unitFileState, 'static');
+    t.clear();
+  });
+});